@@ -0,0 +1,167 @@
+#include "LCD_Anim.h"
+#include <string.h>
+#include "stm32f4xx_hal.h" // For HAL_GetTick. Replace with stm32f1xx_hal.h or whatever hardware you're using
+
+#define LCD_ANIM_ROWS (LCD_ANIM_MAX * 8) // CGRAM bytes
+
+static uint32_t lcd_animNowUs(const LCD_Animator *an)
+{
+    if (an->clock.now_us != NULL) {
+        return an->clock.now_us(an->clock.ctx);
+    }
+    return HAL_GetTick() * 1000;
+}
+
+// Send the rows of every animated slot that differ from what CGRAM holds, in one
+// pass in address order: runs of changed rows, each behind one address command.
+// moved: slots that went to another frame, for the statistics.
+static void lcd_animSend(LCD_Animator *an, uint8_t moved)
+{
+    uint8_t image[LCD_ANIM_ROWS];
+    uint8_t dirty[LCD_ANIM_ROWS];
+    bool any = false;
+
+    for (uint8_t slot = 0; slot < LCD_ANIM_MAX; slot++) {
+        const LCD_AnimTrack *t = &an->track[slot];
+        memset(&dirty[slot * 8], 0, 8);
+        if (t->count == 0) continue;
+
+        const uint8_t *bitmap = t->frames[t->frame];
+        bool stale = an->stale & (1 << slot);
+        for (uint8_t r = 0; r < 8; r++) {
+            uint8_t row = bitmap[r] & 0x1F;
+            image[slot * 8 + r] = row;
+            if (stale || an->shown[slot][r] != row) {
+                dirty[slot * 8 + r] = 1;
+                an->shown[slot][r] = row;
+                any = true;
+            } else if (moved & (1 << slot)) {
+                an->stats.rows_same++;
+            }
+        }
+        an->stale &= ~(1 << slot);
+    }
+    if (!any) return;
+
+    LCD_BeginCGRAM(an->lcd);
+    for (uint8_t addr = 0; addr < LCD_ANIM_ROWS; ) {
+        if (!dirty[addr]) {
+            addr++;
+            continue;
+        }
+        uint8_t end = addr;
+        while (end < LCD_ANIM_ROWS && dirty[end]) end++;
+        LCD_WriteCGRAM(an->lcd, addr >> 3, addr & 7, &image[addr], end - addr);
+        an->stats.rows_written += end - addr;
+        an->stats.addr_sets++;
+        addr = end;
+    }
+    LCD_EndCGRAM(an->lcd);
+}
+
+void LCD_AnimInit(LCD_Animator *an, LiquidCrystal_C *lcd, const LCD_Clock *clock)
+{
+    memset(an, 0, sizeof(*an));
+    an->lcd = lcd;
+    if (clock != NULL) {
+        an->clock = *clock;
+    }
+    an->stale = 0xFF;
+}
+
+bool LCD_AnimAdd(LCD_Animator *an, uint8_t slot, const uint8_t (*frames)[8], uint8_t count, uint16_t hz)
+{
+    if (slot >= LCD_ANIM_MAX || frames == NULL || count == 0) return false;
+
+    LCD_AnimTrack *t = &an->track[slot];
+    t->frames = frames;
+    t->count = count;
+    t->frame = 0;
+    t->running = true;
+    LCD_AnimSetRate(an, slot, hz);
+    lcd_animSend(an, 1 << slot);
+    return true;
+}
+
+void LCD_AnimRemove(LCD_Animator *an, uint8_t slot)
+{
+    if (slot >= LCD_ANIM_MAX) return;
+    an->track[slot].count = 0;
+    // Whatever goes into the slot next doesn't come from here
+    an->stale |= 1 << slot;
+}
+
+void LCD_AnimStop(LCD_Animator *an, uint8_t slot)
+{
+    if (slot >= LCD_ANIM_MAX) return;
+    an->track[slot].running = false;
+}
+
+void LCD_AnimStart(LCD_Animator *an, uint8_t slot)
+{
+    if (slot >= LCD_ANIM_MAX || an->track[slot].running) return;
+    an->track[slot].running = true;
+    an->track[slot].next_us = lcd_animNowUs(an) + an->track[slot].period_us;
+}
+
+void LCD_AnimSetRate(LCD_Animator *an, uint8_t slot, uint16_t hz)
+{
+    if (slot >= LCD_ANIM_MAX) return;
+    LCD_AnimTrack *t = &an->track[slot];
+    // 0 Hz holds the frame, like LCD_AnimStop()
+    t->period_us = (hz != 0) ? 1000000 / hz : 0;
+    t->next_us = lcd_animNowUs(an) + t->period_us;
+}
+
+void LCD_AnimSetFrame(LCD_Animator *an, uint8_t slot, uint8_t frame)
+{
+    if (slot >= LCD_ANIM_MAX || an->track[slot].count == 0) return;
+    LCD_AnimTrack *t = &an->track[slot];
+    t->frame = frame % t->count;
+    t->next_us = lcd_animNowUs(an) + t->period_us;
+}
+
+uint8_t LCD_AnimTick(LCD_Animator *an)
+{
+    uint32_t now = lcd_animNowUs(an);
+    uint8_t moved = 0;
+    uint8_t count = 0;
+
+    for (uint8_t slot = 0; slot < LCD_ANIM_MAX; slot++) {
+        LCD_AnimTrack *t = &an->track[slot];
+        if (t->count == 0 || !t->running || t->period_us == 0) continue;
+        int32_t late = (int32_t)(now - t->next_us);
+        if (late < 0) continue;
+
+        // Keep the cadence: frames whose time has passed as well are skipped
+        uint32_t steps = 1 + (uint32_t)late / t->period_us;
+        t->frame = (uint8_t)((t->frame + steps) % t->count);
+        t->next_us += steps * t->period_us;
+        an->stats.frames++;
+        an->stats.skipped += steps - 1;
+        moved |= 1 << slot;
+        count++;
+    }
+    if (count != 0) {
+        an->stats.ticks++;
+    }
+    // Frames set with LCD_AnimSetFrame() go out here too
+    lcd_animSend(an, moved);
+    return count;
+}
+
+void LCD_AnimInvalidate(LCD_Animator *an)
+{
+    an->stale = 0xFF;
+    lcd_animSend(an, 0);
+}
+
+void LCD_AnimGetStats(const LCD_Animator *an, LCD_AnimStats *stats)
+{
+    *stats = an->stats;
+}
+
+void LCD_AnimResetStats(LCD_Animator *an)
+{
+    memset(&an->stats, 0, sizeof(an->stats));
+}
@@ -0,0 +1,76 @@
+#ifndef LCD_ANIM_H
+#define LCD_ANIM_H
+
+#include "LiquidCrystal_C.h"
+
+/******************************************************************************
+ * CGRAM glyph animation
+ *
+ * Animates custom characters by rewriting their bitmap instead of the cells
+ * showing them: every cell on screen drawn with an animated slot's character
+ * code changes with it, whatever their number, at no DDRAM cost. Each
+ * animation owns one CGRAM slot and runs through its frames at its own rate.
+ * LCD_AnimTick() advances every animation that is due and rewrites only the
+ * CGRAM rows that differ from what the slots hold, all due animations in one
+ * pass over CGRAM, with the cursor put back once at the end.
+ *
+ * Slots given to animations are not for the glyph cache (LCD_Glyph.h) or
+ * LCD_CreateChar(). Frames are read from where they are given, so keep them
+ * (const tables in flash are fine) as long as the animation exists.
+ ******************************************************************************/
+#define LCD_ANIM_MAX 8 // one animation per CGRAM slot
+
+typedef struct {
+    uint32_t ticks;        // ticks that advanced at least one animation
+    uint32_t frames;       // frames shown, over all animations
+    uint32_t skipped;      // frames passed over because ticks came too late
+    uint32_t rows_written; // CGRAM rows sent
+    uint32_t rows_same;    // rows left alone because the new frame has them too
+    uint32_t addr_sets;    // CGRAM address runs started
+} LCD_AnimStats;
+
+typedef struct {
+    const uint8_t (*frames)[8];
+    uint8_t count;        // frames in the sequence, 0 = slot not animated
+    uint8_t frame;        // frame shown
+    bool running;
+    uint32_t period_us;
+    uint32_t next_us;     // when the next frame is due
+} LCD_AnimTrack;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    LCD_Clock clock;                      // all NULL = HAL tick
+    LCD_AnimTrack track[LCD_ANIM_MAX];    // one per CGRAM slot
+    uint8_t shown[LCD_ANIM_MAX][8];       // bitmap each animated slot holds
+    uint8_t stale;                        // slots whose CGRAM content isn't known
+    LCD_AnimStats stats;
+} LCD_Animator;
+
+// The display must have been started with LCD_Begin(). clock NULL uses the 1 ms HAL tick.
+void LCD_AnimInit(LCD_Animator *an, LiquidCrystal_C *lcd, const LCD_Clock *clock);
+// Animate CGRAM slot (0..7) through count frames at hz frames per second, starting
+// with frames[0], which is uploaded now. Replaces any animation on the slot. Draw the
+// slot's character code (the slot number) wherever the animation should show.
+bool LCD_AnimAdd(LCD_Animator *an, uint8_t slot, const uint8_t (*frames)[8], uint8_t count, uint16_t hz);
+// Give the slot back: it keeps the frame it shows
+void LCD_AnimRemove(LCD_Animator *an, uint8_t slot);
+// Hold an animation on its current frame, and let it run again from there
+void LCD_AnimStop(LCD_Animator *an, uint8_t slot);
+void LCD_AnimStart(LCD_Animator *an, uint8_t slot);
+void LCD_AnimSetRate(LCD_Animator *an, uint8_t slot, uint16_t hz);
+// Show a given frame at the next tick (e.g. an alarm icon's "off" frame)
+void LCD_AnimSetFrame(LCD_Animator *an, uint8_t slot, uint8_t frame);
+
+// Advance every animation that is due and send the changed rows. Call it from the
+// main loop or a timer, at least as often as the fastest frame rate. Returns the
+// number of animations that moved to another frame.
+uint8_t LCD_AnimTick(LCD_Animator *an);
+// Send every animated slot's current frame again, e.g. after LCD_BeginWarm() or a
+// display power cycle
+void LCD_AnimInvalidate(LCD_Animator *an);
+
+void LCD_AnimGetStats(const LCD_Animator *an, LCD_AnimStats *stats);
+void LCD_AnimResetStats(LCD_Animator *an);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef LCD_DEMO_H
+#define LCD_DEMO_H
+
+#include "LiquidCrystal_C.h"
+
+// Test scenarios for an initialized 16x02 display: writing, cursor and blink control,
+// scrolling, custom characters and the backlight. Used by main.c on the target and by
+// the host simulator (host/lcd_sim.c).
+void LCD_RunDemo(LiquidCrystal_C *lcd);
+
+#endif
@@ -0,0 +1,133 @@
+#include "LCD_Glyph.h"
+#include <string.h>
+
+// Bitmask of the slots whose character code (0..7, or its alias 8..15) is drawn
+// into the framebuffer. Glyphs only left on screen from the previous frame don't
+// count: the next flush rewrites their cells anyway.
+static uint8_t lcd_glyphVisible(const LiquidCrystal_C *lcd)
+{
+    uint8_t mask = 0;
+
+    for (int row = 0; row < lcd->numlines; row++) {
+        const uint8_t *cell = &lcd->fb[row * LCD_MAX_COLS];
+        for (int col = 0; col < lcd->numcols; col++) {
+            if (cell[col] < 16) mask |= 1 << (cell[col] & 0x07);
+        }
+    }
+    return mask;
+}
+
+static bool lcd_glyphSame(const uint8_t a[8], const uint8_t b[8])
+{
+    for (int i = 0; i < 8; i++) {
+        if ((a[i] ^ b[i]) & 0x1F) return false;
+    }
+    return true;
+}
+
+static int lcd_glyphHit(LCD_GlyphCache *gc, int slot)
+{
+    gc->last_use[slot] = ++gc->uses;
+    gc->stats.hits++;
+    return slot;
+}
+
+// Pick a slot for a new glyph: a free one, else the least recently used one off screen
+static int lcd_glyphVictim(LCD_GlyphCache *gc)
+{
+    for (int slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        if (!gc->loaded[slot]) return slot;
+    }
+
+    uint8_t visible = lcd_glyphVisible(gc->lcd);
+    int victim = -1;
+    for (int slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        if (visible & (1 << slot)) continue;
+        if (victim < 0 || (int32_t)(gc->last_use[slot] - gc->last_use[victim]) < 0) {
+            victim = slot;
+        }
+    }
+    return victim;
+}
+
+void LCD_GlyphInit(LCD_GlyphCache *gc, LiquidCrystal_C *lcd)
+{
+    gc->lcd = lcd;
+    gc->uses = 0;
+    LCD_GlyphInvalidate(gc);
+    LCD_GlyphResetStats(gc);
+}
+
+void LCD_GlyphInvalidate(LCD_GlyphCache *gc)
+{
+    for (int slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        gc->loaded[slot] = false;
+        gc->id[slot] = LCD_GLYPH_NO_ID;
+        gc->last_use[slot] = 0;
+    }
+}
+
+int LCD_GlyphGet(LCD_GlyphCache *gc, const uint8_t bitmap[8])
+{
+    return LCD_GlyphGetId(gc, LCD_GLYPH_NO_ID, bitmap);
+}
+
+int LCD_GlyphGetId(LCD_GlyphCache *gc, uint16_t id, const uint8_t bitmap[8])
+{
+    // Look up by ID first, then by content (the same bitmap under another ID is shared)
+    if (id != LCD_GLYPH_NO_ID) {
+        for (int slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+            if (gc->loaded[slot] && gc->id[slot] == id) return lcd_glyphHit(gc, slot);
+        }
+    }
+    for (int slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        if (gc->loaded[slot] && lcd_glyphSame(gc->rows[slot], bitmap)) {
+            if (gc->id[slot] == LCD_GLYPH_NO_ID) gc->id[slot] = id;
+            return lcd_glyphHit(gc, slot);
+        }
+    }
+
+    int slot = lcd_glyphVictim(gc);
+    if (slot < 0) {
+        gc->stats.failures++;
+        return -1;
+    }
+    if (gc->loaded[slot]) {
+        gc->stats.evictions++;
+    }
+    gc->stats.misses++;
+
+    for (int i = 0; i < 8; i++) {
+        gc->rows[slot][i] = bitmap[i] & 0x1F;
+    }
+    gc->id[slot] = id;
+    gc->loaded[slot] = true;
+    gc->last_use[slot] = ++gc->uses;
+    // LCD_CreateChar() puts the DDRAM address back, so writing carries on where it was
+    LCD_CreateChar(gc->lcd, (uint8_t)slot, gc->rows[slot]);
+    return slot;
+}
+
+bool LCD_GlyphPut(LCD_GlyphCache *gc, uint8_t col, uint8_t row, const uint8_t bitmap[8], uint8_t fallback)
+{
+    // Take the cell out of the visibility scan first, so the glyph it held can be replaced
+    LCD_FbPutChar(gc->lcd, col, row, ' ');
+
+    int code = LCD_GlyphGet(gc, bitmap);
+    if (code < 0) {
+        LCD_FbPutChar(gc->lcd, col, row, fallback);
+        return false;
+    }
+    LCD_FbPutChar(gc->lcd, col, row, (uint8_t)code);
+    return true;
+}
+
+void LCD_GlyphGetStats(const LCD_GlyphCache *gc, LCD_GlyphStats *stats)
+{
+    *stats = gc->stats;
+}
+
+void LCD_GlyphResetStats(LCD_GlyphCache *gc)
+{
+    memset(&gc->stats, 0, sizeof(gc->stats));
+}
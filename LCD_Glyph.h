@@ -0,0 +1,50 @@
+#ifndef LCD_GLYPH_H
+#define LCD_GLYPH_H
+
+#include "LiquidCrystal_C.h"
+
+/******************************************************************************
+ * CGRAM glyph cache
+ *
+ * Hands out the 8 custom character slots on demand, so a UI can use any number
+ * of glyphs as long as no more than 8 are on screen at once. A glyph that is
+ * already in CGRAM is reused without any bus traffic; a new one goes into a
+ * free slot or replaces the least recently used glyph that isn't visible.
+ * Visibility is taken from the framebuffer, so draw glyphs with LCD_GlyphPut()
+ * or LCD_FbPutChar() and LCD_Flush(). A replaced glyph still on screen from the
+ * previous frame shows the new bitmap until the flush rewrites its cells.
+ ******************************************************************************/
+#define LCD_GLYPH_SLOTS 8
+#define LCD_GLYPH_NO_ID 0xFFFF
+
+typedef struct {
+    uint32_t hits;      // glyph was already in CGRAM
+    uint32_t misses;    // glyph had to be uploaded
+    uint32_t evictions; // misses that replaced another glyph
+    uint32_t failures;  // no slot free: every slot holds a glyph in the framebuffer
+} LCD_GlyphStats;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    uint8_t rows[LCD_GLYPH_SLOTS][8]; // bitmap held by each slot
+    uint16_t id[LCD_GLYPH_SLOTS];     // LCD_GLYPH_NO_ID for glyphs given by content only
+    bool loaded[LCD_GLYPH_SLOTS];
+    uint32_t last_use[LCD_GLYPH_SLOTS];
+    uint32_t uses;                    // LRU clock
+    LCD_GlyphStats stats;
+} LCD_GlyphCache;
+
+void LCD_GlyphInit(LCD_GlyphCache *gc, LiquidCrystal_C *lcd);
+// Forget what CGRAM holds, e.g. after the display lost power
+void LCD_GlyphInvalidate(LCD_GlyphCache *gc);
+// Character code (0..7) showing this 5x8 bitmap, uploading it if needed. -1 if every
+// slot holds a glyph drawn into the framebuffer.
+int LCD_GlyphGet(LCD_GlyphCache *gc, const uint8_t bitmap[8]);
+// Same, looking the glyph up by an application-chosen ID before comparing bitmaps
+int LCD_GlyphGetId(LCD_GlyphCache *gc, uint16_t id, const uint8_t bitmap[8]);
+// Put a glyph into the framebuffer at (col, row). Draws fallback instead if no slot is free.
+bool LCD_GlyphPut(LCD_GlyphCache *gc, uint8_t col, uint8_t row, const uint8_t bitmap[8], uint8_t fallback);
+void LCD_GlyphGetStats(const LCD_GlyphCache *gc, LCD_GlyphStats *stats);
+void LCD_GlyphResetStats(LCD_GlyphCache *gc);
+
+#endif
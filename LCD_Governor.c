@@ -0,0 +1,142 @@
+#include "LCD_Governor.h"
+#include <string.h>
+#include "stm32f4xx_hal.h" // For HAL_GetTick. Replace with stm32f1xx_hal.h or whatever hardware you're using
+
+#define LCD_GOVERNOR_CELLS (LCD_MAX_LINES * LCD_MAX_COLS)
+
+static uint32_t lcd_governorNowUs(const LCD_Governor *gov)
+{
+    if (gov->clock.now_us != NULL) {
+        return gov->clock.now_us(gov->clock.ctx);
+    }
+    return HAL_GetTick() * 1000;
+}
+
+static void lcd_governorPut(LCD_Governor *gov, uint8_t col, uint8_t row, uint8_t value)
+{
+    uint16_t i = row * LCD_MAX_COLS + col;
+
+    if (gov->pending[i >> 3] & (1 << (i & 7))) {
+        gov->stats.coalesced++;
+    }
+    gov->pending[i >> 3] |= 1 << (i & 7);
+    gov->owner[i] = gov->update_id;
+    gov->pending_any = true;
+    gov->stats.cells++;
+    LCD_FbPutChar(gov->lcd, col, row, value);
+}
+
+// Count the write calls since the last frame that left no cell behind, and forget
+// what was pending. Returns true if a pending cell differs from what is shown.
+static bool lcd_governorCollect(LCD_Governor *gov)
+{
+    const LiquidCrystal_C *lcd = gov->lcd;
+    uint16_t survivors[LCD_GOVERNOR_CELLS];
+    uint16_t count = 0;
+    bool changed = lcd->fb_redraw;
+
+    for (uint16_t i = 0; i < LCD_GOVERNOR_CELLS; i++) {
+        if (!(gov->pending[i >> 3] & (1 << (i & 7)))) continue;
+        if (lcd->fb[i] != lcd->fb_shown[i]) changed = true;
+
+        // Distinct owners, kept sorted
+        uint16_t id = gov->owner[i] - gov->frame_first_id;
+        uint16_t at = count;
+        while (at > 0 && survivors[at - 1] > id) at--;
+        if (at > 0 && survivors[at - 1] == id) continue;
+        memmove(&survivors[at + 1], &survivors[at], (count - at) * sizeof(survivors[0]));
+        survivors[at] = id;
+        count++;
+    }
+    uint16_t calls = gov->update_id - gov->frame_first_id;
+    if (calls > count) {
+        gov->stats.dropped += calls - count;
+    }
+    memset(gov->pending, 0, sizeof(gov->pending));
+    gov->pending_any = false;
+    gov->frame_first_id = gov->update_id;
+    return changed;
+}
+
+void LCD_GovernorInit(LCD_Governor *gov, LiquidCrystal_C *lcd, uint32_t hz, const LCD_Clock *clock)
+{
+    memset(gov, 0, sizeof(*gov));
+    gov->lcd = lcd;
+    if (clock != NULL) {
+        gov->clock = *clock;
+    }
+    LCD_GovernorSetRate(gov, hz);
+    gov->next_frame = lcd_governorNowUs(gov);
+    gov->stats_start = gov->next_frame;
+}
+
+void LCD_GovernorSetRate(LCD_Governor *gov, uint32_t hz)
+{
+    if (hz == 0) hz = LCD_GOVERNOR_DEFAULT_HZ;
+    gov->period_us = 1000000 / hz;
+}
+
+void LCD_GovernorWrite(LCD_Governor *gov, uint8_t col, uint8_t row, const char *str)
+{
+    gov->update_id++;
+    gov->stats.updates++;
+    if (row >= gov->lcd->numlines) return;
+    while (*str && col < gov->lcd->numcols) {
+        lcd_governorPut(gov, col++, row, (uint8_t)*str++);
+    }
+}
+
+void LCD_GovernorPutChar(LCD_Governor *gov, uint8_t col, uint8_t row, uint8_t value)
+{
+    gov->update_id++;
+    gov->stats.updates++;
+    if (col >= gov->lcd->numcols || row >= gov->lcd->numlines) return;
+    lcd_governorPut(gov, col, row, value);
+}
+
+bool LCD_GovernorPoll(LCD_Governor *gov)
+{
+    uint32_t now = lcd_governorNowUs(gov);
+    int32_t late = (int32_t)(now - gov->next_frame);
+
+    if (late < 0) return false;
+
+    // Keep the cadence, unless a whole period has been missed
+    gov->next_frame += gov->period_us;
+    if ((int32_t)(now - gov->next_frame) >= 0) {
+        gov->next_frame = now + gov->period_us;
+    }
+    if (!gov->pending_any || !lcd_governorCollect(gov)) {
+        gov->stats.frames_skipped++;
+        return false;
+    }
+    if ((uint32_t)late > gov->stats.late_us) {
+        gov->stats.late_us = (uint32_t)late;
+    }
+    LCD_Flush(gov->lcd);
+    gov->stats.frames++;
+    return true;
+}
+
+bool LCD_GovernorFlush(LCD_Governor *gov)
+{
+    if (!gov->pending_any || !lcd_governorCollect(gov)) return false;
+    LCD_Flush(gov->lcd);
+    gov->stats.frames++;
+    return true;
+}
+
+void LCD_GovernorGetStats(LCD_Governor *gov, LCD_GovernorStats *stats)
+{
+    gov->stats.elapsed_us = lcd_governorNowUs(gov) - gov->stats_start;
+    gov->stats.rate_mhz = (gov->stats.elapsed_us != 0)
+                          ? (uint32_t)((uint64_t)gov->stats.frames * 1000000000 / gov->stats.elapsed_us)
+                          : 0;
+    *stats = gov->stats;
+}
+
+void LCD_GovernorResetStats(LCD_Governor *gov)
+{
+    memset(&gov->stats, 0, sizeof(gov->stats));
+    gov->stats_start = lcd_governorNowUs(gov);
+}
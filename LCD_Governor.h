@@ -0,0 +1,65 @@
+#ifndef LCD_GOVERNOR_H
+#define LCD_GOVERNOR_H
+
+#include "LiquidCrystal_C.h"
+
+/******************************************************************************
+ * Refresh-rate governor
+ *
+ * Caps how often the display is updated, however often the application writes.
+ * Writes go into the framebuffer, where a later write to a cell replaces an
+ * earlier one that hasn't been shown yet. LCD_GovernorPoll() sends a frame (one
+ * LCD_Flush(), i.e. only the net change) once per period, and skips it when no
+ * cell ended up different from what the display shows.
+ *
+ * Write through the governor rather than with LCD_FbWrite() so it knows which
+ * cells are pending; drawing into the framebuffer directly still works, but
+ * then a frame only goes out if a governed write is pending too.
+ ******************************************************************************/
+#define LCD_GOVERNOR_DEFAULT_HZ 20
+
+typedef struct {
+    uint32_t updates;        // write calls
+    uint32_t cells;          // cells written by them
+    uint32_t coalesced;      // cell writes replaced by a later one before they were shown
+    uint32_t dropped;        // write calls all of whose cells were replaced before they were shown
+    uint32_t frames;         // frames sent
+    uint32_t frames_skipped; // frame times with nothing to send
+    uint32_t late_us;        // longest a frame went out after its time (poll too seldom, or slow bus)
+    uint32_t elapsed_us;     // time covered by these counters
+    uint32_t rate_mhz;       // frames per second achieved, in thousandths
+} LCD_GovernorStats;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    LCD_Clock clock;          // all NULL = HAL tick
+    uint32_t period_us;
+    uint32_t next_frame;      // when the next frame is due
+    uint32_t stats_start;
+    uint16_t update_id;       // id of the last write call
+    uint16_t frame_first_id;  // id of the first write call since the last frame
+    bool pending_any;
+    // Cells written since the last frame, and the write call that wrote each last
+    uint8_t pending[(LCD_MAX_LINES * LCD_MAX_COLS + 7) / 8];
+    uint16_t owner[LCD_MAX_LINES * LCD_MAX_COLS];
+    LCD_GovernorStats stats;
+} LCD_Governor;
+
+// Start governing a display that has been started with LCD_Begin(). hz = 0 picks
+// LCD_GOVERNOR_DEFAULT_HZ. clock NULL uses the 1 ms HAL tick.
+void LCD_GovernorInit(LCD_Governor *gov, LiquidCrystal_C *lcd, uint32_t hz, const LCD_Clock *clock);
+void LCD_GovernorSetRate(LCD_Governor *gov, uint32_t hz);
+
+// Draw into the next frame. A string is clipped at the end of the row.
+void LCD_GovernorWrite(LCD_Governor *gov, uint8_t col, uint8_t row, const char *str);
+void LCD_GovernorPutChar(LCD_Governor *gov, uint8_t col, uint8_t row, uint8_t value);
+
+// Send the frame if it is due. Returns true if anything was sent.
+bool LCD_GovernorPoll(LCD_Governor *gov);
+// Send what is pending now, without waiting for the frame time
+bool LCD_GovernorFlush(LCD_Governor *gov);
+
+void LCD_GovernorGetStats(LCD_Governor *gov, LCD_GovernorStats *stats);
+void LCD_GovernorResetStats(LCD_Governor *gov);
+
+#endif
@@ -0,0 +1,324 @@
+#include "LCD_Graph.h"
+#include <string.h>
+
+// Cells of the digit tables: glyph 0..7 of the font's set, or one of these
+#define G_SPACE 0xF0
+#define G_FULL  0xF1
+#define G_UNDER 0xF2 // ROM underscore
+
+static const uint8_t lcd_graphHbar[4 * 8] = {
+    0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+    0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18,
+    0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C,
+    0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E,
+};
+
+static const uint8_t lcd_graphVbar[7 * 8] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F,
+    0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F,
+    0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F,
+    0x00, 0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F,
+    0x00, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F,
+};
+
+// 2x2: each cell is half a seven-segment digit with 2-dot strokes. The middle bar is
+// the bottom of the upper cells; the bottom bar on its own is the ROM underscore.
+enum { AF, AB, AG, AFG, ABG, ED, CD, B };
+static const uint8_t lcd_graphFont2x2[8 * 8] = {
+    0x1F, 0x1F, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, // AF:  top bar, left stroke
+    0x1F, 0x1F, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, // AB:  top bar, right stroke
+    0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, // AG:  top and middle bars
+    0x1F, 0x1F, 0x18, 0x18, 0x18, 0x18, 0x1F, 0x1F, // AFG
+    0x1F, 0x1F, 0x03, 0x03, 0x03, 0x03, 0x1F, 0x1F, // ABG
+    0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1F, 0x1F, // ED:  left stroke, bottom bar
+    0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x1F, 0x1F, // CD:  right stroke, bottom bar
+    0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, 0x03, // B:   right stroke
+};
+
+// Top left, top right, bottom left, bottom right for '0'..'9', '-' and ' '
+static const uint8_t lcd_graphDigits2x2[12][4] = {
+    { AF,      AB,      ED,      CD      },
+    { G_SPACE, B,       G_SPACE, B       },
+    { AG,      ABG,     ED,      G_UNDER },
+    { AG,      ABG,     G_UNDER, CD      },
+    { ED,      CD,      G_SPACE, B       },
+    { AFG,     AG,      G_UNDER, CD      },
+    { AFG,     AG,      ED,      CD      },
+    { AG,      AB,      G_SPACE, B       },
+    { AFG,     ABG,     ED,      CD      },
+    { AFG,     ABG,     G_UNDER, CD      },
+    { G_UNDER, G_UNDER, G_SPACE, G_SPACE },
+    { G_SPACE, G_SPACE, G_SPACE, G_SPACE },
+};
+
+// 3x2: solid segments with rounded corners
+enum { LT, UB, RT, LL, LB, LR, UMB };
+static const uint8_t lcd_graphFont3x2[7 * 8] = {
+    0x07, 0x0F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, // LT:  left top
+    0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x00, 0x00, // UB:  upper bar
+    0x1C, 0x1E, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, // RT:  right top
+    0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x0F, 0x07, // LL:  left bottom
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x1F, 0x1F, 0x1F, // LB:  lower bar
+    0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1E, 0x1C, // LR:  right bottom
+    0x1F, 0x1F, 0x1F, 0x00, 0x00, 0x00, 0x1F, 0x1F, // UMB: upper and lower bars
+};
+
+// Top row left to right, then the bottom row
+static const uint8_t lcd_graphDigits3x2[12][6] = {
+    { LT,      UB,      RT,      LL,      LB,      LR      },
+    { UB,      RT,      G_SPACE, LB,      G_FULL,  LB      },
+    { UMB,     UMB,     RT,      LL,      LB,      LB      },
+    { UMB,     UMB,     RT,      LB,      LB,      LR      },
+    { LL,      LB,      G_FULL,  G_SPACE, G_SPACE, G_FULL  },
+    { LL,      UMB,     UMB,     LB,      LB,      LR      },
+    { LT,      UMB,     UMB,     LL,      LB,      LR      },
+    { UB,      UB,      RT,      G_SPACE, G_SPACE, G_FULL  },
+    { LT,      UMB,     RT,      LL,      LB,      LR      },
+    { LT,      UMB,     RT,      LB,      LB,      LR      },
+    { LB,      LB,      LB,      G_SPACE, G_SPACE, G_SPACE },
+    { G_SPACE, G_SPACE, G_SPACE, G_SPACE, G_SPACE, G_SPACE },
+};
+
+static uint8_t lcd_graphSetSize(LCD_GraphSet set)
+{
+    switch (set) {
+    case LCD_GRAPH_HBAR:       return 4;
+    case LCD_GRAPH_VBAR:       return 7;
+    case LCD_GRAPH_DIGITS_2X2: return 8;
+    case LCD_GRAPH_DIGITS_3X2: return 7;
+    default:                   return 0;
+    }
+}
+
+static bool lcd_graphFits(const LCD_Graph *graph, LCD_GraphSet set)
+{
+    return graph->base + lcd_graphSetSize(set) <= 8;
+}
+
+static uint8_t lcd_graphCode(const LCD_Graph *graph, uint8_t cell)
+{
+    switch (cell) {
+    case G_SPACE: return ' ';
+    case G_FULL:  return graph->full;
+    case G_UNDER: return '_';
+    default:      return graph->base + cell;
+    }
+}
+
+// An update starts: put the widget's glyph set into CGRAM unless it is there already
+static void lcd_graphBegin(LCD_Graph *graph, LCD_GraphSet set, LCD_BusStats *before)
+{
+    *before = graph->lcd->stats;
+    graph->stats.last_cells = 0;
+    LCD_BeginBurst(graph->lcd);
+    if (graph->set == set) return;
+
+    const uint8_t *rows = NULL;
+    switch (set) {
+    case LCD_GRAPH_HBAR:       rows = lcd_graphHbar; break;
+    case LCD_GRAPH_VBAR:       rows = lcd_graphVbar; break;
+    case LCD_GRAPH_DIGITS_2X2: rows = lcd_graphFont2x2; break;
+    case LCD_GRAPH_DIGITS_3X2: rows = lcd_graphFont3x2; break;
+    default:                   return;
+    }
+    LCD_WriteCGRAM(graph->lcd, graph->base, 0, rows, lcd_graphSetSize(set) * 8);
+    graph->set = set;
+    graph->stats.set_loads++;
+}
+
+static void lcd_graphPut(LCD_Graph *graph, uint8_t col, uint8_t row, uint8_t code)
+{
+    if (LCD_FbGetChar(graph->lcd, col, row) == code) return;
+    LCD_FbPutChar(graph->lcd, col, row, code);
+    graph->stats.last_cells++;
+}
+
+static void lcd_graphEnd(LCD_Graph *graph, const LCD_BusStats *before)
+{
+    LiquidCrystal_C *lcd = graph->lcd;
+
+    if (graph->stats.last_cells != 0) {
+        LCD_Flush(lcd);
+    }
+    LCD_EndBurst(lcd);
+    graph->stats.last_bytes = lcd->stats.gpio_bytes - before->gpio_bytes;
+    if (graph->stats.last_bytes == 0) {
+        graph->stats.unchanged++;
+        return;
+    }
+    graph->stats.updates++;
+    graph->stats.cells += graph->stats.last_cells;
+    graph->stats.bus_bytes += graph->stats.last_bytes;
+}
+
+void LCD_GraphInit(LCD_Graph *graph, LiquidCrystal_C *lcd, uint8_t base)
+{
+    memset(graph, 0, sizeof(*graph));
+    graph->lcd = lcd;
+    graph->base = base & 0x7;
+    graph->full = LCD_GRAPH_FULL_BLOCK;
+    graph->set = LCD_GRAPH_NONE;
+}
+
+void LCD_GraphSetFullBlock(LCD_Graph *graph, uint8_t code)
+{
+    graph->full = code;
+}
+
+void LCD_GraphInvalidate(LCD_Graph *graph)
+{
+    graph->set = LCD_GRAPH_NONE;
+}
+
+void LCD_GraphGetStats(const LCD_Graph *graph, LCD_GraphStats *stats)
+{
+    *stats = graph->stats;
+}
+
+void LCD_GraphResetStats(LCD_Graph *graph)
+{
+    memset(&graph->stats, 0, sizeof(graph->stats));
+}
+
+/*******************************************************************************
+ * BARS
+ ******************************************************************************/
+bool LCD_BarInit(LCD_Bar *bar, LCD_Graph *graph, uint8_t col, uint8_t row, uint8_t len, bool vertical, uint16_t max)
+{
+    const LiquidCrystal_C *lcd = graph->lcd;
+
+    memset(bar, 0, sizeof(*bar));
+    if (len == 0 || max == 0 || !lcd_graphFits(graph, vertical ? LCD_GRAPH_VBAR : LCD_GRAPH_HBAR)) return false;
+    if (vertical ? (col >= lcd->numcols || row >= lcd->numlines || len > row + 1)
+                 : (row >= lcd->numlines || col + len > lcd->numcols)) return false;
+
+    bar->graph = graph;
+    bar->col = col;
+    bar->row = row;
+    bar->len = len;
+    bar->vertical = vertical;
+    bar->max = max;
+    bar->fill = -1;
+    return true;
+}
+
+void LCD_BarSet(LCD_Bar *bar, uint16_t value)
+{
+    LCD_Graph *graph = bar->graph;
+    if (graph == NULL) return;
+
+    LCD_GraphSet set = bar->vertical ? LCD_GRAPH_VBAR : LCD_GRAPH_HBAR;
+    uint8_t unit = bar->vertical ? 8 : 5; // steps per cell
+    uint32_t steps = (uint32_t)bar->len * unit;
+    if (value > bar->max) value = bar->max;
+    int16_t fill = (int16_t)((value * steps + bar->max / 2) / bar->max);
+    // Same fill, and the partial cell's glyph is still in CGRAM
+    if (fill == bar->fill && graph->set == set) return;
+
+    // Only the cells between the old and the new end of the bar can change
+    uint8_t first = 0;
+    uint8_t last = bar->len - 1;
+    if (bar->fill >= 0) {
+        int16_t lo = (fill < bar->fill) ? fill : bar->fill;
+        int16_t hi = (fill < bar->fill) ? bar->fill : fill;
+        first = lo / unit;
+        last = (hi / unit < bar->len) ? hi / unit : bar->len - 1;
+    }
+
+    LCD_BusStats before;
+    lcd_graphBegin(graph, set, &before);
+    for (uint8_t i = first; i <= last; i++) {
+        int16_t lit = fill - i * unit;
+        uint8_t code = (lit >= unit) ? graph->full : (lit <= 0) ? ' ' : graph->base + lit - 1;
+        if (bar->vertical) {
+            lcd_graphPut(graph, bar->col, bar->row - i, code);
+        } else {
+            lcd_graphPut(graph, bar->col + i, bar->row, code);
+        }
+    }
+    bar->fill = fill;
+    lcd_graphEnd(graph, &before);
+}
+
+void LCD_BarRedraw(LCD_Bar *bar)
+{
+    bar->fill = -1;
+}
+
+/*******************************************************************************
+ * BIG DIGITS
+ ******************************************************************************/
+static uint8_t lcd_bigWidth(const LCD_BigNum *big)
+{
+    return (big->font == LCD_GRAPH_DIGITS_3X2) ? 3 : 2;
+}
+
+bool LCD_BigInit(LCD_BigNum *big, LCD_Graph *graph, uint8_t col, uint8_t row, uint8_t digits, LCD_GraphSet font)
+{
+    const LiquidCrystal_C *lcd = graph->lcd;
+
+    memset(big, 0, sizeof(*big));
+    if (font != LCD_GRAPH_DIGITS_2X2 && font != LCD_GRAPH_DIGITS_3X2) return false;
+    big->font = font;
+    if (digits == 0 || digits > LCD_BIG_MAX_DIGITS || !lcd_graphFits(graph, font)) return false;
+    if (row + 2 > lcd->numlines || col + digits * lcd_bigWidth(big) > lcd->numcols) return false;
+
+    big->graph = graph;
+    big->col = col;
+    big->row = row;
+    big->digits = digits;
+    return true;
+}
+
+void LCD_BigWrite(LCD_BigNum *big, const char *text)
+{
+    LCD_Graph *graph = big->graph;
+    if (graph == NULL) return;
+
+    uint8_t width = lcd_bigWidth(big);
+    LCD_BusStats before;
+    lcd_graphBegin(graph, big->font, &before);
+    for (uint8_t d = 0; d < big->digits; d++) {
+        char c = (*text != '\0') ? *text++ : ' ';
+        if (!((c >= '0' && c <= '9') || c == '-')) c = ' ';
+        if (c == big->shown[d]) continue;
+        big->shown[d] = c;
+
+        uint8_t glyph = (c == '-') ? 10 : (c == ' ') ? 11 : c - '0';
+        const uint8_t *cells = (width == 3) ? lcd_graphDigits3x2[glyph] : lcd_graphDigits2x2[glyph];
+        uint8_t col = big->col + d * width;
+        for (uint8_t i = 0; i < 2 * width; i++) {
+            lcd_graphPut(graph, col + i % width, big->row + i / width, lcd_graphCode(graph, cells[i]));
+        }
+    }
+    lcd_graphEnd(graph, &before);
+}
+
+void LCD_BigNumber(LCD_BigNum *big, int32_t value)
+{
+    char text[LCD_BIG_MAX_DIGITS + 1];
+    char digits[12];
+    uint8_t n = 0;
+    uint32_t v = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v != 0);
+    if (value < 0) digits[n++] = '-';
+
+    // Right aligned; too many digits keeps the lowest ones
+    for (uint8_t i = 0; i < big->digits; i++) {
+        uint8_t from = big->digits - 1 - i;
+        text[i] = (from < n) ? digits[from] : ' ';
+    }
+    text[big->digits] = '\0';
+    LCD_BigWrite(big, text);
+}
+
+void LCD_BigRedraw(LCD_BigNum *big)
+{
+    memset(big->shown, 0, sizeof(big->shown));
+}
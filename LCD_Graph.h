@@ -0,0 +1,103 @@
+#ifndef LCD_GRAPH_H
+#define LCD_GRAPH_H
+
+#include "LiquidCrystal_C.h"
+
+/******************************************************************************
+ * Bar graphs and big digits
+ *
+ * Bars fill cell by cell with full blocks and end in a partial cell drawn with
+ * one of a set of custom characters, which gives 5 steps per cell across and 8
+ * up. Big digits are built from custom segment characters, 2 or 3 cells wide
+ * and 2 rows high. Each glyph set goes into CGRAM once, when the first widget
+ * that needs it is drawn, and then stays there.
+ *
+ * Widgets remember what they show: an update only redraws the cells whose
+ * character actually changes (for a bar that moved a step, the partial cell and
+ * at most one neighbour), through the framebuffer and one LCD_Flush(), so what
+ * it costs on the bus doesn't depend on the length of the bar. The bytes sent
+ * by the last update are kept in the statistics.
+ *
+ * The glyph sets take CGRAM slots from base on: 4 for horizontal bars, 7 for
+ * vertical bars and 3x2 digits, 8 for 2x2 digits. One set is loaded at a time;
+ * drawing a widget of another set replaces it, and widgets of the old set show
+ * the wrong bitmaps until they are redrawn. Keep the slots away from the glyph
+ * cache (LCD_Glyph.h) and animations (LCD_Anim.h).
+ ******************************************************************************/
+#define LCD_GRAPH_FULL_BLOCK 0xFF // full block in the A00 ROM
+#define LCD_BIG_MAX_DIGITS   6
+
+typedef enum {
+    LCD_GRAPH_NONE = 0,
+    LCD_GRAPH_HBAR,       // 4 slots: 1..4 columns lit
+    LCD_GRAPH_VBAR,       // 7 slots: 1..7 rows lit from the bottom
+    LCD_GRAPH_DIGITS_2X2, // 8 slots
+    LCD_GRAPH_DIGITS_3X2, // 7 slots
+} LCD_GraphSet;
+
+typedef struct {
+    uint32_t updates;    // widget updates that sent something
+    uint32_t unchanged;  // updates that left every cell as it was
+    uint32_t cells;      // cells redrawn
+    uint32_t set_loads;  // glyph sets uploaded to CGRAM
+    uint32_t bus_bytes;  // GPIO bytes sent by all updates
+    uint32_t last_cells; // cells redrawn by the last update
+    uint32_t last_bytes; // GPIO bytes sent by the last update, glyph set included
+} LCD_GraphStats;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    uint8_t base;       // first CGRAM slot of the glyph sets
+    uint8_t full;       // character code of a full block
+    LCD_GraphSet set;   // set in CGRAM
+    LCD_GraphStats stats;
+} LCD_Graph;
+
+typedef struct {
+    LCD_Graph *graph;
+    uint8_t col, row;   // left end, or bottom end of a vertical bar
+    uint8_t len;        // cells
+    bool vertical;
+    uint16_t max;       // value of a full bar
+    int16_t fill;       // steps shown, -1 = not drawn yet
+} LCD_Bar;
+
+typedef struct {
+    LCD_Graph *graph;
+    uint8_t col, row;   // top left cell
+    uint8_t digits;     // positions, each 2 or 3 cells wide
+    LCD_GraphSet font;  // LCD_GRAPH_DIGITS_2X2 or LCD_GRAPH_DIGITS_3X2
+    char shown[LCD_BIG_MAX_DIGITS]; // character at each position, 0 = not drawn yet
+} LCD_BigNum;
+
+// The display must have been started with LCD_Begin(). The glyph sets go into
+// CGRAM slots base..7; the full block is LCD_GRAPH_FULL_BLOCK.
+void LCD_GraphInit(LCD_Graph *graph, LiquidCrystal_C *lcd, uint8_t base);
+// Character code drawn for a full cell, for ROMs without a full block at 0xFF (e.g. A02)
+void LCD_GraphSetFullBlock(LCD_Graph *graph, uint8_t code);
+// Forget what CGRAM holds, e.g. after LCD_BeginWarm() or a display power cycle. Call
+// the widgets' Redraw functions as well if the screen was cleared.
+void LCD_GraphInvalidate(LCD_Graph *graph);
+void LCD_GraphGetStats(const LCD_Graph *graph, LCD_GraphStats *stats);
+void LCD_GraphResetStats(LCD_Graph *graph);
+
+// A bar len cells long from (col, row), to the right or upwards, full at max. False if
+// it doesn't fit on the screen or its glyph set doesn't fit in CGRAM from base on.
+// Nothing is drawn until the first LCD_BarSet().
+bool LCD_BarInit(LCD_Bar *bar, LCD_Graph *graph, uint8_t col, uint8_t row, uint8_t len, bool vertical, uint16_t max);
+// Show value (clamped to max), rounded to the nearest step
+void LCD_BarSet(LCD_Bar *bar, uint16_t value);
+// Draw every cell at the next LCD_BarSet(), e.g. after the screen was cleared
+void LCD_BarRedraw(LCD_Bar *bar);
+
+// Big digits at (col, row): digits positions, 2 rows high. False if they don't fit on
+// the screen or the font's glyph set doesn't fit in CGRAM from base on.
+bool LCD_BigInit(LCD_BigNum *big, LCD_Graph *graph, uint8_t col, uint8_t row, uint8_t digits, LCD_GraphSet font);
+// Show text: '0'..'9', '-' and ' ', one per position, left aligned; other characters
+// and the positions past the end of text are blank
+void LCD_BigWrite(LCD_BigNum *big, const char *text);
+// Show value right aligned, '-' for negative numbers
+void LCD_BigNumber(LCD_BigNum *big, int32_t value);
+void LCD_BigRedraw(LCD_BigNum *big);
+
+#endif
@@ -0,0 +1,228 @@
+#include "LCD_Manager.h"
+#include <string.h>
+#include "stm32f4xx_hal.h" // For HAL_GetTick. Replace with stm32f1xx_hal.h or whatever hardware you're using
+
+static uint32_t lcd_managerNowUs(const LCD_Manager *mgr)
+{
+    if (mgr->clock.now_us != NULL) {
+        return mgr->clock.now_us(mgr->clock.ctx);
+    }
+    return HAL_GetTick() * 1000;
+}
+
+static bool lcd_managerBusBusy(const LCD_Manager *mgr, const void *bus)
+{
+    for (int i = 0; i < mgr->count; i++) {
+        if (mgr->displays[i].bus == bus && mgr->displays[i].in_flight) return true;
+    }
+    return false;
+}
+
+// Should a get the bus before b?
+static bool lcd_managerBefore(const LCD_Manager *mgr, const LCD_ManagedDisplay *a,
+                              const LCD_ManagedDisplay *b, uint32_t now)
+{
+    if (mgr->policy == LCD_SCHED_DEADLINE) {
+        int32_t left_a = (int32_t)(a->asked_us + a->budget_us - now);
+        int32_t left_b = (int32_t)(b->asked_us + b->budget_us - now);
+        if (left_a != left_b) return left_a < left_b;
+    }
+    // Round robin, and ties between deadlines: whoever had the bus longest ago
+    return (int32_t)(a->served - b->served) < 0;
+}
+
+// Modelled bus time of a transfer of len bytes
+static uint32_t lcd_managerBusUs(const LiquidCrystal_C *lcd, uint16_t len)
+{
+    uint32_t bits = lcd->transport.transfer_bits
+                    + (uint32_t)(len / lcd->transport.value_bytes) * lcd->transport.value_bits;
+    return (uint32_t)(((uint64_t)bits * 1000000) / lcd->bus_hz);
+}
+
+static void lcd_managerStart(LCD_Manager *mgr, LCD_ManagedDisplay *d, uint32_t now)
+{
+    uint32_t waited = now - d->asked_us;
+
+    d->pending   = false;
+    d->in_flight = true;
+    d->served    = ++mgr->grants;
+    d->stats.transfers++;
+    d->stats.bytes   += d->len;
+    d->stats.bus_us  += lcd_managerBusUs(d->lcd, d->len);
+    d->stats.wait_us += waited;
+    if (waited > d->stats.max_wait_us) d->stats.max_wait_us = waited;
+    if (mgr->policy == LCD_SCHED_DEADLINE && waited > d->budget_us) d->stats.late++;
+
+    // The transfer may complete (and the display ask again) before this returns
+    if (!d->tx_fn(d->tx_ctx, d->buf, d->len)) {
+        // Bus not available, like the engine does: try again on the next poll
+        d->in_flight = false;
+        d->pending   = true;
+        d->stalled   = true;
+        d->stats.errors++;
+    }
+}
+
+// Give every free bus to the display that should go next on it
+static void lcd_managerDispatch(LCD_Manager *mgr)
+{
+    if (mgr->dispatching) {
+        mgr->redispatch = true;
+        return;
+    }
+    do {
+        mgr->dispatching = true;
+        mgr->redispatch = false;
+        for (int i = 0; i < mgr->count; i++) {
+            LCD_ManagedDisplay *d = &mgr->displays[i];
+            if (!d->pending || d->stalled || lcd_managerBusBusy(mgr, d->bus)) continue;
+
+            uint32_t now = lcd_managerNowUs(mgr);
+            LCD_ManagedDisplay *next = d;
+            for (int j = 0; j < mgr->count; j++) {
+                LCD_ManagedDisplay *o = &mgr->displays[j];
+                if (o->bus == d->bus && o->pending && !o->stalled && lcd_managerBefore(mgr, o, next, now)) {
+                    next = o;
+                }
+            }
+            lcd_managerStart(mgr, next, now);
+        }
+        // Let go before looking at redispatch, like the async engine
+        mgr->dispatching = false;
+    } while (mgr->redispatch);
+}
+
+// The engine's transfer function: queue the run until the scheduler gives it the bus
+static bool lcd_managerTx(void *ctx, const uint8_t *buf, uint16_t len)
+{
+    LCD_ManagedDisplay *d = (LCD_ManagedDisplay *)ctx;
+
+    d->buf      = buf;
+    d->len      = len;
+    d->pending  = true;
+    d->asked_us = lcd_managerNowUs(d->mgr);
+    lcd_managerDispatch(d->mgr);
+    return true;
+}
+
+static LCD_ManagedDisplay *lcd_managerOnBus(LCD_Manager *mgr, const void *bus)
+{
+    for (int i = 0; i < mgr->count; i++) {
+        if (mgr->displays[i].bus == bus && mgr->displays[i].in_flight) return &mgr->displays[i];
+    }
+    return NULL;
+}
+
+void LCD_ManagerInit(LCD_Manager *mgr, LCD_SchedPolicy policy, const LCD_Clock *clock)
+{
+    memset(mgr, 0, sizeof(*mgr));
+    mgr->policy = policy;
+    if (clock != NULL) {
+        mgr->clock = *clock;
+    }
+}
+
+int LCD_ManagerAdd(LCD_Manager *mgr, LiquidCrystal_C *lcd, const void *bus, bool use_dma)
+{
+    if (mgr->count >= LCD_MANAGER_MAX_DISPLAYS) return -1;
+    if (!lcd->async.enabled && !LCD_AsyncInit(lcd, use_dma)) return -1;
+
+    int index = mgr->count++;
+    LCD_ManagedDisplay *d = &mgr->displays[index];
+    memset(d, 0, sizeof(*d));
+    d->lcd       = lcd;
+    d->bus       = bus;
+    d->mgr       = mgr;
+    d->budget_us = LCD_MANAGER_DEFAULT_BUDGET_US;
+    d->tx_fn     = lcd->async.tx_fn;
+    d->tx_ctx    = lcd->async.tx_ctx;
+    LCD_AsyncSetTransport(lcd, lcd_managerTx, d);
+    return index;
+}
+
+void LCD_ManagerSetBudget(LCD_Manager *mgr, int index, uint32_t budget_us)
+{
+    if (index < 0 || index >= mgr->count) return;
+    mgr->displays[index].budget_us = budget_us;
+}
+
+void LCD_ManagerTxComplete(LCD_Manager *mgr, const void *bus)
+{
+    LCD_ManagedDisplay *d = lcd_managerOnBus(mgr, bus);
+
+    if (d == NULL) return;
+    d->in_flight = false;
+    LCD_AsyncTxComplete(d->lcd);
+    lcd_managerDispatch(mgr);
+}
+
+void LCD_ManagerTxError(LCD_Manager *mgr, const void *bus)
+{
+    LCD_ManagedDisplay *d = lcd_managerOnBus(mgr, bus);
+
+    if (d == NULL) return;
+    d->in_flight = false;
+    d->stats.errors++;
+    // The engine sends the run again, or drops it after LCD_ASYNC_RETRIES
+    LCD_AsyncTxError(d->lcd);
+    lcd_managerDispatch(mgr);
+}
+
+void LCD_ManagerPoll(LCD_Manager *mgr)
+{
+    for (int i = 0; i < mgr->count; i++) {
+        mgr->displays[i].stalled = false;
+        LCD_AsyncPoll(mgr->displays[i].lcd);
+    }
+    lcd_managerDispatch(mgr);
+}
+
+bool LCD_ManagerIsIdle(const LCD_Manager *mgr)
+{
+    for (int i = 0; i < mgr->count; i++) {
+        if (!LCD_IsIdle(mgr->displays[i].lcd)) return false;
+    }
+    return true;
+}
+
+void LCD_ManagerWaitIdle(LCD_Manager *mgr)
+{
+    while (!LCD_ManagerIsIdle(mgr)) {
+        LCD_ManagerPoll(mgr);
+
+        // Nothing on any bus and every busy display waiting out a delay: sleep
+        // until the first of those delays is over
+        uint32_t now = lcd_managerNowUs(mgr);
+        uint32_t sleep_us = UINT32_MAX;
+        for (int i = 0; i < mgr->count; i++) {
+            const LCD_Async *a = &mgr->displays[i].lcd->async;
+            if (LCD_IsIdle(mgr->displays[i].lcd)) continue;
+            if (a->tx_busy || !a->waiting) {
+                sleep_us = 0;
+                break;
+            }
+            uint32_t elapsed = now - a->wait_start;
+            uint32_t left = (elapsed < a->wait_us) ? a->wait_us - elapsed : 0;
+            if (left < sleep_us) sleep_us = left;
+        }
+        if (sleep_us != 0 && sleep_us != UINT32_MAX && mgr->clock.delay_us != NULL) {
+            mgr->clock.delay_us(mgr->clock.ctx, sleep_us);
+        }
+    }
+}
+
+void LCD_ManagerGetStats(const LCD_Manager *mgr, int index, LCD_ManagerStats *stats)
+{
+    if (index < 0 || index >= mgr->count) {
+        memset(stats, 0, sizeof(*stats));
+        return;
+    }
+    *stats = mgr->displays[index].stats;
+}
+
+void LCD_ManagerResetStats(LCD_Manager *mgr)
+{
+    for (int i = 0; i < mgr->count; i++) {
+        memset(&mgr->displays[i].stats, 0, sizeof(mgr->displays[i].stats));
+    }
+}
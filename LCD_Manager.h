@@ -0,0 +1,89 @@
+#ifndef LCD_MANAGER_H
+#define LCD_MANAGER_H
+
+#include "LiquidCrystal_C.h"
+
+/******************************************************************************
+ * Multi-display manager
+ *
+ * Drives several displays, on one bus or on several, each through its own
+ * async engine (see LCD_AsyncInit). The manager sits between the engines and
+ * the buses: a display's transfer starts only when its bus is free, and when
+ * several displays wait for the same bus the scheduler picks who goes next.
+ * A transfer is one data run of at most burst_max bytes, which bounds how long
+ * a big redraw holds the bus, and a display waiting out an execution delay
+ * asks for nothing, so meanwhile the bus serves the others.
+ *
+ * Call LCD_ManagerTxComplete()/LCD_ManagerTxError() from the HAL completion
+ * callbacks instead of LCD_AsyncTxComplete(), and LCD_ManagerPoll() from a
+ * timer or the main loop. Give the displays and the manager the same clock.
+ ******************************************************************************/
+#ifndef LCD_MANAGER_MAX_DISPLAYS
+#define LCD_MANAGER_MAX_DISPLAYS 6
+#endif
+// Deadline scheduling: how long a display's transfers may wait for the bus by default
+#define LCD_MANAGER_DEFAULT_BUDGET_US 5000
+
+typedef enum {
+    LCD_SCHED_ROUND_ROBIN, // the display served least recently goes first
+    LCD_SCHED_DEADLINE     // earliest deadline first: time asked plus the display's budget
+} LCD_SchedPolicy;
+
+// Bus usage of one display
+typedef struct {
+    uint32_t transfers;   // transfers started
+    uint32_t bytes;       // GPIO bytes sent
+    uint32_t bus_us;      // bus time of those transfers, from the transport's cost model
+    uint32_t wait_us;     // time transfers were held back while the bus served others
+    uint32_t max_wait_us;
+    uint32_t late;        // deadline policy: transfers started after their deadline
+    uint32_t errors;      // transfers that failed or couldn't be started
+} LCD_ManagerStats;
+
+struct LCD_Manager;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    const void *bus;       // identifies the bus, e.g. &hi2c1
+    LCD_AsyncTxFn tx_fn;   // the display's own transfer function
+    void *tx_ctx;
+    uint32_t budget_us;
+    // Transfer the engine asked for, waiting for the bus or on it
+    const uint8_t *buf;
+    uint16_t len;
+    bool pending;
+    bool in_flight;
+    bool stalled;          // couldn't be started: retried on the next poll
+    uint32_t asked_us;
+    uint32_t served;       // when the display last got the bus, in grants
+    LCD_ManagerStats stats;
+    struct LCD_Manager *mgr;
+} LCD_ManagedDisplay;
+
+typedef struct LCD_Manager {
+    LCD_ManagedDisplay displays[LCD_MANAGER_MAX_DISPLAYS];
+    uint8_t count;
+    LCD_SchedPolicy policy;
+    LCD_Clock clock;       // all NULL = HAL tick
+    uint32_t grants;
+    bool dispatching;      // transfers can complete (and ask again) inside a dispatch
+    bool redispatch;
+} LCD_Manager;
+
+void LCD_ManagerInit(LCD_Manager *mgr, LCD_SchedPolicy policy, const LCD_Clock *clock);
+// Take over a display on the given bus, starting its async engine if it isn't running.
+// Returns its index, or -1 if the manager is full or the engine can't run.
+int LCD_ManagerAdd(LCD_Manager *mgr, LiquidCrystal_C *lcd, const void *bus, bool use_dma);
+// Deadline policy: how long a transfer of this display may wait for the bus
+void LCD_ManagerSetBudget(LCD_Manager *mgr, int index, uint32_t budget_us);
+void LCD_ManagerTxComplete(LCD_Manager *mgr, const void *bus);
+void LCD_ManagerTxError(LCD_Manager *mgr, const void *bus);
+// Run every engine and start transfers on free buses
+void LCD_ManagerPoll(LCD_Manager *mgr);
+bool LCD_ManagerIsIdle(const LCD_Manager *mgr);
+// Poll until every display is idle, sleeping through delays if the clock can
+void LCD_ManagerWaitIdle(LCD_Manager *mgr);
+void LCD_ManagerGetStats(const LCD_Manager *mgr, int index, LCD_ManagerStats *stats);
+void LCD_ManagerResetStats(LCD_Manager *mgr);
+
+#endif
@@ -0,0 +1,257 @@
+#include "LCD_Ring.h"
+#include <string.h>
+
+#define LCD_RING_MASK   (LCD_RING_SLOTS - 1)
+#define LCD_RING_CELLS  (LCD_MAX_LINES * LCD_MAX_COLS)
+
+#if (LCD_RING_SLOTS & LCD_RING_MASK) != 0
+#error "LCD_RING_SLOTS must be a power of two"
+#endif
+
+/*******************************************************************************
+ * PRODUCER
+ ******************************************************************************/
+// Latest-wins text: straight into the cell mailbox, character first, then the flag
+static void lcd_ringPutCell(LCD_Ring *ring, uint8_t col, uint8_t row, uint8_t value)
+{
+    if (col >= LCD_MAX_COLS || row >= LCD_MAX_LINES) return;
+    uint16_t i = row * LCD_MAX_COLS + col;
+
+    if (ring->cell_dirty[i]) {
+        ring->stats.overwritten++;
+    }
+    ring->cell[i] = value;
+    LCD_RING_BARRIER();
+    ring->cell_dirty[i] = 1;
+    ring->stats.posted++;
+}
+
+bool LCD_RingPost(LCD_Ring *ring, const LCD_RingOp *op)
+{
+    uint32_t tail = ring->tail;
+    uint32_t used = tail - ring->head;
+
+    if (used >= LCD_RING_SLOTS && ring->policy != LCD_RING_DROP_OLDEST) {
+        ring->stats.dropped_newest++;
+        return false;
+    }
+
+    // With DROP_OLDEST this may overwrite the slot the consumer is about to read; the
+    // sequence number tells it the slot changed under it
+    LCD_RingSlot *slot = &ring->slots[tail & LCD_RING_MASK];
+    slot->seq = 2 * tail + 1;
+    LCD_RING_BARRIER();
+    slot->op = *op;
+    LCD_RING_BARRIER();
+    slot->seq = 2 * tail + 2;
+    LCD_RING_BARRIER();
+    ring->tail = tail + 1;
+
+    used = (used < LCD_RING_SLOTS) ? used + 1 : LCD_RING_SLOTS;
+    if (used > ring->stats.high_water) {
+        ring->stats.high_water = (uint16_t)used;
+    }
+    ring->stats.posted++;
+    return true;
+}
+
+bool LCD_RingWrite(LCD_Ring *ring, uint8_t col, uint8_t row, const char *str)
+{
+    bool ok = true;
+
+    if (ring->policy == LCD_RING_LATEST_WINS) {
+        while (*str && col < LCD_MAX_COLS) {
+            lcd_ringPutCell(ring, col++, row, (uint8_t)*str++);
+        }
+        return true;
+    }
+    while (*str) {
+        LCD_RingOp op = { LCD_RING_OP_TEXT, col, row, 0, {0} };
+        while (*str && op.len < LCD_RING_TEXT_MAX) {
+            op.data[op.len++] = (uint8_t)*str++;
+        }
+        ok &= LCD_RingPost(ring, &op);
+        col += op.len;
+    }
+    return ok;
+}
+
+bool LCD_RingPutChar(LCD_Ring *ring, uint8_t col, uint8_t row, uint8_t value)
+{
+    if (ring->policy == LCD_RING_LATEST_WINS) {
+        lcd_ringPutCell(ring, col, row, value);
+        return true;
+    }
+    LCD_RingOp op = { LCD_RING_OP_TEXT, col, row, 1, { value } };
+    return LCD_RingPost(ring, &op);
+}
+
+bool LCD_RingClear(LCD_Ring *ring)
+{
+    if (ring->policy == LCD_RING_LATEST_WINS) {
+        // Blank every cell, so text posted after the clear isn't wiped by it
+        for (uint8_t row = 0; row < LCD_MAX_LINES; row++) {
+            for (uint8_t col = 0; col < LCD_MAX_COLS; col++) {
+                lcd_ringPutCell(ring, col, row, ' ');
+            }
+        }
+        return true;
+    }
+    LCD_RingOp op = { LCD_RING_OP_CLEAR, 0, 0, 0, {0} };
+    return LCD_RingPost(ring, &op);
+}
+
+bool LCD_RingCreateChar(LCD_Ring *ring, uint8_t location, const uint8_t charmap[8])
+{
+    LCD_RingOp op = { LCD_RING_OP_GLYPH, (uint8_t)(location & 0x07), 0, 8, {0} };
+    memcpy(op.data, charmap, 8);
+    return LCD_RingPost(ring, &op);
+}
+
+bool LCD_RingSetBacklight(LCD_Ring *ring, bool on)
+{
+    LCD_RingOp op = { LCD_RING_OP_BACKLIGHT, on, 0, 0, {0} };
+    return LCD_RingPost(ring, &op);
+}
+
+bool LCD_RingDisplay(LCD_Ring *ring, bool on)
+{
+    LCD_RingOp op = { LCD_RING_OP_DISPLAY, on, 0, 0, {0} };
+    return LCD_RingPost(ring, &op);
+}
+
+/*******************************************************************************
+ * CONSUMER
+ ******************************************************************************/
+// Take the oldest operation. False if the ring is empty.
+static bool lcd_ringPop(LCD_Ring *ring, LCD_RingOp *op)
+{
+    for (;;) {
+        uint32_t head = ring->head;
+        uint32_t tail = ring->tail;
+        LCD_RING_BARRIER();
+        if (head == tail) return false;
+        if (tail - head > LCD_RING_SLOTS) {
+            // The producer went round the ring: what it overwrote is gone
+            ring->stats.dropped_oldest += tail - head - LCD_RING_SLOTS;
+            head = tail - LCD_RING_SLOTS;
+            ring->head = head;
+        }
+
+        const LCD_RingSlot *slot = &ring->slots[head & LCD_RING_MASK];
+        uint32_t seq = slot->seq;
+        LCD_RING_BARRIER();
+        *op = slot->op;
+        LCD_RING_BARRIER();
+        if (seq == 2 * head + 2 && slot->seq == seq) {
+            ring->head = head + 1;
+            return true;
+        }
+        // Overwritten while it was read: look again once the producer has moved on
+    }
+}
+
+static bool lcd_ringTouch(uint8_t *touched, uint16_t i)
+{
+    bool again = touched[i >> 3] & (1 << (i & 7));
+    touched[i >> 3] |= 1 << (i & 7);
+    return again;
+}
+
+void LCD_RingInit(LCD_Ring *ring, LiquidCrystal_C *lcd, LCD_RingPolicy policy)
+{
+    memset(ring, 0, sizeof(*ring));
+    ring->lcd = lcd;
+    ring->policy = policy;
+}
+
+uint16_t LCD_RingDrain(LCD_Ring *ring, uint16_t max_ops)
+{
+    LiquidCrystal_C *lcd = ring->lcd;
+    uint8_t touched[(LCD_RING_CELLS + 7) / 8] = {0}; // cells drawn during this drain
+    uint8_t glyph_rows[8][8];
+    uint8_t glyphs = 0;
+    int8_t backlight = -1;
+    int8_t display = -1;
+    uint16_t applied = 0;
+    LCD_RingOp op;
+
+    // Everything lands in the framebuffer or in the latest-state variables first, so
+    // later operations on the same cells, glyphs and settings replace earlier ones
+    while ((max_ops == 0 || applied < max_ops) && lcd_ringPop(ring, &op)) {
+        applied++;
+        switch (op.op) {
+        case LCD_RING_OP_TEXT:
+            for (uint8_t n = 0; n < op.len && op.len <= LCD_RING_TEXT_MAX; n++) {
+                uint8_t col = op.col + n;
+                if (col >= lcd->numcols || op.row >= lcd->numlines) break;
+                if (lcd_ringTouch(touched, op.row * LCD_MAX_COLS + col)) ring->stats.merged++;
+                LCD_FbPutChar(lcd, col, op.row, op.data[n]);
+            }
+            break;
+        case LCD_RING_OP_CLEAR:
+            for (uint16_t i = 0; i < sizeof(touched); i++) {
+                for (uint8_t b = touched[i]; b != 0; b &= b - 1) ring->stats.merged++;
+                touched[i] = 0;
+            }
+            LCD_FbClear(lcd);
+            break;
+        case LCD_RING_OP_GLYPH:
+            if (glyphs & (1 << op.col)) ring->stats.merged++;
+            glyphs |= 1 << op.col;
+            memcpy(glyph_rows[op.col], op.data, 8);
+            break;
+        case LCD_RING_OP_BACKLIGHT:
+            if (backlight >= 0) ring->stats.merged++;
+            backlight = op.col != 0;
+            break;
+        case LCD_RING_OP_DISPLAY:
+            if (display >= 0) ring->stats.merged++;
+            display = op.col != 0;
+            break;
+        }
+    }
+    ring->stats.applied += applied;
+    bool changed = applied > 0;
+
+    if (ring->policy == LCD_RING_LATEST_WINS) {
+        for (uint16_t i = 0; i < LCD_RING_CELLS; i++) {
+            if (!ring->cell_dirty[i]) continue;
+            // Clear the flag before reading, so a character posted meanwhile is picked up next time
+            ring->cell_dirty[i] = 0;
+            LCD_RING_BARRIER();
+            LCD_FbPutChar(lcd, i % LCD_MAX_COLS, i / LCD_MAX_COLS, ring->cell[i]);
+            ring->stats.applied++;
+            changed = true;
+        }
+    }
+    if (!changed) return 0;
+
+    ring->stats.drains++;
+    LCD_BeginBurst(lcd);
+    for (uint8_t slot = 0; slot < 8; slot++) {
+        if (glyphs & (1 << slot)) LCD_CreateChar(lcd, slot, glyph_rows[slot]);
+    }
+    if (display == 1) {
+        LCD_Display(lcd);
+    } else if (display == 0) {
+        LCD_NoDisplay(lcd);
+    }
+    if (backlight >= 0) {
+        LCD_SetBacklight(lcd, backlight);
+    }
+    LCD_Flush(lcd);
+    LCD_EndBurst(lcd);
+    return applied;
+}
+
+uint16_t LCD_RingPending(const LCD_Ring *ring)
+{
+    uint32_t used = ring->tail - ring->head;
+    return (uint16_t)((used < LCD_RING_SLOTS) ? used : LCD_RING_SLOTS);
+}
+
+void LCD_RingGetStats(const LCD_Ring *ring, LCD_RingStats *stats)
+{
+    *stats = ring->stats;
+}
@@ -0,0 +1,108 @@
+#ifndef LCD_RING_H
+#define LCD_RING_H
+
+#include "LiquidCrystal_C.h"
+
+/******************************************************************************
+ * Lock-free command ring
+ *
+ * Lets one interrupt handler or high-priority task (the producer) post display
+ * updates without touching the bus, and one background task (the consumer) put
+ * them on the display. Posting copies the operation into a fixed-size slot and
+ * moves the producer's index: constant time, no locks, nothing that waits.
+ * LCD_RingDrain() applies what was posted to the framebuffer and sends it with
+ * one LCD_Flush(), so text posted to the same cells between two drains costs
+ * only the final difference, and glyph, backlight and display updates only go
+ * out in their latest state.
+ *
+ * Exactly one producer and one consumer. The consumer owns the framebuffer:
+ * don't draw into it (or write to the display directly) from anywhere else.
+ * The producer and the consumer may run on different cores if LCD_RING_BARRIER
+ * orders their memory accesses, which the default (__sync_synchronize) does.
+ ******************************************************************************/
+#ifndef LCD_RING_SLOTS
+#define LCD_RING_SLOTS 32 // must be a power of two
+#endif
+#ifndef LCD_RING_BARRIER
+#define LCD_RING_BARRIER() __sync_synchronize()
+#endif
+#define LCD_RING_TEXT_MAX 8 // characters per slot; longer text takes several
+
+// What happens to an operation posted while every slot is full
+typedef enum {
+    LCD_RING_DROP_NEWEST, // it's thrown away
+    LCD_RING_DROP_OLDEST, // it replaces the oldest operation still in the ring
+    LCD_RING_LATEST_WINS  // text never queues: each cell keeps only its latest character,
+                          // other operations drop the newest when full
+} LCD_RingPolicy;
+
+typedef enum {
+    LCD_RING_OP_TEXT,
+    LCD_RING_OP_CLEAR,
+    LCD_RING_OP_GLYPH,
+    LCD_RING_OP_BACKLIGHT,
+    LCD_RING_OP_DISPLAY
+} LCD_RingOpcode;
+
+typedef struct {
+    uint8_t op;      // LCD_RingOpcode
+    uint8_t col;     // text: first cell; glyph: CGRAM slot; backlight/display: on
+    uint8_t row;
+    uint8_t len;     // text: characters in data
+    uint8_t data[LCD_RING_TEXT_MAX]; // text, or a glyph's 8 rows
+} LCD_RingOp;
+
+typedef struct {
+    volatile uint32_t seq; // 2 * position + 1 while written, 2 * position + 2 once written
+    LCD_RingOp op;
+} LCD_RingSlot;
+
+typedef struct {
+    // Written by the producer
+    uint32_t posted;         // operations accepted
+    uint32_t dropped_newest; // operations thrown away because the ring was full
+    uint32_t overwritten;    // latest-wins: characters posted over one the consumer hadn't picked up
+    uint16_t high_water;     // most slots in use at once
+    // Written by the consumer
+    uint32_t dropped_oldest; // operations replaced before the consumer got to them
+    uint32_t applied;        // operations taken from the ring (and cells from the cell mailbox)
+    uint32_t merged;         // of those, ones overwritten by a later one in the same drain
+    uint32_t drains;         // drains that had something to send
+} LCD_RingStats;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    LCD_RingPolicy policy;
+    LCD_RingSlot slots[LCD_RING_SLOTS];
+    volatile uint32_t tail;  // next position the producer writes (producer only)
+    volatile uint32_t head;  // next position the consumer reads (consumer only)
+    // LCD_RING_LATEST_WINS: latest character posted to each framebuffer cell, and
+    // whether the consumer has yet to pick it up
+    volatile uint8_t cell[LCD_MAX_LINES * LCD_MAX_COLS];
+    volatile uint8_t cell_dirty[LCD_MAX_LINES * LCD_MAX_COLS];
+    LCD_RingStats stats;
+} LCD_Ring;
+
+// Call before either side runs. The display must have been started with LCD_Begin().
+void LCD_RingInit(LCD_Ring *ring, LiquidCrystal_C *lcd, LCD_RingPolicy policy);
+
+// Producer side. Each returns false if (part of) the operation was dropped.
+bool LCD_RingPost(LCD_Ring *ring, const LCD_RingOp *op);
+// Text at (col, row), clipped at the end of the row by the consumer
+bool LCD_RingWrite(LCD_Ring *ring, uint8_t col, uint8_t row, const char *str);
+bool LCD_RingPutChar(LCD_Ring *ring, uint8_t col, uint8_t row, uint8_t value);
+bool LCD_RingClear(LCD_Ring *ring);
+bool LCD_RingCreateChar(LCD_Ring *ring, uint8_t location, const uint8_t charmap[8]);
+bool LCD_RingSetBacklight(LCD_Ring *ring, bool on);
+bool LCD_RingDisplay(LCD_Ring *ring, bool on);
+
+// Consumer side. Apply up to max_ops operations (0 = everything posted so far) and
+// send the result. Returns the number of operations applied.
+uint16_t LCD_RingDrain(LCD_Ring *ring, uint16_t max_ops);
+// Slots in use right now
+uint16_t LCD_RingPending(const LCD_Ring *ring);
+
+// Counters written by the other side may be a drain or a post behind
+void LCD_RingGetStats(const LCD_Ring *ring, LCD_RingStats *stats);
+
+#endif
@@ -0,0 +1,317 @@
+#include "LCD_Trace.h"
+#include <string.h>
+#include "stm32f4xx_hal.h" // For HAL_GetTick. Replace with stm32f1xx_hal.h or whatever hardware you're using
+
+// Record header byte: sync, how the value changed, time since the last value
+#define LCD_TRACE_SYNC    0x80
+#define LCD_TRACE_OP(h)   (((h) >> 4) & 0x07) // 0 = value follows, else XOR with toggles[op - 1]
+#define LCD_TRACE_DT_MAX  15                  // dt field 15: a varint of dt - 15 follows
+#define LCD_TRACE_RECORD_MAX 8                // header, 5 byte varint, 2 byte value
+
+#define LCD_TRACE_FLAG_FOUR_BIT 0x01
+#define LCD_TRACE_FLAG_WRAPPED  0x02
+
+/*******************************************************************************
+ * ENCODING
+ ******************************************************************************/
+static uint16_t lcd_traceBit(uint8_t pin)
+{
+    return (pin < 16) ? (uint16_t)(1u << pin) : 0;
+}
+
+// Value changes that take no bytes besides the header. 0 first: a repeated value.
+static void lcd_traceToggles(const LCD_TraceHeader *h, uint16_t toggles[LCD_TRACE_TOGGLES])
+{
+    uint16_t e1 = lcd_traceBit(h->enable_pins[0]);
+    uint16_t e2 = (h->num_ctrl > 1) ? lcd_traceBit(h->enable_pins[1]) : 0;
+
+    toggles[0] = 0;
+    toggles[1] = e1;
+    toggles[2] = e2;
+    toggles[3] = e1 | e2;
+    toggles[4] = lcd_traceBit(h->rs_pin);
+    toggles[5] = lcd_traceBit(h->rw_pin);
+    toggles[6] = lcd_traceBit(h->backlight_pin);
+}
+
+static uint8_t lcd_traceByte(const LCD_Trace *trace, uint32_t pos)
+{
+    return trace->buf[pos % trace->size];
+}
+
+// Decode the record at pos of a ring of size bytes, applying it to value and us. Returns its length.
+static uint32_t lcd_traceDecode(const uint8_t *buf, uint32_t size, uint32_t pos, uint8_t width,
+                                const uint16_t *toggles, uint16_t *value, uint32_t *us)
+{
+    uint32_t start = pos;
+    uint8_t h = buf[pos++ % size];
+    uint32_t dt = h & 0x0F;
+
+    if (dt == LCD_TRACE_DT_MAX) {
+        uint32_t extra = 0;
+        for (uint8_t shift = 0; shift < 35; shift += 7) {
+            uint8_t b = buf[pos++ % size];
+            extra |= (uint32_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        dt += extra;
+    }
+    uint8_t op = LCD_TRACE_OP(h);
+    if (op == 0) {
+        *value = buf[pos++ % size];
+        if (width > 1) {
+            *value |= (uint16_t)(buf[pos++ % size] << 8);
+        }
+    } else {
+        *value ^= toggles[op - 1];
+    }
+    *us += dt;
+    return pos - start;
+}
+
+// Drop the oldest record, moving the start of the trace past it
+static void lcd_traceDropOldest(LCD_Trace *trace)
+{
+    uint32_t len = lcd_traceDecode(trace->buf, trace->size, trace->tail, trace->header.width, trace->toggles,
+                                   &trace->header.start_value, &trace->header.start_us);
+    trace->tail = (trace->tail + len) % trace->size;
+    trace->used -= len;
+    trace->header.dropped++;
+    trace->header.wrapped = true;
+    trace->stats.dropped++;
+}
+
+static void lcd_traceTap(void *ctx, uint16_t value, uint32_t now_us, bool sync)
+{
+    LCD_Trace *trace = (LCD_Trace *)ctx;
+    uint8_t rec[LCD_TRACE_RECORD_MAX];
+    uint8_t len = 1;
+    uint32_t dt = now_us - trace->us;
+    uint8_t op = 0;
+
+    for (uint8_t i = 0; i < LCD_TRACE_TOGGLES; i++) {
+        if ((uint16_t)(value ^ trace->value) == trace->toggles[i]) {
+            op = i + 1;
+            break;
+        }
+    }
+    rec[0] = (sync ? LCD_TRACE_SYNC : 0) | (uint8_t)(op << 4);
+    if (dt < LCD_TRACE_DT_MAX) {
+        rec[0] |= (uint8_t)dt;
+    } else {
+        rec[0] |= LCD_TRACE_DT_MAX;
+        uint32_t extra = dt - LCD_TRACE_DT_MAX;
+        while (extra >= 0x80) {
+            rec[len++] = (uint8_t)(extra | 0x80);
+            extra >>= 7;
+        }
+        rec[len++] = (uint8_t)extra;
+    }
+    if (op == 0) {
+        rec[len++] = (uint8_t)value;
+        if (trace->header.width > 1) {
+            rec[len++] = (uint8_t)(value >> 8);
+        }
+    }
+    if (len > trace->size) return;
+
+    // Make room, then keep dropping up to the start of a byte
+    if (trace->size - trace->used < len) {
+        while (trace->size - trace->used < len) {
+            lcd_traceDropOldest(trace);
+        }
+        while (trace->used > 0 && !(lcd_traceByte(trace, trace->tail) & LCD_TRACE_SYNC)) {
+            lcd_traceDropOldest(trace);
+        }
+    }
+    for (uint8_t i = 0; i < len; i++) {
+        trace->buf[trace->head] = rec[i];
+        trace->head = (trace->head + 1 == trace->size) ? 0 : trace->head + 1;
+    }
+    trace->used += len;
+    trace->value = value;
+    trace->us = now_us;
+    trace->stats.values++;
+}
+
+/*******************************************************************************
+ * RECORDING
+ ******************************************************************************/
+void LCD_TraceInit(LCD_Trace *trace, uint8_t *buf, uint32_t size)
+{
+    memset(trace, 0, sizeof(*trace));
+    trace->buf  = buf;
+    trace->size = size;
+}
+
+void LCD_TraceAttach(LCD_Trace *trace, LiquidCrystal_C *lcd)
+{
+    LCD_TraceHeader *h = &trace->header;
+
+    trace->lcd = lcd;
+    h->width    = lcd->transport.value_bytes;
+    h->four_bit = !(lcd->displayfunction & LCD_8BITMODE);
+    h->rs_pin   = lcd->rs_pin;
+    h->rw_pin   = lcd->rw_pin;
+    h->enable_pins[0] = lcd->enable_pins[0];
+    h->enable_pins[1] = (LCD_MAX_CONTROLLERS > 1 && lcd->num_ctrl > 1) ? lcd->enable_pins[1] : 0xFF;
+    memcpy(h->data_pins, lcd->data_pins, sizeof(h->data_pins));
+    h->backlight_pin = lcd->backlight_pin;
+    h->num_ctrl = (lcd->num_ctrl > 2) ? 2 : lcd->num_ctrl;
+    lcd_traceToggles(h, trace->toggles);
+
+    LCD_TraceClear(trace);
+    LCD_SetTap(lcd, lcd_traceTap, trace);
+}
+
+void LCD_TraceDetach(LCD_Trace *trace)
+{
+    if (trace->lcd != NULL && trace->lcd->tap_ctx == trace) {
+        LCD_SetTap(trace->lcd, NULL, NULL);
+    }
+}
+
+void LCD_TraceClear(LCD_Trace *trace)
+{
+    LiquidCrystal_C *lcd = trace->lcd;
+
+    trace->head = 0;
+    trace->tail = 0;
+    trace->used = 0;
+    memset(&trace->stats, 0, sizeof(trace->stats));
+    if (lcd == NULL) return;
+
+    trace->value = lcd->gpio_shadow;
+    trace->us = (lcd->clock.now_us != NULL) ? lcd->clock.now_us(lcd->clock.ctx) : HAL_GetTick() * 1000;
+    trace->header.start_value = trace->value;
+    trace->header.start_us    = trace->us;
+    trace->header.dropped     = 0;
+    trace->header.wrapped     = false;
+    lcd->tap_sync = true;
+}
+
+static void lcd_tracePut32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t lcd_traceGet32(const uint8_t *p)
+{
+    return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void LCD_TraceDump(const LCD_Trace *trace, LCD_TraceWriteFn write, void *ctx)
+{
+    const LCD_TraceHeader *h = &trace->header;
+    uint8_t out[LCD_TRACE_HEADER_BYTES];
+
+    // Little endian throughout
+    memcpy(out, LCD_TRACE_MAGIC, 4);
+    out[4] = LCD_TRACE_VERSION;
+    out[5] = h->width;
+    out[6] = (h->four_bit ? LCD_TRACE_FLAG_FOUR_BIT : 0) | (h->wrapped ? LCD_TRACE_FLAG_WRAPPED : 0);
+    out[7] = h->rs_pin;
+    out[8] = h->rw_pin;
+    out[9] = h->enable_pins[0];
+    out[10] = h->enable_pins[1];
+    memcpy(&out[11], h->data_pins, 8);
+    out[19] = h->backlight_pin;
+    out[20] = h->num_ctrl;
+    // The geometry is only known once LCD_Begin() has run
+    out[21] = (trace->lcd != NULL) ? trace->lcd->numcols : 0;
+    out[22] = (trace->lcd != NULL) ? trace->lcd->numlines : 0;
+    out[23] = 0;
+    out[24] = (uint8_t)h->start_value;
+    out[25] = (uint8_t)(h->start_value >> 8);
+    out[26] = 0;
+    out[27] = 0;
+    lcd_tracePut32(&out[28], h->start_us);
+    lcd_tracePut32(&out[32], h->dropped);
+    lcd_tracePut32(&out[36], trace->used);
+    write(ctx, out, sizeof(out));
+
+    // The records, in at most two pieces
+    uint32_t first = trace->size - trace->tail;
+    if (first > trace->used) first = trace->used;
+    if (first > 0) {
+        write(ctx, &trace->buf[trace->tail], first);
+    }
+    if (trace->used > first) {
+        write(ctx, trace->buf, trace->used - first);
+    }
+}
+
+uint32_t LCD_TraceDumpSize(const LCD_Trace *trace)
+{
+    return LCD_TRACE_HEADER_BYTES + trace->used;
+}
+
+void LCD_TraceGetStats(const LCD_Trace *trace, LCD_TraceStats *stats)
+{
+    *stats = trace->stats;
+    stats->used = trace->used;
+    stats->span_us = trace->us - trace->header.start_us;
+}
+
+/*******************************************************************************
+ * READING
+ ******************************************************************************/
+bool LCD_TraceOpen(LCD_TraceReader *reader, const uint8_t *dump, uint32_t len)
+{
+    LCD_TraceHeader *h = &reader->header;
+
+    if (len < LCD_TRACE_HEADER_BYTES || memcmp(dump, LCD_TRACE_MAGIC, 4) != 0 ||
+        dump[4] != LCD_TRACE_VERSION) {
+        return false;
+    }
+    h->width    = dump[5];
+    h->four_bit = dump[6] & LCD_TRACE_FLAG_FOUR_BIT;
+    h->wrapped  = dump[6] & LCD_TRACE_FLAG_WRAPPED;
+    h->rs_pin   = dump[7];
+    h->rw_pin   = dump[8];
+    h->enable_pins[0] = dump[9];
+    h->enable_pins[1] = dump[10];
+    memcpy(h->data_pins, &dump[11], 8);
+    h->backlight_pin = dump[19];
+    h->num_ctrl = dump[20];
+    h->cols     = dump[21];
+    h->lines    = dump[22];
+    h->start_value = dump[24] | (uint16_t)(dump[25] << 8);
+    h->start_us = lcd_traceGet32(&dump[28]);
+    h->dropped  = lcd_traceGet32(&dump[32]);
+    h->length   = lcd_traceGet32(&dump[36]);
+    if (h->width < 1 || h->width > 2 || h->num_ctrl < 1 || h->num_ctrl > 2 ||
+        h->length > len - LCD_TRACE_HEADER_BYTES) {
+        return false;
+    }
+
+    lcd_traceToggles(h, reader->toggles);
+    reader->data  = dump + LCD_TRACE_HEADER_BYTES;
+    reader->pos   = 0;
+    reader->value = h->start_value;
+    reader->us    = h->start_us;
+    return true;
+}
+
+bool LCD_TraceNext(LCD_TraceReader *reader, uint16_t *value, uint32_t *us, bool *sync)
+{
+    const LCD_TraceHeader *h = &reader->header;
+
+    // A record is at most LCD_TRACE_RECORD_MAX bytes: check the short ones at the end
+    if (reader->pos >= h->length) return false;
+    uint8_t rec[LCD_TRACE_RECORD_MAX] = { 0 };
+    uint32_t avail = h->length - reader->pos;
+    memcpy(rec, &reader->data[reader->pos], avail < sizeof(rec) ? avail : sizeof(rec));
+
+    uint32_t len = lcd_traceDecode(rec, sizeof(rec), 0, h->width, reader->toggles,
+                                   &reader->value, &reader->us);
+    if (len > avail) return false;
+    reader->pos += len;
+    *value = reader->value;
+    *us = reader->us;
+    *sync = rec[0] & LCD_TRACE_SYNC;
+    return true;
+}
@@ -0,0 +1,109 @@
+#ifndef LCD_TRACE_H
+#define LCD_TRACE_H
+
+#include "LiquidCrystal_C.h"
+
+/******************************************************************************
+ * GPIO trace
+ *
+ * Records every GPIO value the driver sends, with the time it was handed to
+ * the transport, into a ring buffer given by the caller, so that what a unit
+ * in the field actually sent to its display can be looked at afterwards. Once
+ * the buffer is full the oldest records make room, always up to the start of
+ * a byte, so the trace keeps the latest traffic and can be decoded from its
+ * first record.
+ *
+ * Records are delta encoded: one header byte holding the time since the last
+ * value (up to 14 us; longer gaps add a varint) and how the value changed. The
+ * usual changes (an enable line going up or down, RS, RW or the backlight
+ * toggling, a value repeated to pad a wait) take no more bytes; anything else
+ * adds the value itself. A 4-bit transfer costs about 8 bytes per character
+ * sent, idle time costs nothing, so a few KB keep the last several seconds of
+ * a typical UI.
+ *
+ * LCD_TraceDump() writes a header (the pin map and geometry) and the records to
+ * any byte sink: a UART, a debug probe or a file. The reader functions below
+ * walk a dump; host/lcd_replay feeds them into the HD44780 model to get back
+ * the instructions and the final screen.
+ *
+ * Timestamps come from the handle's clock (LCD_SetClock), or the 1 ms HAL tick
+ * without one. With bursts or the async engine they're the times values were
+ * queued, not the times they reached the pins.
+ ******************************************************************************/
+#define LCD_TRACE_MAGIC   "LCDT"
+#define LCD_TRACE_VERSION 1
+#define LCD_TRACE_HEADER_BYTES 40 // size of the dump header
+#define LCD_TRACE_TOGGLES 7       // value changes encoded without the value
+
+// Pin map and geometry of the traced display, and where the records start
+typedef struct {
+    uint8_t width;          // bytes per GPIO value (1 or 2)
+    bool four_bit;          // 4-bit interface: D4..D7 are data_pins[0..3]
+    bool wrapped;           // older records were dropped: the trace starts at a byte
+    uint8_t rs_pin, rw_pin; // 255 = not wired
+    uint8_t enable_pins[2];
+    uint8_t data_pins[8];
+    uint8_t backlight_pin;
+    uint8_t num_ctrl;
+    uint8_t cols, lines;
+    uint16_t start_value;   // GPIO value before the first record
+    uint32_t start_us;      // and its time
+    uint32_t dropped;       // records dropped before the first one
+    uint32_t length;        // bytes of records
+} LCD_TraceHeader;
+
+typedef struct {
+    uint32_t values;  // GPIO values recorded
+    uint32_t dropped; // of those, dropped to make room
+    uint32_t used;    // bytes of records in the buffer
+    uint32_t span_us; // time covered by the records kept
+} LCD_TraceStats;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    uint8_t *buf;
+    uint32_t size;
+    uint32_t head, tail; // next byte written, oldest record
+    uint32_t used;
+    uint16_t toggles[LCD_TRACE_TOGGLES];
+    // Newest value and its time, for the next delta
+    uint16_t value;
+    uint32_t us;
+    LCD_TraceHeader header; // start_value/start_us follow the oldest record
+    LCD_TraceStats stats;
+} LCD_Trace;
+
+// Walks the records of a dump
+typedef struct {
+    LCD_TraceHeader header;
+    const uint8_t *data;
+    uint32_t pos;
+    uint16_t toggles[LCD_TRACE_TOGGLES];
+    uint16_t value;
+    uint32_t us;
+} LCD_TraceReader;
+
+// Byte sink for LCD_TraceDump(), called a few times per dump
+typedef void (*LCD_TraceWriteFn)(void *ctx, const uint8_t *data, uint32_t len);
+
+// Record into buf (a few KB; at least 64 bytes to be useful)
+void LCD_TraceInit(LCD_Trace *trace, uint8_t *buf, uint32_t size);
+// Start recording lcd's traffic: call once the pins are set up (LCD_Init(), LCD_AddController(),
+// LCD_SetTransport()), before or after LCD_Begin(). Replaces any tap already set on lcd.
+void LCD_TraceAttach(LCD_Trace *trace, LiquidCrystal_C *lcd);
+void LCD_TraceDetach(LCD_Trace *trace);
+// Forget every record; the next one starts a byte
+void LCD_TraceClear(LCD_Trace *trace);
+// Write the header and the records, oldest first. Don't let write touch the display:
+// what it sends while attached would land in the trace being dumped.
+void LCD_TraceDump(const LCD_Trace *trace, LCD_TraceWriteFn write, void *ctx);
+// Bytes LCD_TraceDump() writes
+uint32_t LCD_TraceDumpSize(const LCD_Trace *trace);
+void LCD_TraceGetStats(const LCD_Trace *trace, LCD_TraceStats *stats);
+
+// Read the header of a dump of len bytes. False if it isn't one or is cut short.
+bool LCD_TraceOpen(LCD_TraceReader *reader, const uint8_t *dump, uint32_t len);
+// Next record: its GPIO value, time and whether it starts a byte. False at the end.
+bool LCD_TraceNext(LCD_TraceReader *reader, uint16_t *value, uint32_t *us, bool *sync);
+
+#endif
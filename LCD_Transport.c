@@ -0,0 +1,380 @@
+#include "LCD_Transport.h"
+#include <string.h>
+
+#define LCD_TRANSPORT_TIMEOUT 10 // ms, for blocking HAL transfers
+
+// Hold a value on the pins for 'us' microseconds, on the backend's clock or the driver's
+// calibrated spin loop without one
+static void lcd_transportHold(const LCD_Clock *clock, uint32_t us)
+{
+    if (us == 0) return;
+    if (clock->delay_us != NULL) {
+        clock->delay_us(clock->ctx, us);
+    } else if (clock->now_us != NULL) {
+        uint32_t start = clock->now_us(clock->ctx);
+        while ((clock->now_us(clock->ctx) - start) < us) {
+        }
+    } else {
+        LCD_SpinUs(us);
+    }
+}
+
+static void lcd_transportSetClock(LCD_Clock *dst, const LCD_Clock *clock)
+{
+    if (clock != NULL) {
+        *dst = *clock;
+    } else {
+        dst->now_us   = NULL;
+        dst->delay_us = NULL;
+        dst->ctx      = NULL;
+    }
+}
+
+#ifdef HAL_I2C_MODULE_ENABLED
+/*******************************************************************************
+ * PCF8574
+ ******************************************************************************/
+static bool lcd_pcfWrite(void *ctx, const uint8_t *values, uint16_t len)
+{
+    LCD_PCF8574 *port = (LCD_PCF8574 *)ctx;
+    uint8_t buf[LCD_BURST_BUFSIZE];
+    const uint8_t *out = values;
+
+    if (len == 0) return true;
+    // Released pins have to be written high or the PCF8574 pulls them low
+    if (port->inputs != 0) {
+        if (len > LCD_BURST_BUFSIZE) len = LCD_BURST_BUFSIZE;
+        for (uint16_t i = 0; i < len; i++) {
+            buf[i] = values[i] | port->inputs;
+        }
+        out = buf;
+    }
+    port->last = out[len - 1];
+    return HAL_I2C_Master_Transmit(port->hi2c, port->addr << 1, (uint8_t *)out, len,
+                                   LCD_TRANSPORT_TIMEOUT) == HAL_OK;
+}
+
+static bool lcd_pcfRead(void *ctx, uint16_t *levels)
+{
+    LCD_PCF8574 *port = (LCD_PCF8574 *)ctx;
+    uint8_t value = 0;
+    bool ok = HAL_I2C_Master_Receive(port->hi2c, port->addr << 1, &value, 1, LCD_TRANSPORT_TIMEOUT) == HAL_OK;
+
+    *levels = value;
+    return ok;
+}
+
+// There are no direction registers: an input is a pin written high
+static bool lcd_pcfSetInputs(void *ctx, uint16_t mask)
+{
+    LCD_PCF8574 *port = (LCD_PCF8574 *)ctx;
+    uint8_t value = (port->last & ~port->inputs) | (uint8_t)mask;
+
+    port->inputs = (uint8_t)mask;
+    return lcd_pcfWrite(ctx, &value, 1);
+}
+
+// The async engine never reads, so no pins are released while it runs
+static bool lcd_pcfWriteAsync(void *ctx, const uint8_t *values, uint16_t len, bool dma)
+{
+    LCD_PCF8574 *port = (LCD_PCF8574 *)ctx;
+    HAL_StatusTypeDef status;
+
+    port->last = values[len - 1];
+    if (dma) {
+        status = HAL_I2C_Master_Transmit_DMA(port->hi2c, port->addr << 1, (uint8_t *)values, len);
+    } else {
+        status = HAL_I2C_Master_Transmit_IT(port->hi2c, port->addr << 1, (uint8_t *)values, len);
+    }
+    return status == HAL_OK;
+}
+
+static const LCD_TransportOps lcd_pcfOps = {
+    lcd_pcfWrite, lcd_pcfRead, lcd_pcfSetInputs, lcd_pcfWriteAsync
+};
+
+void LCD_TransportPCF8574(LCD_Transport *t, LCD_PCF8574 *port, I2C_HandleTypeDef *hi2c, uint8_t addr)
+{
+    port->hi2c   = hi2c;
+    port->addr   = addr;
+    port->inputs = 0;
+    port->last   = 0;
+
+    t->ops           = &lcd_pcfOps;
+    t->ctx           = port;
+    t->caps          = LCD_TRANSPORT_BURST | LCD_TRANSPORT_READ | LCD_TRANSPORT_ASYNC;
+    t->value_bytes   = 1;
+    t->max_batch     = 0;
+    t->transfer_bits = 11; // START, address, STOP: no register byte
+    t->value_bits    = 9;
+    t->read_bits     = 20;
+}
+
+/*******************************************************************************
+ * MCP23017
+ ******************************************************************************/
+// With IOCON.BANK = 0 and SEQOP set, the address pointer toggles between the A and B
+// registers of a pair, so any number of GPIO values stream into GPIOA/GPIOB in one write
+static bool lcd_mcp23017Write(void *ctx, const uint8_t *values, uint16_t len)
+{
+    LCD_MCP23017 *port = (LCD_MCP23017 *)ctx;
+
+    return HAL_I2C_Mem_Write(port->hi2c, port->addr << 1, LCD_MCP23017_GPIOA, I2C_MEMADD_SIZE_8BIT,
+                             (uint8_t *)values, len, LCD_TRANSPORT_TIMEOUT) == HAL_OK;
+}
+
+static bool lcd_mcp23017Read(void *ctx, uint16_t *levels)
+{
+    LCD_MCP23017 *port = (LCD_MCP23017 *)ctx;
+    uint8_t ab[2] = {0};
+    bool ok = HAL_I2C_Mem_Read(port->hi2c, port->addr << 1, LCD_MCP23017_GPIOA, I2C_MEMADD_SIZE_8BIT,
+                               ab, 2, LCD_TRANSPORT_TIMEOUT) == HAL_OK;
+
+    *levels = ab[0] | (ab[1] << 8);
+    return ok;
+}
+
+static bool lcd_mcp23017SetInputs(void *ctx, uint16_t mask)
+{
+    LCD_MCP23017 *port = (LCD_MCP23017 *)ctx;
+    uint8_t ab[2] = { (uint8_t)mask, (uint8_t)(mask >> 8) };
+
+    return HAL_I2C_Mem_Write(port->hi2c, port->addr << 1, LCD_MCP23017_IODIRA, I2C_MEMADD_SIZE_8BIT,
+                             ab, 2, LCD_TRANSPORT_TIMEOUT) == HAL_OK;
+}
+
+static bool lcd_mcp23017WriteAsync(void *ctx, const uint8_t *values, uint16_t len, bool dma)
+{
+    LCD_MCP23017 *port = (LCD_MCP23017 *)ctx;
+    HAL_StatusTypeDef status;
+
+    if (dma) {
+        status = HAL_I2C_Mem_Write_DMA(port->hi2c, port->addr << 1, LCD_MCP23017_GPIOA,
+                                       I2C_MEMADD_SIZE_8BIT, (uint8_t *)values, len);
+    } else {
+        status = HAL_I2C_Mem_Write_IT(port->hi2c, port->addr << 1, LCD_MCP23017_GPIOA,
+                                      I2C_MEMADD_SIZE_8BIT, (uint8_t *)values, len);
+    }
+    return status == HAL_OK;
+}
+
+static const LCD_TransportOps lcd_mcp23017Ops = {
+    lcd_mcp23017Write, lcd_mcp23017Read, lcd_mcp23017SetInputs, lcd_mcp23017WriteAsync
+};
+
+bool LCD_TransportMCP23017(LCD_Transport *t, LCD_MCP23017 *port, I2C_HandleTypeDef *hi2c, uint8_t addr)
+{
+    // After reset IOCON is at 0x0A (BANK = 0). Keep BANK = 0, set SEQOP, then make every pin an output.
+    uint8_t iocon = LCD_MCP23017_SEQOP;
+    uint8_t iodir[2] = { 0x00, 0x00 };
+
+    port->hi2c = hi2c;
+    port->addr = addr;
+    if (HAL_I2C_Mem_Write(hi2c, addr << 1, LCD_MCP23017_IOCON, I2C_MEMADD_SIZE_8BIT,
+                          &iocon, 1, LCD_TRANSPORT_TIMEOUT) != HAL_OK) {
+        return false;
+    }
+    if (HAL_I2C_Mem_Write(hi2c, addr << 1, LCD_MCP23017_IODIRA, I2C_MEMADD_SIZE_8BIT,
+                          iodir, 2, LCD_TRANSPORT_TIMEOUT) != HAL_OK) {
+        return false;
+    }
+
+    t->ops           = &lcd_mcp23017Ops;
+    t->ctx           = port;
+    t->caps          = LCD_TRANSPORT_BURST | LCD_TRANSPORT_READ | LCD_TRANSPORT_ASYNC | LCD_TRANSPORT_LOW_FIRST;
+    t->value_bytes   = 2;
+    t->max_batch     = 0;
+    t->transfer_bits = LCD_I2C_OVERHEAD_BITS;
+    t->value_bits    = 2 * LCD_I2C_BYTE_BITS;
+    t->read_bits     = LCD_I2C_READ_BITS + LCD_I2C_BYTE_BITS;
+    return true;
+}
+#endif
+
+#ifdef HAL_SPI_MODULE_ENABLED
+/*******************************************************************************
+ * 74HC595
+ ******************************************************************************/
+static bool lcd_hc595Write(void *ctx, const uint8_t *values, uint16_t len)
+{
+    LCD_HC595 *sr = (LCD_HC595 *)ctx;
+    bool ok = true;
+
+    // Each value needs its own latch pulse, or the pins would skip straight to the last one
+    for (uint16_t i = 0; i < len; i++) {
+        if (HAL_SPI_Transmit(sr->hspi, (uint8_t *)&values[i], 1, LCD_TRANSPORT_TIMEOUT) != HAL_OK) {
+            ok = false;
+        }
+        HAL_GPIO_WritePin(sr->latch_port, sr->latch_pin, GPIO_PIN_SET);
+        HAL_GPIO_WritePin(sr->latch_port, sr->latch_pin, GPIO_PIN_RESET);
+        lcd_transportHold(&sr->clock, sr->hold_us);
+    }
+    return ok;
+}
+
+static const LCD_TransportOps lcd_hc595Ops = {
+    lcd_hc595Write, NULL, NULL, NULL
+};
+
+void LCD_TransportHC595(LCD_Transport *t, LCD_HC595 *sr, SPI_HandleTypeDef *hspi,
+                        GPIO_TypeDef *latch_port, uint16_t latch_pin)
+{
+    sr->hspi       = hspi;
+    sr->latch_port = latch_port;
+    sr->latch_pin  = latch_pin;
+    sr->hold_us    = 0;
+    lcd_transportSetClock(&sr->clock, NULL);
+    HAL_GPIO_WritePin(latch_port, latch_pin, GPIO_PIN_RESET);
+
+    t->ops           = &lcd_hc595Ops;
+    t->ctx           = sr;
+    t->caps          = LCD_TRANSPORT_BURST;
+    t->value_bytes   = 1;
+    t->max_batch     = 0;
+    t->transfer_bits = 0;
+    t->value_bits    = 8;
+    t->read_bits     = 0;
+}
+#endif
+
+#ifdef HAL_GPIO_MODULE_ENABLED
+/*******************************************************************************
+ * Direct GPIO
+ ******************************************************************************/
+static bool lcd_gpioWrite(void *ctx, const uint8_t *values, uint16_t len)
+{
+    LCD_DirectGPIO *gpio = (LCD_DirectGPIO *)ctx;
+
+    for (uint16_t i = 0; i < len; i++) {
+        // Only touch the pins that change
+        uint8_t changed = gpio->last_valid ? (values[i] ^ gpio->last) : 0xFF;
+        for (int bit = 0; bit < 8; bit++) {
+            if ((changed & (1 << bit)) && gpio->port[bit] != NULL) {
+                HAL_GPIO_WritePin(gpio->port[bit], gpio->pin[bit],
+                                  (values[i] & (1 << bit)) ? GPIO_PIN_SET : GPIO_PIN_RESET);
+            }
+        }
+        gpio->last = values[i];
+        gpio->last_valid = true;
+        lcd_transportHold(&gpio->clock, gpio->hold_us);
+    }
+    return true;
+}
+
+static bool lcd_gpioRead(void *ctx, uint16_t *levels)
+{
+    LCD_DirectGPIO *gpio = (LCD_DirectGPIO *)ctx;
+
+    *levels = 0;
+    for (int bit = 0; bit < 8; bit++) {
+        if (gpio->port[bit] != NULL && HAL_GPIO_ReadPin(gpio->port[bit], gpio->pin[bit]) == GPIO_PIN_SET) {
+            *levels |= 1 << bit;
+        }
+    }
+    return true;
+}
+
+static bool lcd_gpioSetInputs(void *ctx, uint16_t mask)
+{
+    LCD_DirectGPIO *gpio = (LCD_DirectGPIO *)ctx;
+    GPIO_InitTypeDef init = {0};
+
+    init.Pull  = GPIO_NOPULL;
+    init.Speed = GPIO_SPEED_FREQ_LOW;
+    for (int bit = 0; bit < 8; bit++) {
+        if (gpio->port[bit] == NULL) continue;
+        init.Pin  = gpio->pin[bit];
+        init.Mode = (mask & (1 << bit)) ? GPIO_MODE_INPUT : GPIO_MODE_OUTPUT_PP;
+        HAL_GPIO_Init(gpio->port[bit], &init);
+    }
+    return true;
+}
+
+static const LCD_TransportOps lcd_gpioOps = {
+    lcd_gpioWrite, lcd_gpioRead, lcd_gpioSetInputs, NULL
+};
+
+void LCD_TransportGPIO(LCD_Transport *t, LCD_DirectGPIO *gpio, const LCD_Clock *clock)
+{
+    gpio->hold_us    = 1;
+    gpio->last       = 0;
+    gpio->last_valid = false;
+    lcd_transportSetClock(&gpio->clock, clock);
+
+    t->ops           = &lcd_gpioOps;
+    t->ctx           = gpio;
+    t->caps          = LCD_TRANSPORT_BURST | LCD_TRANSPORT_READ;
+    t->value_bytes   = 1;
+    t->max_batch     = 0;
+    t->transfer_bits = 0;
+    t->value_bits    = 0;
+    t->read_bits     = 0;
+}
+#endif
+
+/*******************************************************************************
+ * Mock
+ ******************************************************************************/
+static bool lcd_mockWrite(void *ctx, const uint8_t *values, uint16_t len)
+{
+    LCD_Mock *mock = (LCD_Mock *)ctx;
+
+    for (uint16_t i = 0; i < len; i++) {
+        if (mock->log_len < mock->log_size) {
+            mock->log[mock->log_len++] = values[i];
+        }
+        mock->last = values[i];
+    }
+    mock->values += len;
+    mock->writes++;
+    return true;
+}
+
+static bool lcd_mockRead(void *ctx, uint16_t *levels)
+{
+    LCD_Mock *mock = (LCD_Mock *)ctx;
+
+    *levels = (mock->last & ~mock->inputs) | (mock->levels & mock->inputs);
+    mock->reads++;
+    return true;
+}
+
+static bool lcd_mockSetInputs(void *ctx, uint16_t mask)
+{
+    LCD_Mock *mock = (LCD_Mock *)ctx;
+
+    mock->inputs = (uint8_t)mask;
+    return true;
+}
+
+static bool lcd_mockWriteAsync(void *ctx, const uint8_t *values, uint16_t len, bool dma)
+{
+    LCD_Mock *mock = (LCD_Mock *)ctx;
+    (void)dma;
+
+    lcd_mockWrite(ctx, values, len);
+    if (mock->lcd != NULL) {
+        LCD_AsyncTxComplete(mock->lcd);
+    }
+    return true;
+}
+
+static const LCD_TransportOps lcd_mockOps = {
+    lcd_mockWrite, lcd_mockRead, lcd_mockSetInputs, lcd_mockWriteAsync
+};
+
+void LCD_TransportMock(LCD_Transport *t, LCD_Mock *mock, uint8_t *log, uint16_t log_size, uint8_t caps)
+{
+    memset(mock, 0, sizeof(*mock));
+    mock->log      = log;
+    mock->log_size = log_size;
+
+    t->ops           = &lcd_mockOps;
+    t->ctx           = mock;
+    t->caps          = caps;
+    t->value_bytes   = 1;
+    t->max_batch     = 0;
+    t->transfer_bits = 0;
+    t->value_bits    = 0;
+    t->read_bits     = 0;
+}
@@ -0,0 +1,102 @@
+#ifndef LCD_TRANSPORT_H
+#define LCD_TRANSPORT_H
+
+#include "LiquidCrystal_C.h"
+#include "stm32f4xx_hal.h" // Replace with stm32f1xx_hal.h or whatever hardware you're using
+
+/******************************************************************************
+ * Transport backends for LCD_SetTransport()
+ *
+ * Each LCD_TransportXxx() fills in an LCD_Transport for one kind of hardware.
+ * The backend state (LCD_PCF8574, ...) is referenced, not copied, so keep it
+ * alive as long as the display is used. Pin numbers given to LCD_Init() are
+ * bits of the GPIO values, i.e. expander pins, shift register outputs, or
+ * entries of the direct GPIO pin table. Call LCD_SetBusClock() with the bus
+ * clock the backend runs at (I2C or SPI), so bus time counts against delays.
+ ******************************************************************************/
+
+#ifdef HAL_I2C_MODULE_ENABLED
+// PCF8574(A) backpack. Every byte written is the new output state, so bursts need no
+// setup. Pins are quasi-bidirectional: reading releases them high.
+// Common backpack wiring: RS=P0, RW=P1, EN=P2, backlight=P3, D4..D7=P4..P7, i.e.
+//   LCD_Init(&lcd, NULL, 1, 0, 1, 2, 4, 5, 6, 7, 0, 0, 0, 0); LCD_SetBacklightPin(&lcd, 3);
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t addr;   // 7-bit address (0x20..0x27, PCF8574A 0x38..0x3F)
+    uint8_t inputs; // pins released for reading, kept high in every write
+    uint8_t last;   // last value written
+} LCD_PCF8574;
+
+void LCD_TransportPCF8574(LCD_Transport *t, LCD_PCF8574 *port, I2C_HandleTypeDef *hi2c, uint8_t addr);
+
+// MCP23017 16-pin expander: GPA0..GPA7 are pins 0..7, GPB0..GPB7 pins 8..15. With the
+// data lines on port A and EN on port B, each byte (8-bit mode) takes two GPIO values,
+// one write per enable edge, since GPIOA reaches the pins before GPIOB. For example:
+//   LCD_Init(&lcd, NULL, 0, 8, 9, 10, 0, 1, 2, 3, 4, 5, 6, 7); LCD_SetBacklightPin(&lcd, 11);
+#define LCD_MCP23017_IODIRA 0x00
+#define LCD_MCP23017_IOCON  0x0A
+#define LCD_MCP23017_GPIOA  0x12
+#define LCD_MCP23017_SEQOP  0x20
+
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t addr;   // 7-bit address (0x20..0x27)
+} LCD_MCP23017;
+
+// Configures the expander (IOCON, all pins outputs), so it talks to the chip. Returns
+// false if it doesn't answer.
+bool LCD_TransportMCP23017(LCD_Transport *t, LCD_MCP23017 *port, I2C_HandleTypeDef *hi2c, uint8_t addr);
+#endif
+
+#ifdef HAL_SPI_MODULE_ENABLED
+// 74HC595 shift register on SPI, latched by a GPIO pin after every value. Write-only:
+// no busy flag, the driver waits out execution times. At SPI clocks above ~16 MHz one
+// value takes less than the 450 ns enable pulse, so set hold_us.
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    GPIO_TypeDef *latch_port;
+    uint16_t latch_pin;
+    uint32_t hold_us;     // extra time each value is held
+    LCD_Clock clock;
+} LCD_HC595;
+
+void LCD_TransportHC595(LCD_Transport *t, LCD_HC595 *sr, SPI_HandleTypeDef *hspi,
+                        GPIO_TypeDef *latch_port, uint16_t latch_pin);
+#endif
+
+#ifdef HAL_GPIO_MODULE_ENABLED
+// LCD lines on MCU pins. Bit i of the GPIO values drives port[i]/pin[i] (port NULL if
+// unused). There is no bus time, so each value is held for hold_us to give the
+// controller its enable pulse width; the driver waits out execution times itself.
+typedef struct {
+    GPIO_TypeDef *port[8];
+    uint16_t pin[8];
+    uint32_t hold_us;     // 1 by default
+    LCD_Clock clock;
+    uint8_t last;
+    bool last_valid;
+} LCD_DirectGPIO;
+
+// Fill in port[] and pin[] first. clock times the hold (e.g. the DWT clock); without one
+// (NULL) it spins on LCD_SpinUs().
+void LCD_TransportGPIO(LCD_Transport *t, LCD_DirectGPIO *gpio, const LCD_Clock *clock);
+#endif
+
+// In-memory transport for tests: records every value written, reads back 'levels' on
+// the input pins. caps picks the LCD_TRANSPORT_* flags it claims to have.
+typedef struct {
+    uint8_t *log;
+    uint16_t log_size;
+    uint16_t log_len;   // values recorded (stops at log_size)
+    uint32_t values;    // values written, including those that didn't fit
+    uint32_t writes;    // write() calls
+    uint32_t reads;
+    uint8_t inputs;     // pins set as inputs
+    uint8_t levels;     // what the input pins read as
+    uint8_t last;
+    LiquidCrystal_C *lcd; // gets LCD_AsyncTxComplete() right away with LCD_TRANSPORT_ASYNC
+} LCD_Mock;
+
+void LCD_TransportMock(LCD_Transport *t, LCD_Mock *mock, uint8_t *log, uint16_t log_size, uint8_t caps);
+
+#endif
@@ -0,0 +1,368 @@
+#include "LCD_Ui.h"
+#include <string.h>
+#include "stm32f4xx_hal.h" // For HAL_GetTick. Replace with stm32f1xx_hal.h or whatever hardware you're using
+
+#define LCD_UI_NUMBER_MAX 13 // "-2147483648" with a decimal point and a leading zero
+
+static uint32_t lcd_uiNowUs(const LCD_Ui *ui)
+{
+    const LCD_Clock *clock = &ui->lcd->clock;
+
+    if (clock->now_us != NULL) {
+        return clock->now_us(clock->ctx);
+    }
+    return HAL_GetTick() * 1000;
+}
+
+static LCD_Widget *lcd_uiWidget(LCD_Ui *ui, int id, LCD_UiKind kind)
+{
+    if (id < 0 || id >= ui->count || ui->widgets[id].kind != kind) return NULL;
+    return &ui->widgets[id];
+}
+
+static uint8_t lcd_uiAllRows(const LCD_Widget *w)
+{
+    return (uint8_t)((1u << w->height) - 1);
+}
+
+static bool lcd_uiOverlap(const LCD_Widget *a, const LCD_Widget *b)
+{
+    return a->col < b->col + b->width && b->col < a->col + a->width &&
+           a->row < b->row + b->height && b->row < a->row + a->height;
+}
+
+// Take a widget from the pool, if its rectangle fits on the screen
+static int lcd_uiAdd(LCD_Ui *ui, LCD_UiKind kind, uint8_t col, uint8_t row, uint8_t width, uint8_t height)
+{
+    const LiquidCrystal_C *lcd = ui->lcd;
+
+    if (ui->count >= LCD_UI_MAX_WIDGETS || width == 0 || height == 0 || height > 8 ||
+        col + width > lcd->numcols || row + height > lcd->numlines) {
+        return -1;
+    }
+    LCD_Widget *w = &ui->widgets[ui->count];
+    memset(w, 0, sizeof(*w));
+    w->kind = kind;
+    w->col = col;
+    w->row = row;
+    w->width = width;
+    w->height = height;
+    w->visible = true;
+    w->dirty = lcd_uiAllRows(w);
+    return ui->count++;
+}
+
+/*******************************************************************************
+ * RENDERING
+ ******************************************************************************/
+// Put len characters of s into width cells, aligned, padded with spaces
+static void lcd_uiAlign(uint8_t *cells, uint8_t width, const char *s, uint8_t len, uint8_t align)
+{
+    uint8_t pad = width - len;
+    uint8_t left = (align == LCD_UI_ALIGN_RIGHT) ? pad : (align == LCD_UI_ALIGN_CENTER) ? pad / 2 : 0;
+
+    memset(cells, ' ', width);
+    memcpy(cells + left, s, len);
+}
+
+// value / 10^decimals as text; returns its length
+static uint8_t lcd_uiFormat(int32_t value, uint8_t decimals, char *out)
+{
+    char digits[LCD_UI_NUMBER_MAX];
+    uint8_t n = 0, len = 0;
+    uint32_t v = (value < 0) ? 0u - (uint32_t)value : (uint32_t)value;
+
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v != 0 || n <= decimals);
+    if (value < 0) out[len++] = '-';
+    while (n > 0) {
+        if (n == decimals) out[len++] = '.';
+        out[len++] = digits[--n];
+    }
+    return len;
+}
+
+static void lcd_uiRenderRow(LCD_Ui *ui, const LCD_Widget *w, uint8_t r)
+{
+    uint8_t cells[LCD_MAX_COLS];
+    uint8_t row = w->row + r;
+
+    if (!w->visible) {
+        memset(cells, ' ', w->width);
+    } else if (w->kind == LCD_UI_LABEL) {
+        size_t len = strlen(w->u.text);
+        lcd_uiAlign(cells, w->width, w->u.text, (uint8_t)(len < w->width ? len : w->width), w->align);
+    } else if (w->kind == LCD_UI_NUMBER) {
+        char text[LCD_UI_NUMBER_MAX];
+        uint8_t len = w->u.number.set ? lcd_uiFormat(w->u.number.value, w->u.number.decimals, text) : 0;
+        if (len > w->width) {
+            memset(cells, '#', w->width);
+        } else {
+            lcd_uiAlign(cells, w->width, text, len, w->align);
+        }
+    } else if (w->kind == LCD_UI_MENU) {
+        uint8_t item = w->u.menu.top + r;
+        memset(cells, ' ', w->width);
+        if (item < w->u.menu.count) {
+            const char *s = w->u.menu.items[item];
+            size_t len = strlen(s);
+            if (len > (size_t)(w->width - 1)) len = w->width - 1;
+            cells[0] = (item == w->u.menu.selected) ? ui->marker : ' ';
+            memcpy(cells + 1, s, len);
+        }
+    } else if (w->u.icon.bitmap != NULL && ui->glyphs != NULL) {
+        LCD_GlyphPut(ui->glyphs, w->col, row, w->u.icon.bitmap, '?');
+        return;
+    } else {
+        cells[0] = w->u.icon.code;
+    }
+    for (uint8_t c = 0; c < w->width; c++) {
+        LCD_FbPutChar(ui->lcd, w->col + c, row, cells[c]);
+    }
+}
+
+static void lcd_uiRender(LCD_Ui *ui, int id)
+{
+    LCD_Widget *w = &ui->widgets[id];
+
+    for (uint8_t r = 0; r < w->height; r++) {
+        if (w->dirty & (1u << r)) lcd_uiRenderRow(ui, w, r);
+    }
+    w->dirty = 0;
+    ui->stats.last_widgets++;
+    // Widgets added later are drawn on top: put them back over what was just drawn
+    for (int j = id + 1; j < ui->count; j++) {
+        if (ui->widgets[j].visible && lcd_uiOverlap(w, &ui->widgets[j])) {
+            ui->widgets[j].dirty = lcd_uiAllRows(&ui->widgets[j]);
+        }
+    }
+}
+
+/*******************************************************************************
+ * WIDGETS
+ ******************************************************************************/
+void LCD_UiInit(LCD_Ui *ui, LiquidCrystal_C *lcd, LCD_GlyphCache *glyphs)
+{
+    memset(ui, 0, sizeof(*ui));
+    ui->lcd = lcd;
+    ui->glyphs = glyphs;
+    ui->marker = LCD_UI_MARKER;
+}
+
+void LCD_UiSetMarker(LCD_Ui *ui, uint8_t code)
+{
+    ui->marker = code;
+    for (int i = 0; i < ui->count; i++) {
+        if (ui->widgets[i].kind == LCD_UI_MENU) LCD_UiInvalidateWidget(ui, i);
+    }
+}
+
+int LCD_UiLabel(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t width, LCD_UiAlign align, const char *text)
+{
+    if (width == 0) {
+        size_t len = strlen(text);
+        width = (uint8_t)(len < LCD_UI_TEXT_MAX ? len : LCD_UI_TEXT_MAX);
+    }
+    int id = lcd_uiAdd(ui, LCD_UI_LABEL, col, row, width, 1);
+    if (id < 0) return -1;
+
+    LCD_Widget *w = &ui->widgets[id];
+    w->align = align;
+    strncpy(w->u.text, text, LCD_UI_TEXT_MAX);
+    w->u.text[LCD_UI_TEXT_MAX] = '\0';
+    return id;
+}
+
+int LCD_UiNumber(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t width, uint8_t decimals, LCD_UiAlign align)
+{
+    int id = lcd_uiAdd(ui, LCD_UI_NUMBER, col, row, width, 1);
+    if (id < 0) return -1;
+
+    LCD_Widget *w = &ui->widgets[id];
+    w->align = align;
+    w->u.number.decimals = (decimals > 9) ? 9 : decimals;
+    return id;
+}
+
+int LCD_UiMenu(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t width, uint8_t height,
+               const char *const *items, uint8_t count)
+{
+    if (width < 2) return -1;
+    int id = lcd_uiAdd(ui, LCD_UI_MENU, col, row, width, height);
+    if (id < 0) return -1;
+
+    LCD_Widget *w = &ui->widgets[id];
+    w->u.menu.items = items;
+    w->u.menu.count = count;
+    return id;
+}
+
+int LCD_UiIcon(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t code)
+{
+    int id = lcd_uiAdd(ui, LCD_UI_ICON, col, row, 1, 1);
+    if (id < 0) return -1;
+
+    ui->widgets[id].u.icon.code = code;
+    return id;
+}
+
+void LCD_UiSetText(LCD_Ui *ui, int id, const char *text)
+{
+    LCD_Widget *w = lcd_uiWidget(ui, id, LCD_UI_LABEL);
+    if (w == NULL || strncmp(w->u.text, text, LCD_UI_TEXT_MAX) == 0) return;
+
+    strncpy(w->u.text, text, LCD_UI_TEXT_MAX);
+    w->u.text[LCD_UI_TEXT_MAX] = '\0';
+    w->dirty = 1;
+}
+
+void LCD_UiSetNumber(LCD_Ui *ui, int id, int32_t value)
+{
+    LCD_Widget *w = lcd_uiWidget(ui, id, LCD_UI_NUMBER);
+    if (w == NULL || (w->u.number.set && w->u.number.value == value)) return;
+
+    w->u.number.value = value;
+    w->u.number.set = true;
+    w->dirty = 1;
+}
+
+void LCD_UiSetIcon(LCD_Ui *ui, int id, uint8_t code)
+{
+    LCD_Widget *w = lcd_uiWidget(ui, id, LCD_UI_ICON);
+    if (w == NULL || (w->u.icon.code == code && w->u.icon.bitmap == NULL)) return;
+
+    w->u.icon.code = code;
+    w->u.icon.bitmap = NULL;
+    w->dirty = 1;
+}
+
+void LCD_UiSetIconBitmap(LCD_Ui *ui, int id, const uint8_t *bitmap)
+{
+    LCD_Widget *w = lcd_uiWidget(ui, id, LCD_UI_ICON);
+    if (w == NULL || w->u.icon.bitmap == bitmap) return;
+
+    w->u.icon.bitmap = bitmap;
+    w->dirty = 1;
+}
+
+void LCD_UiMenuSelect(LCD_Ui *ui, int id, uint8_t index)
+{
+    LCD_Widget *w = lcd_uiWidget(ui, id, LCD_UI_MENU);
+    if (w == NULL || index >= w->u.menu.count || index == w->u.menu.selected) return;
+
+    uint8_t top = w->u.menu.top;
+    if (index < top) {
+        top = index;
+    } else if (index >= top + w->height) {
+        top = index - w->height + 1;
+    }
+    if (top != w->u.menu.top) {
+        // Scrolled: every row shows another item
+        w->u.menu.top = top;
+        w->dirty = lcd_uiAllRows(w);
+    } else {
+        // Only the marker moves: the rows of the old and the new selection
+        w->dirty |= (uint8_t)((1u << (w->u.menu.selected - top)) | (1u << (index - top)));
+    }
+    w->u.menu.selected = index;
+}
+
+uint8_t LCD_UiMenuMove(LCD_Ui *ui, int id, int8_t delta)
+{
+    LCD_Widget *w = lcd_uiWidget(ui, id, LCD_UI_MENU);
+    if (w == NULL || w->u.menu.count == 0) return 0;
+
+    int n = w->u.menu.count;
+    int index = ((w->u.menu.selected + delta) % n + n) % n;
+    LCD_UiMenuSelect(ui, id, (uint8_t)index);
+    return w->u.menu.selected;
+}
+
+uint8_t LCD_UiMenuSelected(const LCD_Ui *ui, int id)
+{
+    if (id < 0 || id >= ui->count || ui->widgets[id].kind != LCD_UI_MENU) return 0;
+    return ui->widgets[id].u.menu.selected;
+}
+
+void LCD_UiShow(LCD_Ui *ui, int id, bool visible)
+{
+    if (id < 0 || id >= ui->count || ui->widgets[id].visible == visible) return;
+
+    LCD_Widget *w = &ui->widgets[id];
+    w->visible = visible;
+    w->dirty = lcd_uiAllRows(w);
+    if (visible) return;
+    // The blanked rectangle may cover parts of other widgets
+    for (int j = 0; j < ui->count; j++) {
+        if (j != id && ui->widgets[j].visible && lcd_uiOverlap(w, &ui->widgets[j])) {
+            ui->widgets[j].dirty = lcd_uiAllRows(&ui->widgets[j]);
+        }
+    }
+}
+
+void LCD_UiInvalidateWidget(LCD_Ui *ui, int id)
+{
+    if (id < 0 || id >= ui->count) return;
+    ui->widgets[id].dirty = lcd_uiAllRows(&ui->widgets[id]);
+}
+
+void LCD_UiInvalidate(LCD_Ui *ui)
+{
+    for (int i = 0; i < ui->count; i++) {
+        LCD_UiInvalidateWidget(ui, i);
+    }
+    LCD_FbInvalidate(ui->lcd);
+}
+
+/*******************************************************************************
+ * COMMIT
+ ******************************************************************************/
+bool LCD_UiCommit(LCD_Ui *ui)
+{
+    LiquidCrystal_C *lcd = ui->lcd;
+    LCD_UiStats *st = &ui->stats;
+    uint32_t start = lcd_uiNowUs(ui);
+    uint32_t before = lcd->stats.gpio_bytes;
+
+    st->last_widgets = 0;
+    LCD_BeginBurst(lcd);
+    // Blank hidden widgets first, so that nothing drawn in this commit is blanked
+    for (int i = 0; i < ui->count; i++) {
+        if (ui->widgets[i].dirty && !ui->widgets[i].visible) lcd_uiRender(ui, i);
+    }
+    for (int i = 0; i < ui->count; i++) {
+        if (ui->widgets[i].dirty && ui->widgets[i].visible) lcd_uiRender(ui, i);
+    }
+    LCD_Flush(lcd);
+    LCD_EndBurst(lcd);
+
+    st->last_cells = lcd->flush_stats.cells_changed;
+    st->last_jumps = lcd->flush_stats.jumps;
+    st->last_bytes = lcd->stats.gpio_bytes - before;
+    st->last_us = lcd_uiNowUs(ui) - start;
+    st->widgets += st->last_widgets;
+    if (st->last_bytes == 0) {
+        st->idle++;
+        return false;
+    }
+    st->commits++;
+    st->cells += st->last_cells;
+    st->jumps += st->last_jumps;
+    st->bus_bytes += st->last_bytes;
+    if (st->last_us > st->max_us) {
+        st->max_us = st->last_us;
+    }
+    return true;
+}
+
+void LCD_UiGetStats(const LCD_Ui *ui, LCD_UiStats *stats)
+{
+    *stats = ui->stats;
+}
+
+void LCD_UiResetStats(LCD_Ui *ui)
+{
+    memset(&ui->stats, 0, sizeof(ui->stats));
+}
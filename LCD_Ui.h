@@ -0,0 +1,143 @@
+#ifndef LCD_UI_H
+#define LCD_UI_H
+
+#include "LiquidCrystal_C.h"
+#include "LCD_Glyph.h"
+
+/******************************************************************************
+ * Retained-mode widgets
+ *
+ * Labels, numeric fields, menus and status icons that keep their own content
+ * and screen rectangle. Setting a widget only marks the rows of its rectangle
+ * that change as dirty; nothing is sent until LCD_UiCommit(), which renders
+ * the dirty rows into the framebuffer and sends them with one LCD_Flush(). The
+ * flush only sends cells whose character changed, bridging short gaps with the
+ * cells in between rather than a cursor jump, so moving a menu's selection
+ * costs the two marker cells and a value that didn't change costs nothing.
+ *
+ * Widgets live in a fixed pool inside LCD_Ui (LCD_UI_MAX_WIDGETS); nothing is
+ * allocated. They are drawn in the order they were added, so a later widget
+ * covers an earlier one where they overlap. Text is kept in the widget, up to
+ * LCD_UI_TEXT_MAX characters; menu items and icon bitmaps are referenced, so
+ * keep them in static (or const) storage.
+ *
+ * Each commit records what it cost: widgets and cells redrawn, cursor jumps,
+ * bus bytes and the time the commit took, with the worst seen so far, so menu
+ * navigation can be held to a latency target. Other drawing into the
+ * framebuffer goes out with the next commit too.
+ ******************************************************************************/
+#ifndef LCD_UI_MAX_WIDGETS
+#define LCD_UI_MAX_WIDGETS 16
+#endif
+#ifndef LCD_UI_TEXT_MAX
+#define LCD_UI_TEXT_MAX 20 // characters a label keeps
+#endif
+#define LCD_UI_MARKER 0x7E // right arrow in the A00 ROM
+
+typedef enum {
+    LCD_UI_LABEL,
+    LCD_UI_NUMBER,
+    LCD_UI_MENU,
+    LCD_UI_ICON
+} LCD_UiKind;
+
+typedef enum {
+    LCD_UI_ALIGN_LEFT,
+    LCD_UI_ALIGN_RIGHT,
+    LCD_UI_ALIGN_CENTER
+} LCD_UiAlign;
+
+typedef struct {
+    uint32_t commits;      // commits that sent something
+    uint32_t idle;         // commits with nothing to send
+    uint32_t widgets;      // widget renders
+    uint32_t cells;        // cells that changed on the display
+    uint32_t jumps;        // cursor jumps
+    uint32_t bus_bytes;    // GPIO bytes sent by commits
+    uint32_t max_us;       // slowest commit
+    // The last commit
+    uint16_t last_widgets;
+    uint16_t last_cells;
+    uint16_t last_jumps;
+    uint32_t last_bytes;
+    uint32_t last_us;
+} LCD_UiStats;
+
+typedef struct {
+    uint8_t kind;          // LCD_UiKind
+    uint8_t col, row;      // top left cell
+    uint8_t width, height;
+    uint8_t align;         // LCD_UiAlign: label and number
+    bool visible;
+    uint8_t dirty;         // rows of the rectangle to redraw, bit 0 = top row
+    union {
+        char text[LCD_UI_TEXT_MAX + 1];
+        struct {
+            int32_t value;
+            uint8_t decimals; // digits after the decimal point: 1234 with 2 shows 12.34
+            bool set;         // blank until the first value
+        } number;
+        struct {
+            const char *const *items;
+            uint8_t count;
+            uint8_t selected;
+            uint8_t top;      // first item shown
+        } menu;
+        struct {
+            uint8_t code;           // character shown, unless bitmap is set
+            const uint8_t *bitmap;  // 5x8 bitmap through the glyph cache, NULL for none
+        } icon;
+    } u;
+} LCD_Widget;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    LCD_GlyphCache *glyphs; // for icon bitmaps, NULL = none
+    uint8_t marker;         // menu selection marker
+    uint8_t count;
+    LCD_Widget widgets[LCD_UI_MAX_WIDGETS];
+    LCD_UiStats stats;
+} LCD_Ui;
+
+// The display must have been started with LCD_Begin(). glyphs may be NULL if no icon uses
+// a bitmap. Times come from the handle's clock (LCD_SetClock), or the 1 ms HAL tick.
+void LCD_UiInit(LCD_Ui *ui, LiquidCrystal_C *lcd, LCD_GlyphCache *glyphs);
+// Selection marker of every menu (LCD_UI_MARKER by default; e.g. '>' on an A02 ROM)
+void LCD_UiSetMarker(LCD_Ui *ui, uint8_t code);
+
+// Add a widget. Each returns its id, or -1 if the pool is full or the rectangle doesn't
+// fit on the screen. A widget is visible, and dirty, from the start.
+// Text in width cells (0 = the length of text), aligned in them
+int LCD_UiLabel(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t width, LCD_UiAlign align, const char *text);
+// A number in width cells with decimals digits after the point; '#' fill if it doesn't fit
+int LCD_UiNumber(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t width, uint8_t decimals, LCD_UiAlign align);
+// count items, height of them at a time, the selected one marked in the first column
+int LCD_UiMenu(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t width, uint8_t height,
+               const char *const *items, uint8_t count);
+// One cell showing a character code (a ROM character or a CGRAM slot 0..7)
+int LCD_UiIcon(LCD_Ui *ui, uint8_t col, uint8_t row, uint8_t code);
+
+// Change a widget. Nothing is marked dirty if what it shows stays the same.
+void LCD_UiSetText(LCD_Ui *ui, int id, const char *text);
+void LCD_UiSetNumber(LCD_Ui *ui, int id, int32_t value);
+void LCD_UiSetIcon(LCD_Ui *ui, int id, uint8_t code);
+// Show bitmap through the glyph cache ('?' if no slot is free, NULL to go back to the code)
+void LCD_UiSetIconBitmap(LCD_Ui *ui, int id, const uint8_t *bitmap);
+// Select an item, scrolling the menu if it isn't shown
+void LCD_UiMenuSelect(LCD_Ui *ui, int id, uint8_t index);
+// Move the selection by delta items, wrapping around. Returns the selected item.
+uint8_t LCD_UiMenuMove(LCD_Ui *ui, int id, int8_t delta);
+uint8_t LCD_UiMenuSelected(const LCD_Ui *ui, int id);
+// A hidden widget's rectangle is blanked, and widgets under it are redrawn
+void LCD_UiShow(LCD_Ui *ui, int id, bool visible);
+// Redraw a widget whose items or bitmap changed in place
+void LCD_UiInvalidateWidget(LCD_Ui *ui, int id);
+// Redraw everything, e.g. after the display was cleared or lost power
+void LCD_UiInvalidate(LCD_Ui *ui);
+
+// Render what is dirty and send it. Returns true if anything was sent.
+bool LCD_UiCommit(LCD_Ui *ui);
+void LCD_UiGetStats(const LCD_Ui *ui, LCD_UiStats *stats);
+void LCD_UiResetStats(LCD_Ui *ui);
+
+#endif
@@ -0,0 +1,402 @@
+#include "LCD_Utf8.h"
+#include <string.h>
+
+// Code points first..first+count-1 are ROM codes code..code+count-1
+typedef struct {
+    uint16_t first;
+    uint8_t count;
+    uint8_t code;
+} lcd_utf8Range;
+
+typedef struct {
+    uint16_t cp;
+    uint8_t rows[8];
+} lcd_utf8Glyph;
+
+// Sequence length by the top 5 bits of the first byte: 0 = continuation or invalid
+static const uint8_t lcd_utf8Length[32] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x00..0x7F
+    0, 0, 0, 0, 0, 0, 0, 0,                         // 0x80..0xBF
+    2, 2, 2, 2, 3, 3, 4, 0,                         // 0xC0..0xFF
+};
+static const uint8_t lcd_utf8Lead[5] = { 0x00, 0x7F, 0x1F, 0x0F, 0x07 };
+static const uint32_t lcd_utf8Min[5] = { 0, 0, 0x80, 0x800, 0x10000 }; // shorter is overlong
+
+// ASCII the ROM doesn't have, one bit per character. A00: '\' (yen sign) and '~' (arrow).
+static const uint8_t lcd_utf8AsciiMissing[2][16] = {
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x10, 0, 0, 0, 0x40 },
+    { 0 },
+};
+
+static const lcd_utf8Range lcd_utf8A00[] = {
+    { 0x00A2,  2, 0xEC }, // cent, pound
+    { 0x00A5,  1, 0x5C }, // yen
+    { 0x00B0,  1, 0xDF }, // degree: handakuten
+    { 0x00B5,  1, 0xE4 }, // micro
+    { 0x00B7,  1, 0xA5 }, // middle dot
+    { 0x00E4,  1, 0xE1 }, // a umlaut
+    { 0x00F1,  1, 0xEE }, // n tilde
+    { 0x00F6,  1, 0xEF }, // o umlaut
+    { 0x00F7,  1, 0xFD }, // division
+    { 0x00FC,  1, 0xF5 }, // u umlaut
+    { 0x0391,  2, 'A'  }, // Greek capitals that look like Latin ones
+    { 0x0395,  1, 'E'  },
+    { 0x0396,  1, 'Z'  },
+    { 0x0397,  1, 'H'  },
+    { 0x0398,  1, 0xF2 }, // theta
+    { 0x0399,  1, 'I'  },
+    { 0x039A,  1, 'K'  },
+    { 0x039C,  1, 'M'  },
+    { 0x039D,  1, 'N'  },
+    { 0x039F,  1, 'O'  },
+    { 0x03A1,  1, 'P'  },
+    { 0x03A3,  1, 0xF6 }, // Sigma
+    { 0x03A4,  1, 'T'  },
+    { 0x03A5,  1, 'Y'  },
+    { 0x03A7,  1, 'X'  },
+    { 0x03A9,  1, 0xF4 }, // Omega
+    { 0x03B1,  1, 0xE0 }, // alpha
+    { 0x03B2,  1, 0xE2 }, // beta
+    { 0x03B5,  1, 0xE3 }, // epsilon
+    { 0x03B8,  1, 0xF2 }, // theta
+    { 0x03BC,  1, 0xE4 }, // mu
+    { 0x03C0,  1, 0xF7 }, // pi
+    { 0x03C1,  1, 0xE6 }, // rho
+    { 0x03C3,  1, 0xE5 }, // sigma
+    { 0x0410,  1, 'A'  }, // Cyrillic letters that look like Latin ones
+    { 0x0412,  1, 'B'  },
+    { 0x0415,  1, 'E'  },
+    { 0x041A,  1, 'K'  },
+    { 0x041C,  1, 'M'  },
+    { 0x041D,  1, 'H'  },
+    { 0x041E,  1, 'O'  },
+    { 0x0420,  1, 'P'  },
+    { 0x0421,  1, 'C'  },
+    { 0x0422,  1, 'T'  },
+    { 0x0425,  1, 'X'  },
+    { 0x0430,  1, 'a'  },
+    { 0x0435,  1, 'e'  },
+    { 0x043E,  1, 'o'  },
+    { 0x0440,  1, 'p'  },
+    { 0x0441,  1, 'c'  },
+    { 0x0443,  1, 'y'  },
+    { 0x0445,  1, 'x'  },
+    { 0x2190,  1, 0x7F }, // left arrow
+    { 0x2192,  1, 0x7E }, // right arrow
+    { 0x221A,  1, 0xE8 }, // square root
+    { 0x221E,  1, 0xF3 }, // infinity
+    { 0x2588,  1, 0xFF }, // full block
+    { 0x3001,  1, 0xA4 }, // ideographic comma
+    { 0x3002,  1, 0xA1 }, // ideographic full stop
+    { 0x300C,  2, 0xA2 }, // corner brackets
+    { 0x309B,  2, 0xDE }, // (han)dakuten
+    { 0x30A1,  1, 0xA7 }, // full-width katakana: small a, a, small i, i, ...
+    { 0x30A2,  1, 0xB1 },
+    { 0x30A3,  1, 0xA8 },
+    { 0x30A4,  1, 0xB2 },
+    { 0x30A5,  1, 0xA9 },
+    { 0x30A6,  1, 0xB3 },
+    { 0x30A7,  1, 0xAA },
+    { 0x30A8,  1, 0xB4 },
+    { 0x30A9,  1, 0xAB },
+    { 0x30AA,  1, 0xB5 },
+    { 0x30AB,  1, 0xB6 },
+    { 0x30AD,  1, 0xB7 },
+    { 0x30AF,  1, 0xB8 },
+    { 0x30B1,  1, 0xB9 },
+    { 0x30B3,  1, 0xBA },
+    { 0x30B5,  1, 0xBB },
+    { 0x30B7,  1, 0xBC },
+    { 0x30B9,  1, 0xBD },
+    { 0x30BB,  1, 0xBE },
+    { 0x30BD,  1, 0xBF },
+    { 0x30BF,  1, 0xC0 },
+    { 0x30C1,  1, 0xC1 },
+    { 0x30C3,  1, 0xAF },
+    { 0x30C4,  1, 0xC2 },
+    { 0x30C6,  1, 0xC3 },
+    { 0x30C8,  1, 0xC4 },
+    { 0x30CA,  5, 0xC5 }, // na .. no
+    { 0x30CF,  1, 0xCA },
+    { 0x30D2,  1, 0xCB },
+    { 0x30D5,  1, 0xCC },
+    { 0x30D8,  1, 0xCD },
+    { 0x30DB,  1, 0xCE },
+    { 0x30DE,  5, 0xCF }, // ma .. mo
+    { 0x30E3,  1, 0xAC },
+    { 0x30E4,  1, 0xD4 },
+    { 0x30E5,  1, 0xAD },
+    { 0x30E6,  1, 0xD5 },
+    { 0x30E7,  1, 0xAE },
+    { 0x30E8,  1, 0xD6 },
+    { 0x30E9,  5, 0xD7 }, // ra .. ro
+    { 0x30EF,  1, 0xDC },
+    { 0x30F2,  1, 0xA6 },
+    { 0x30F3,  1, 0xDD },
+    { 0x30FB,  1, 0xA5 },
+    { 0x30FC,  1, 0xB0 }, // long vowel mark
+    { 0xFF61, 63, 0xA1 }, // half-width katakana: the ROM's own order
+};
+
+static const lcd_utf8Range lcd_utf8A02[] = {
+    { 0x00A1,  7, 0xA1 }, // Latin-1 where the ROM has it
+    { 0x00A9,  3, 0xA9 },
+    { 0x00AE,  1, 0xAE },
+    { 0x00B0,  4, 0xB0 },
+    { 0x00B5,  3, 0xB5 },
+    { 0x00B9,  7, 0xB9 },
+    { 0x00C0, 64, 0xC0 },
+    { 0x0391,  2, 'A'  }, // Greek capitals that look like Latin ones
+    { 0x0393,  1, 0x92 }, // Gamma
+    { 0x0395,  1, 'E'  },
+    { 0x0396,  1, 'Z'  },
+    { 0x0397,  1, 'H'  },
+    { 0x0398,  1, 0x99 }, // Theta
+    { 0x0399,  1, 'I'  },
+    { 0x039A,  1, 'K'  },
+    { 0x039C,  1, 'M'  },
+    { 0x039D,  1, 'N'  },
+    { 0x039F,  1, 'O'  },
+    { 0x03A1,  1, 'P'  },
+    { 0x03A3,  1, 0x94 }, // Sigma
+    { 0x03A4,  1, 'T'  },
+    { 0x03A5,  1, 'Y'  },
+    { 0x03A7,  1, 'X'  },
+    { 0x03A9,  1, 0x9A }, // Omega
+    { 0x03B1,  1, 0x90 }, // alpha
+    { 0x03B4,  1, 0x9B }, // delta
+    { 0x03B5,  1, 0x9E }, // epsilon
+    { 0x03BC,  1, 0xB5 }, // mu
+    { 0x03C0,  1, 0x93 }, // pi
+    { 0x03C3,  1, 0x95 }, // sigma
+    { 0x03C4,  1, 0x97 }, // tau
+    { 0x0410,  1, 'A'  }, // Cyrillic capitals: the ROM's, and lookalikes
+    { 0x0411,  1, 0x80 },
+    { 0x0412,  1, 'B'  },
+    { 0x0414,  1, 0x81 },
+    { 0x0415,  1, 'E'  },
+    { 0x0416,  4, 0x82 }, // Zhe .. short I
+    { 0x041A,  1, 'K'  },
+    { 0x041B,  1, 0x86 },
+    { 0x041C,  1, 'M'  },
+    { 0x041D,  1, 'H'  },
+    { 0x041E,  1, 'O'  },
+    { 0x041F,  1, 0x87 },
+    { 0x0420,  1, 'P'  },
+    { 0x0421,  1, 'C'  },
+    { 0x0422,  1, 'T'  },
+    { 0x0423,  1, 0x88 },
+    { 0x0425,  1, 'X'  },
+    { 0x0426,  6, 0x89 }, // Tse .. Yeru
+    { 0x042D,  1, 0x8F },
+    { 0x042E,  2, 0xAC }, // Yu, Ya
+    { 0x0430,  1, 'a'  }, // Cyrillic small letters that look like Latin ones
+    { 0x0435,  1, 'e'  },
+    { 0x043E,  1, 'o'  },
+    { 0x0440,  1, 'p'  },
+    { 0x0441,  1, 'c'  },
+    { 0x0443,  1, 'y'  },
+    { 0x0445,  1, 'x'  },
+    { 0x221E,  1, 0x9C }, // infinity
+    { 0x2229,  1, 0x9F }, // intersection
+    { 0x2665,  1, 0x9D }, // heart
+    { 0x266A,  1, 0x91 }, // quaver
+};
+
+// Bitmaps for code points missing from one ROM or the other, sorted
+static const lcd_utf8Glyph lcd_utf8Glyphs[] = {
+    { 0x005C, { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00 } }, // backslash
+    { 0x007E, { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00 } }, // tilde
+    { 0x00B1, { 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00, 0x1F, 0x00 } }, // plus-minus
+    { 0x00B2, { 0x0C, 0x02, 0x04, 0x08, 0x0E, 0x00, 0x00, 0x00 } }, // superscript 2
+    { 0x00B3, { 0x0C, 0x02, 0x0C, 0x02, 0x0C, 0x00, 0x00, 0x00 } }, // superscript 3
+    { 0x00C4, { 0x0A, 0x00, 0x0E, 0x11, 0x1F, 0x11, 0x11, 0x00 } }, // A umlaut
+    { 0x00C5, { 0x04, 0x0A, 0x04, 0x0E, 0x11, 0x1F, 0x11, 0x00 } }, // A ring
+    { 0x00C9, { 0x02, 0x04, 0x1F, 0x10, 0x1E, 0x10, 0x1F, 0x00 } }, // E acute
+    { 0x00D6, { 0x0A, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 } }, // O umlaut
+    { 0x00D7, { 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x00, 0x00 } }, // multiplication
+    { 0x00DC, { 0x0A, 0x00, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00 } }, // U umlaut
+    { 0x00DF, { 0x0E, 0x11, 0x11, 0x16, 0x11, 0x11, 0x16, 0x10 } }, // sharp s
+    { 0x00E0, { 0x08, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 } }, // a grave
+    { 0x00E1, { 0x02, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 } }, // a acute
+    { 0x00E5, { 0x04, 0x0A, 0x04, 0x0E, 0x01, 0x0F, 0x11, 0x0F } }, // a ring
+    { 0x00E6, { 0x00, 0x00, 0x1A, 0x05, 0x0F, 0x14, 0x0B, 0x00 } }, // ae
+    { 0x00E7, { 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x04, 0x0C } }, // c cedilla
+    { 0x00E8, { 0x08, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 } }, // e grave
+    { 0x00E9, { 0x02, 0x04, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 } }, // e acute
+    { 0x00EA, { 0x04, 0x0A, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 } }, // e circumflex
+    { 0x00ED, { 0x02, 0x04, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00 } }, // i acute
+    { 0x00F3, { 0x02, 0x04, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 } }, // o acute
+    { 0x00F8, { 0x00, 0x01, 0x0E, 0x13, 0x15, 0x19, 0x0E, 0x10 } }, // o slash
+    { 0x00FA, { 0x02, 0x04, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00 } }, // u acute
+    { 0x0394, { 0x00, 0x04, 0x04, 0x0A, 0x0A, 0x11, 0x1F, 0x00 } }, // Delta
+    { 0x20AC, { 0x06, 0x09, 0x1C, 0x08, 0x1C, 0x09, 0x06, 0x00 } }, // euro
+};
+
+#define LCD_UTF8_COUNT(t) ((uint16_t)(sizeof(t) / sizeof((t)[0])))
+
+uint8_t LCD_Utf8Decode(const char *s, uint32_t *cp)
+{
+    const uint8_t *p = (const uint8_t *)s;
+    uint8_t len = lcd_utf8Length[p[0] >> 3];
+    uint32_t c = p[0] & lcd_utf8Lead[len];
+
+    // Stop at the first byte that isn't a continuation, so a NUL is never read past
+    for (uint8_t i = 1; i < len; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *cp = LCD_UTF8_REPLACEMENT;
+            return i;
+        }
+        c = (c << 6) | (p[i] & 0x3F);
+    }
+    // Stray continuation bytes, overlong forms, surrogates and beyond U+10FFFF
+    if (len == 0 || c < lcd_utf8Min[len] || (c - 0xD800) < 0x800 || c > 0x10FFFF) {
+        *cp = LCD_UTF8_REPLACEMENT;
+        return len ? len : 1;
+    }
+    *cp = c;
+    return len;
+}
+
+// Last entry whose first code point is <= cp: a search without a data-dependent
+// exit, the same number of steps for every code point
+static const lcd_utf8Range *lcd_utf8Search(const lcd_utf8Range *table, uint16_t n, uint32_t cp)
+{
+    const lcd_utf8Range *base = table;
+
+    while (n > 1) {
+        uint16_t half = n / 2;
+        base = (base[half].first <= cp) ? base + half : base;
+        n -= half;
+    }
+    return base;
+}
+
+uint8_t LCD_Utf8RomCode(LCD_Rom rom, uint32_t cp)
+{
+    if (cp < 0x80) {
+        return (lcd_utf8AsciiMissing[rom][cp >> 3] & (1 << (cp & 7))) ? 0 : (uint8_t)cp;
+    }
+    if (cp > 0xFFFF) return 0;
+
+    const lcd_utf8Range *r = (rom == LCD_ROM_A02)
+                             ? lcd_utf8Search(lcd_utf8A02, LCD_UTF8_COUNT(lcd_utf8A02), cp)
+                             : lcd_utf8Search(lcd_utf8A00, LCD_UTF8_COUNT(lcd_utf8A00), cp);
+    // Unsigned: below the first entry wraps around and fails the test as well
+    uint32_t offset = cp - r->first;
+    return (offset < r->count) ? (uint8_t)(r->code + offset) : 0;
+}
+
+static const lcd_utf8Glyph *lcd_utf8FindGlyph(uint32_t cp)
+{
+    uint16_t lo = 0;
+    uint16_t n = LCD_UTF8_COUNT(lcd_utf8Glyphs);
+
+    while (n > 1) {
+        uint16_t half = n / 2;
+        lo = (lcd_utf8Glyphs[lo + half].cp <= cp) ? lo + half : lo;
+        n -= half;
+    }
+    return (lcd_utf8Glyphs[lo].cp == cp) ? &lcd_utf8Glyphs[lo] : NULL;
+}
+
+// Character code for a code point that isn't plain ASCII in this ROM
+static uint8_t lcd_utf8Map(LCD_Utf8 *text, uint32_t cp)
+{
+    uint8_t code = LCD_Utf8RomCode(text->rom, cp);
+    if (code != 0) {
+        text->stats.rom++;
+        return code;
+    }
+    if (cp == LCD_UTF8_REPLACEMENT) {
+        text->stats.invalid++;
+        return text->fallback;
+    }
+
+    const lcd_utf8Glyph *glyph = (text->glyphs != NULL) ? lcd_utf8FindGlyph(cp) : NULL;
+    if (glyph != NULL) {
+        int slot = LCD_GlyphGetId(text->glyphs, glyph->cp, glyph->rows);
+        if (slot >= 0) {
+            text->stats.synthesized++;
+            return (uint8_t)slot;
+        }
+    }
+    text->stats.replaced++;
+    return text->fallback;
+}
+
+// Next character code from *s: plain ASCII without a call, anything else decoded and looked up
+static uint8_t lcd_utf8Next(LCD_Utf8 *text, const char **s)
+{
+    uint8_t b = (uint8_t)**s;
+    const uint8_t *missing = lcd_utf8AsciiMissing[text->rom];
+
+    text->stats.chars++;
+    if (b < 0x80 && !(missing[b >> 3] & (1 << (b & 7)))) {
+        (*s)++;
+        return b;
+    }
+    uint32_t cp;
+    *s += LCD_Utf8Decode(*s, &cp);
+    return lcd_utf8Map(text, cp);
+}
+
+void LCD_Utf8Init(LCD_Utf8 *text, LiquidCrystal_C *lcd, LCD_Rom rom, LCD_GlyphCache *glyphs)
+{
+    memset(text, 0, sizeof(*text));
+    text->lcd = lcd;
+    text->rom = (rom == LCD_ROM_A02) ? LCD_ROM_A02 : LCD_ROM_A00;
+    text->glyphs = glyphs;
+    text->fallback = '?';
+}
+
+void LCD_Utf8SetFallback(LCD_Utf8 *text, uint8_t code)
+{
+    text->fallback = code;
+}
+
+size_t LCD_Utf8Transcode(LCD_Utf8 *text, const char *str, uint8_t *out, size_t max)
+{
+    size_t n = 0;
+
+    while (*str && n < max) {
+        out[n++] = lcd_utf8Next(text, &str);
+    }
+    return n;
+}
+
+void LCD_Utf8Write(LCD_Utf8 *text, const char *str)
+{
+    LCD_BeginBurst(text->lcd);
+    while (*str) {
+        // A glyph upload puts the cursor back, so the string carries on where it was
+        LCD_WriteChar(text->lcd, lcd_utf8Next(text, &str));
+    }
+    LCD_EndBurst(text->lcd);
+}
+
+uint8_t LCD_Utf8FbWrite(LCD_Utf8 *text, uint8_t col, uint8_t row, const char *str)
+{
+    LiquidCrystal_C *lcd = text->lcd;
+    uint8_t drawn = 0;
+
+    if (row >= lcd->numlines) return 0;
+    while (*str && col < lcd->numcols) {
+        // Take the cell out of the glyph cache's visibility scan first, so the glyph
+        // it held can be replaced
+        LCD_FbPutChar(lcd, col, row, ' ');
+        LCD_FbPutChar(lcd, col++, row, lcd_utf8Next(text, &str));
+        drawn++;
+    }
+    return drawn;
+}
+
+void LCD_Utf8GetStats(const LCD_Utf8 *text, LCD_Utf8Stats *stats)
+{
+    *stats = text->stats;
+}
+
+void LCD_Utf8ResetStats(LCD_Utf8 *text)
+{
+    memset(&text->stats, 0, sizeof(text->stats));
+}
@@ -0,0 +1,73 @@
+#ifndef LCD_UTF8_H
+#define LCD_UTF8_H
+
+#include <stddef.h>
+#include "LiquidCrystal_C.h"
+#include "LCD_Glyph.h"
+
+/******************************************************************************
+ * UTF-8 text
+ *
+ * Writes UTF-8 strings in the character set of the controller's ROM: the A00
+ * (Japanese) or the A02 (European) ROM. ASCII goes straight through, other code
+ * points are looked up in small sorted tables of ranges (Latin-1, Greek,
+ * Cyrillic, katakana, units and arrows, and lookalikes such as Cyrillic A
+ * for Latin A). Code points the ROM doesn't have but for which a 5x8 bitmap is
+ * built in (e.g. A umlaut, e acute, the euro sign, and backslash and tilde on
+ * the A00) are uploaded into CGRAM through a glyph cache, with the code point
+ * as glyph ID. Anything else is drawn as the fallback character ('?' by default).
+ *
+ * Nothing is allocated; decoding and lookups are table driven, so text that
+ * needs no CGRAM glyph costs about the same per character as ASCII. Bytes below
+ * 0x20 are passed through, so custom characters can still be embedded.
+ *
+ * The glyph cache only knows which glyphs are visible from the framebuffer:
+ * with LCD_Utf8Write(), which writes at the cursor, keep to 8 synthesized
+ * characters on screen at a time, or draw with LCD_Utf8FbWrite() instead.
+ ******************************************************************************/
+#define LCD_UTF8_REPLACEMENT 0xFFFD // code point decoded from malformed input
+
+typedef enum {
+    LCD_ROM_A00 = 0, // Japanese: ASCII (yen sign and right arrow for backslash and tilde), katakana, Greek
+    LCD_ROM_A02,     // European: ASCII, Latin-1, Cyrillic and Greek
+} LCD_Rom;
+
+typedef struct {
+    uint32_t chars;       // code points written
+    uint32_t rom;         // non-ASCII code points found in the ROM
+    uint32_t synthesized; // code points drawn with a CGRAM glyph
+    uint32_t replaced;    // code points drawn as the fallback character
+    uint32_t invalid;     // malformed UTF-8 sequences (drawn as the fallback too)
+} LCD_Utf8Stats;
+
+typedef struct {
+    LiquidCrystal_C *lcd;
+    LCD_Rom rom;
+    LCD_GlyphCache *glyphs; // NULL = no CGRAM glyphs, use the fallback
+    uint8_t fallback;
+    LCD_Utf8Stats stats;
+} LCD_Utf8;
+
+// glyphs may be NULL, or a cache that may be shared with other glyphs of the UI
+void LCD_Utf8Init(LCD_Utf8 *text, LiquidCrystal_C *lcd, LCD_Rom rom, LCD_GlyphCache *glyphs);
+void LCD_Utf8SetFallback(LCD_Utf8 *text, uint8_t code);
+
+// Decode the code point at s into *cp and return the bytes it takes (at least 1).
+// Malformed input gives LCD_UTF8_REPLACEMENT and skips the bytes that were read.
+uint8_t LCD_Utf8Decode(const char *s, uint32_t *cp);
+// Character code of cp in the ROM's table, 0 if the ROM doesn't have it
+uint8_t LCD_Utf8RomCode(LCD_Rom rom, uint32_t cp);
+
+// Transcode str into at most max character codes, uploading glyphs as needed.
+// Returns the number of codes; codes 0..7 are CGRAM slots, so it isn't terminated.
+size_t LCD_Utf8Transcode(LCD_Utf8 *text, const char *str, uint8_t *out, size_t max);
+// Write str at the cursor, like LCD_WriteString()
+void LCD_Utf8Write(LCD_Utf8 *text, const char *str);
+// Draw str into the framebuffer from (col, row), clipped at the end of the row.
+// Returns the number of cells drawn.
+uint8_t LCD_Utf8FbWrite(LCD_Utf8 *text, uint8_t col, uint8_t row, const char *str);
+
+void LCD_Utf8GetStats(const LCD_Utf8 *text, LCD_Utf8Stats *stats);
+void LCD_Utf8ResetStats(LCD_Utf8 *text);
+
+#endif
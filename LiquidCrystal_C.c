@@ -1,36 +1,474 @@
 #include "LiquidCrystal_C.h"
+#include <string.h>
 #include "stm32f4xx_hal.h" // For HAL_Delay, etc. Replace with stm32f1xx_hal.h or whatever hardware you're using
 
+#define LCD_I2C_TIMEOUT 10 // ms, for the burst transport
+
+// Without a clock, waits shorter than this spin on a loop calibrated against the HAL
+// tick; longer ones go to HAL_Delay
+#define LCD_SPIN_MAX_US 2000
+#define LCD_SPIN_BATCH  16 // loops between tick reads while calibrating
+
+// Async queue records: a data run is its length (1..127) followed by the GPIO values
+#define LCD_ASYNC_RUN_MAX   0x7F
+#define LCD_ASYNC_TAG_DELAY 0x80 // followed by a 32-bit delay in microseconds
+#define LCD_ASYNC_TAG_DONE  0x81 // followed by a callback and its context pointer
+#define LCD_ASYNC_NO_RUN    0xFFFF
+
+// DDRAM address of the first column of each row
+static const uint8_t lcd_row_offsets[4] = {0x00, 0x40, 0x14, 0x54};
+
+// Instrumentation hooks compile to nothing unless LCD_ENABLE_INSTRUMENTATION is defined
+#ifdef LCD_ENABLE_INSTRUMENTATION
+#define LCD_INSTR(stmt) do { stmt; } while (0)
+#else
+#define LCD_INSTR(stmt) do { } while (0)
+#endif
+
+// Pin map: constants when it is fixed at compile time, else built by LCD_Init()
+#ifdef LCD_FIXED_PINS
+#define LCD_PIN_BIT(pin) ((pin) == 0xFF ? 0u : (1u << (pin)))
+#define LCD_FIXED_NIBBLE(n, p0, p1, p2, p3) \
+    ((((n) & 1) ? LCD_PIN_BIT(p0) : 0u) | (((n) & 2) ? LCD_PIN_BIT(p1) : 0u) | \
+     (((n) & 4) ? LCD_PIN_BIT(p2) : 0u) | (((n) & 8) ? LCD_PIN_BIT(p3) : 0u))
+#define LCD_FIXED_LO(n) LCD_FIXED_NIBBLE(n, LCD_PIN_D0, LCD_PIN_D1, LCD_PIN_D2, LCD_PIN_D3)
+#define LCD_FIXED_HI(n) (LCD_PIN_FOURBIT ? 0u : LCD_FIXED_NIBBLE(n, LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6, LCD_PIN_D7))
+#define LCD_FIXED_ROW(f, extra) { \
+    f(0) extra, f(1) extra, f(2) extra, f(3) extra, f(4) extra, f(5) extra, f(6) extra, f(7) extra, \
+    f(8) extra, f(9) extra, f(10) extra, f(11) extra, f(12) extra, f(13) extra, f(14) extra, f(15) extra }
+
+static const uint16_t lcd_fixed_nibble[2][16] = {
+    LCD_FIXED_ROW(LCD_FIXED_LO, ),
+    LCD_FIXED_ROW(LCD_FIXED_LO, | LCD_PIN_BIT(LCD_PIN_RS)),
+};
+static const uint16_t lcd_fixed_hi[16] = LCD_FIXED_ROW(LCD_FIXED_HI, );
+
+#define LCD_NIBBLE(lcd, mode, n) (lcd_fixed_nibble[mode][n])
+#define LCD_NIBBLE_HI(lcd, n)    (lcd_fixed_hi[n])
+#define LCD_DATA_MASK(lcd)       ((uint16_t)(LCD_FIXED_LO(15) | LCD_FIXED_HI(15)))
+#define LCD_BUS_MASK(lcd)        ((uint16_t)(LCD_DATA_MASK(lcd) | LCD_PIN_BIT(LCD_PIN_RS) | LCD_PIN_BIT(LCD_PIN_RW) | \
+                                             LCD_PIN_BIT(LCD_PIN_EN) | LCD_PIN_BIT(LCD_PIN_EN2)))
+#if LCD_PIN_EN2 == 0xFF
+#define LCD_EN_BITS(lcd, sel)    ((uint16_t)LCD_PIN_BIT(LCD_PIN_EN))
+#else
+#define LCD_EN_BITS(lcd, sel)    ((uint16_t)((((sel) & 1) ? LCD_PIN_BIT(LCD_PIN_EN) : 0u) | \
+                                             (((sel) & 2) ? LCD_PIN_BIT(LCD_PIN_EN2) : 0u)))
+#endif
+#define LCD_EIGHTBIT(lcd)        (!LCD_PIN_FOURBIT)
+#else
+#define LCD_NIBBLE(lcd, mode, n) ((lcd)->nibble_lut[mode][n])
+#define LCD_NIBBLE_HI(lcd, n)    ((lcd)->nibble_hi_lut[n])
+#define LCD_DATA_MASK(lcd)       ((lcd)->data_mask)
+#define LCD_BUS_MASK(lcd)        ((lcd)->bus_mask)
+#define LCD_EN_BITS(lcd, sel)    ((lcd)->en_bits[sel])
+#define LCD_EIGHTBIT(lcd)        ((lcd)->displayfunction & LCD_8BITMODE)
+#endif
+
 /*******************************************************************************
  * STATIC HELPER FUNCTIONS
  ******************************************************************************/
 
 // Low-level: write a command (mode=0) or data (mode=1).
-static void lcd_send(LiquidCrystal_C *lcd, uint8_t value, bool mode);
-static void lcd_write4bits(LiquidCrystal_C *lcd, uint8_t value);
-static void lcd_write8bits(LiquidCrystal_C *lcd, uint8_t value);
+static void lcd_send(LiquidCrystal_C *lcd, uint8_t sel, uint8_t value, bool mode);
+static void lcd_write4bits(LiquidCrystal_C *lcd, uint8_t value, bool mode);
+static void lcd_write8bits(LiquidCrystal_C *lcd, uint8_t value, bool mode);
 static void lcd_pulseEnable(LiquidCrystal_C *lcd);
+static void lcd_enableWait(LiquidCrystal_C *lcd);
+static void lcd_buildNibbleTables(LiquidCrystal_C *lcd);
+static void lcd_flushBurst(LiquidCrystal_C *lcd);
+static void lcd_delayUs(LiquidCrystal_C *lcd, uint32_t us);
+static bool lcd_pollBusy(LiquidCrystal_C *lcd);
+static uint32_t lcd_pollCostUs(const LiquidCrystal_C *lcd);
+static void lcd_asyncAppend(LiquidCrystal_C *lcd, uint16_t value);
+static void lcd_asyncDelay(LiquidCrystal_C *lcd, uint32_t us);
+static void lcd_asyncFinishImplicit(LiquidCrystal_C *lcd);
+static void lcd_asyncReset(LiquidCrystal_C *lcd);
+static uint32_t lcd_nowUs(LiquidCrystal_C *lcd);
+static uint32_t lcd_tickWait(const LiquidCrystal_C *lcd, uint32_t us);
+static void lcd_trackState(LiquidCrystal_C *lcd, LCD_ControllerState *st, uint8_t value, bool mode);
+static void lcd_updateControl(LiquidCrystal_C *lcd);
+#ifdef LCD_ENABLE_INSTRUMENTATION
+static void lcd_instrEnter(LiquidCrystal_C *lcd);
+static void lcd_instrLeave(LiquidCrystal_C *lcd, LCD_ApiId id);
+#endif
+
+/*******************************************************************************
+ * BUILT-IN MCP23008 TRANSPORT
+ ******************************************************************************/
+// One MCP23008_WriteGPIO() per value, or one I2C write per batch once LCD_EnableBurst()
+// has set IOCON.SEQOP so every byte lands in the GPIO register
+static bool lcd_mcpWrite(void *ctx, const uint8_t *values, uint16_t len)
+{
+    LiquidCrystal_C *lcd = (LiquidCrystal_C *)ctx;
+
+    if (lcd->burst_i2c != NULL) {
+        return HAL_I2C_Mem_Write(lcd->burst_i2c, lcd->burst_addr << 1, LCD_MCP23008_GPIO, I2C_MEMADD_SIZE_8BIT,
+                                 (uint8_t *)values, len, LCD_I2C_TIMEOUT) == HAL_OK;
+    }
+    for (uint16_t i = 0; i < len; i++) {
+        MCP23008_WriteGPIO(lcd->mcp, values[i]);
+    }
+    return true;
+}
+
+static bool lcd_mcpRead(void *ctx, uint16_t *levels)
+{
+    LiquidCrystal_C *lcd = (LiquidCrystal_C *)ctx;
+
+    *levels = MCP23008_ReadGPIO(lcd->mcp);
+    return true;
+}
+
+static bool lcd_mcpSetInputs(void *ctx, uint16_t mask)
+{
+    LiquidCrystal_C *lcd = (LiquidCrystal_C *)ctx;
+
+    MCP23008_SetDirection(lcd->mcp, (uint8_t)mask);
+    return true;
+}
+
+static bool lcd_mcpWriteAsync(void *ctx, const uint8_t *values, uint16_t len, bool dma)
+{
+    LiquidCrystal_C *lcd = (LiquidCrystal_C *)ctx;
+    HAL_StatusTypeDef status;
+
+    if (lcd->burst_i2c == NULL) return false;
+    if (dma) {
+        status = HAL_I2C_Mem_Write_DMA(lcd->burst_i2c, lcd->burst_addr << 1, LCD_MCP23008_GPIO,
+                                       I2C_MEMADD_SIZE_8BIT, (uint8_t *)values, len);
+    } else {
+        status = HAL_I2C_Mem_Write_IT(lcd->burst_i2c, lcd->burst_addr << 1, LCD_MCP23008_GPIO,
+                                      I2C_MEMADD_SIZE_8BIT, (uint8_t *)values, len);
+    }
+    return status == HAL_OK;
+}
+
+static const LCD_TransportOps lcd_mcp23008Ops = {
+    lcd_mcpWrite, lcd_mcpRead, lcd_mcpSetInputs, lcd_mcpWriteAsync
+};
+
+// Bursts and the async engine only become available with LCD_EnableBurst()
+static void lcd_useMcp23008(LiquidCrystal_C *lcd)
+{
+    lcd->transport.ops           = &lcd_mcp23008Ops;
+    lcd->transport.ctx           = lcd;
+    lcd->transport.caps          = LCD_TRANSPORT_READ;
+    lcd->transport.value_bytes   = 1;
+    lcd->transport.max_batch     = LCD_BURST_BUFSIZE;
+    lcd->transport.transfer_bits = LCD_I2C_OVERHEAD_BITS;
+    lcd->transport.value_bits    = LCD_I2C_BYTE_BITS;
+    lcd->transport.read_bits     = LCD_I2C_READ_BITS;
+}
+
+static bool lcd_usesMcp23008(const LiquidCrystal_C *lcd)
+{
+    return lcd->transport.ops == &lcd_mcp23008Ops;
+}
+
+// True if the controller is known to be in the state this command would put it in
+static bool lcd_redundant(const LCD_ControllerState *st, uint8_t value)
+{
+    if (value & LCD_SETDDRAMADDR) {
+        return st->ac_valid && !st->ac_cgram && st->ac == (value & 0x7F);
+    }
+    if (value & LCD_SETCGRAMADDR) {
+        return st->ac_valid && st->ac_cgram && st->ac == (value & 0x3F);
+    }
+    if (value & (LCD_FUNCTIONSET | LCD_CURSORSHIFT)) {
+        return false;
+    }
+    if (value & LCD_DISPLAYCONTROL) {
+        return st->control_valid && st->control == (value & 0x07);
+    }
+    if (value & LCD_ENTRYMODESET) {
+        return st->entrymode_valid && st->entrymode == (value & 0x03);
+    }
+    if (value & LCD_RETURNHOME) {
+        return st->ac_valid && !st->ac_cgram && st->ac == 0 && st->shift_valid && st->shift == 0;
+    }
+    return false; // clear display
+}
+
+// Every controller on the handle, as a set
+static uint8_t lcd_allCtrl(const LiquidCrystal_C *lcd)
+{
+    return (1 << lcd->num_ctrl) - 1;
+}
+
+// Send a command to the controllers in sel (mode=false for command mode), except
+// those it would change nothing on. It goes out once to all the others.
+static void lcd_commandTo(LiquidCrystal_C *lcd, uint8_t sel, uint8_t value)
+{
+    uint8_t send = 0;
+
+    // Data bytes go where the address was last set
+    if (value & (LCD_SETDDRAMADDR | LCD_SETCGRAMADDR)) {
+        lcd->data_sel = sel;
+    }
+    for (int c = 0; c < lcd->num_ctrl; c++) {
+        if ((sel & (1 << c)) && !lcd_redundant(&lcd->ctrl[c], value)) {
+            send |= 1 << c;
+        }
+    }
+    if (send == 0) {
+        lcd->stats.commands_elided++;
+        return;
+    }
+    lcd_send(lcd, send, value, false);
+}
 
-// Send a command to the LCD (mode=false for command mode)
+// Commands that move the cursor go to the controller holding it, the rest to all
 static void lcd_command(LiquidCrystal_C *lcd, uint8_t value) {
-    lcd_send(lcd, value, false);
+    bool cursor_move = value < LCD_FUNCTIONSET && (value & LCD_CURSORSHIFT) && !(value & LCD_DISPLAYMOVE);
+
+    if ((value & LCD_SETDDRAMADDR) || cursor_move) {
+        lcd_commandTo(lcd, 1 << lcd->cur_ctrl, value);
+    } else {
+        lcd_commandTo(lcd, lcd_allCtrl(lcd), value);
+    }
+}
+
+// Controller showing a row, and the DDRAM address of the row's first column there
+static uint8_t lcd_rowCtrl(const LiquidCrystal_C *lcd, uint8_t row)
+{
+    return row / lcd->ctrl_lines;
+}
+
+static uint8_t lcd_rowOffset(const LiquidCrystal_C *lcd, uint8_t row)
+{
+    return lcd_row_offsets[row % lcd->ctrl_lines];
+}
+
+// Move the cursor to another controller: only that one may show it
+static void lcd_selectCtrl(LiquidCrystal_C *lcd, uint8_t c)
+{
+    if (c == lcd->cur_ctrl) return;
+    lcd->cur_ctrl = c;
+    if (lcd->displaycontrol & (LCD_CURSORON | LCD_BLINKON)) {
+        lcd_updateControl(lcd);
+    }
+}
+
+// Count a write or read of the expander
+static void lcd_countWrite(LiquidCrystal_C *lcd)
+{
+    lcd->stats.writes++;
+    LCD_INSTR(lcd->instr.expander_writes++);
+}
+
+static void lcd_countRead(LiquidCrystal_C *lcd)
+{
+    lcd->stats.reads++;
+    LCD_INSTR(lcd->instr.expander_reads++);
+}
+
+// Count a transfer the transport reported as failed
+static void lcd_countError(LiquidCrystal_C *lcd)
+{
+    lcd->stats.errors++;
+    LCD_INSTR(lcd->instr.hal_errors++);
+}
+
+// True while GPIO values are being collected into a burst
+static bool lcd_bursting(const LiquidCrystal_C *lcd)
+{
+    return lcd->burst_depth > 0 && (lcd->transport.caps & LCD_TRANSPORT_BURST);
+}
+
+// Hand values to the transport in one write
+static void lcd_transportWrite(LiquidCrystal_C *lcd, const uint8_t *values, uint16_t len)
+{
+    if (!lcd->transport.ops->write(lcd->transport.ctx, values, len)) {
+        lcd_countError(lcd);
+    }
+    lcd_countWrite(lcd);
+}
+
+// Count bus time against the execution time of the last instruction
+static void lcd_busElapsed(LiquidCrystal_C *lcd, uint32_t bits)
+{
+    uint32_t us = (uint32_t)(((uint64_t)bits * 1000000) / lcd->bus_hz);
+    lcd->pending_us = (us >= lcd->pending_us) ? 0 : lcd->pending_us - us;
+}
+
+// Append a value to the burst buffer, sending the burst once the next one wouldn't fit
+static void lcd_burstAppend(LiquidCrystal_C *lcd, uint16_t value)
+{
+    uint8_t width = lcd->transport.value_bytes;
+
+    lcd->burst_buf[lcd->burst_len++] = (uint8_t)value;
+    if (width > 1) {
+        lcd->burst_buf[lcd->burst_len++] = (uint8_t)(value >> 8);
+    }
+    lcd_busElapsed(lcd, lcd->transport.value_bits);
+    if (lcd->burst_len + width > lcd->burst_max) {
+        lcd_flushBurst(lcd);
+    }
+}
+
+// Hand one GPIO value to the async queue, the burst buffer or straight to the expander
+static void lcd_emit(LiquidCrystal_C *lcd, uint16_t value)
+{
+    uint8_t bytes[2] = { (uint8_t)value, (uint8_t)(value >> 8) };
+
+    lcd->stats.gpio_bytes += lcd->transport.value_bytes;
+    if (lcd->tap != NULL) {
+        lcd->tap(lcd->tap_ctx, value, lcd_nowUs(lcd), lcd->tap_sync);
+        lcd->tap_sync = false;
+    }
+
+    if (lcd->async.enabled) {
+        lcd_asyncAppend(lcd, value);
+        return;
+    }
+    if (lcd_bursting(lcd)) {
+        lcd_burstAppend(lcd, value);
+        return;
+    }
+    lcd_transportWrite(lcd, bytes, lcd->transport.value_bytes);
+    lcd_busElapsed(lcd, lcd->transport.transfer_bits + lcd->transport.value_bits);
+}
+
+// Write a full GPIO value through the shadow register. The write is skipped if the
+// output latch already holds this value.
+static void lcd_writeGPIO(LiquidCrystal_C *lcd, uint16_t value)
+{
+    if (lcd->gpio_shadow_valid && value == lcd->gpio_shadow) {
+        lcd->stats.writes_saved++;
+        return;
+    }
+    lcd->gpio_shadow = value;
+    lcd->gpio_shadow_valid = true;
+    lcd_emit(lcd, value);
+}
+
+// Wait until the last instruction has finished executing. Only the part of its
+// execution time not already spent on the bus is waited out.
+static void lcd_waitReady(LiquidCrystal_C *lcd)
+{
+    if (lcd->pending_us == 0) return;
+
+    // Long waits (clear, home) are worth asking the controller whether it's done early
+    if (lcd->busy_poll && !lcd->async.enabled && lcd->pending_us > lcd_pollCostUs(lcd)) {
+        if (lcd_pollBusy(lcd)) {
+            lcd->pending_us = 0;
+            return;
+        }
+        // The busy flag never cleared, so it can't be trusted: use fixed delays from now on
+        lcd->busy_poll = false;
+    }
+
+    bool in_burst = lcd_bursting(lcd) && lcd->burst_len > 0;
+    bool in_run = lcd->async.capturing && lcd->async.run_at != LCD_ASYNC_NO_RUN;
+    if ((in_burst || in_run) && lcd->transport.value_bits != 0) {
+        // Short waits are cheaper as repeats of the current GPIO value than as a new transaction.
+        // How many repeats depends on the bus clock: one covers an instruction at 100 kHz, it
+        // takes two at 400 kHz and five at 1 MHz, past LCD_BURST_PAD_MAX.
+        uint32_t wait_bits = (uint32_t)(((uint64_t)lcd->pending_us * lcd->bus_hz + 999999) / 1000000);
+        uint32_t pad = (wait_bits + lcd->transport.value_bits - 1) / lcd->transport.value_bits;
+        if (pad <= LCD_BURST_PAD_MAX) {
+            while (pad-- > 0 && lcd->pending_us > 0) {
+                lcd_emit(lcd, lcd->gpio_shadow);
+            }
+            if (lcd->pending_us == 0) return;
+        }
+    }
+    lcd_delayUs(lcd, lcd->pending_us);
+}
+
+// Current GPIO state, only reading the expander the first time
+static uint16_t lcd_readShadow(LiquidCrystal_C *lcd)
+{
+    if (lcd->gpio_shadow_valid) {
+        lcd->stats.reads_saved++;
+    } else {
+        LCD_SyncGPIO(lcd);
+    }
+    return lcd->gpio_shadow;
 }
 
 // Replicate digitalWrite() style bit setting to set or clear a bit on the MCP23008
 static void lcd_digitalWrite(LiquidCrystal_C *lcd, uint8_t pin, bool level)
 {
     if (pin == 0xFF) return; // if invalid or unused, skip it
+    LCD_INSTR(lcd->instr.pin_writes++);
 
-    // 1) Read current GPIO state
-    uint8_t current = MCP23008_ReadGPIO(lcd->mcp);
+    // 1) Get the current GPIO state
+    uint16_t current = lcd_readShadow(lcd);
     // 2) Modify the bit
     if (level) {
-        current |= (1 << pin);
+        current |= (1u << pin);
     } else {
-        current &= ~(1 << pin);
+        current &= ~(1u << pin);
     }
     // 3) Write the new GPIO state
-    MCP23008_WriteGPIO(lcd->mcp, current);
+    lcd_writeGPIO(lcd, current);
+}
+
+// Turn the data pins into inputs and raise RW so the controller can drive them.
+// Returns the GPIO value to put back afterwards: a poll before an enable pulse
+// must not lose the nibble already set up on the data pins.
+static uint16_t lcd_statusBegin(LiquidCrystal_C *lcd)
+{
+    uint16_t saved = lcd_readShadow(lcd);
+
+    lcd_flushBurst(lcd);
+    if (!lcd->transport.ops->set_inputs(lcd->transport.ctx, lcd->iodir | LCD_DATA_MASK(lcd))) {
+        lcd_countError(lcd);
+    }
+    lcd_countWrite(lcd);
+    lcd_busElapsed(lcd, lcd->transport.transfer_bits + lcd->transport.value_bits);
+
+    uint16_t current = lcd_readShadow(lcd) & ~LCD_BUS_MASK(lcd);
+    lcd_writeGPIO(lcd, current | (1u << lcd->rw_pin));
+    return saved;
+}
+
+// One enable cycle of a status read on the controller with enable en, returning the
+// bits seen on the first 'bits' data pins
+static uint8_t lcd_readCycle(LiquidCrystal_C *lcd, uint16_t en, int bits)
+{
+    uint8_t value = 0;
+    uint16_t gpio = 0;
+
+    lcd_writeGPIO(lcd, lcd_readShadow(lcd) | en);
+    lcd_flushBurst(lcd);
+    if (!lcd->transport.ops->read(lcd->transport.ctx, &gpio)) {
+        lcd_countError(lcd);
+    }
+    lcd_countRead(lcd);
+    lcd_busElapsed(lcd, lcd->transport.read_bits);
+    lcd_writeGPIO(lcd, lcd_readShadow(lcd) & ~en);
+
+    for (int i = 0; i < bits; i++) {
+        if (lcd->data_pins[i] != 0xFF && (gpio & (1u << lcd->data_pins[i]))) {
+            value |= (1 << i);
+        }
+    }
+    return value;
+}
+
+// Read the busy flag and address counter of one controller (one or two enable cycles)
+static uint8_t lcd_statusRead(LiquidCrystal_C *lcd, uint16_t en)
+{
+    if (LCD_EIGHTBIT(lcd)) {
+        return lcd_readCycle(lcd, en, 8);
+    }
+    uint8_t value = lcd_readCycle(lcd, en, 4) << 4;
+    return value | lcd_readCycle(lcd, en, 4);
+}
+
+// Drop RW, give the data pins back to the driver and restore what they held
+static void lcd_statusEnd(LiquidCrystal_C *lcd, uint16_t saved)
+{
+    lcd_digitalWrite(lcd, lcd->rw_pin, false);
+    lcd_flushBurst(lcd);
+    if (!lcd->transport.ops->set_inputs(lcd->transport.ctx, lcd->iodir)) {
+        lcd_countError(lcd);
+    }
+    lcd_countWrite(lcd);
+    lcd_busElapsed(lcd, lcd->transport.transfer_bits + lcd->transport.value_bits);
+    lcd_writeGPIO(lcd, saved);
 }
 
 /*******************************************************************************
@@ -44,11 +482,35 @@ void LCD_Init(LiquidCrystal_C *lcd,
               uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
               uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7)
 {
+#ifdef LCD_FIXED_PINS
+    // Built for one wiring: the pin arguments are ignored
+    (void)fourbitmode;
+    fourbitmode = LCD_PIN_FOURBIT;
+    rs_pin = LCD_PIN_RS;
+    rw_pin = LCD_PIN_RW;
+    enable_pin = LCD_PIN_EN;
+    d0 = LCD_PIN_D0; d1 = LCD_PIN_D1; d2 = LCD_PIN_D2; d3 = LCD_PIN_D3;
+    d4 = LCD_PIN_D4; d5 = LCD_PIN_D5; d6 = LCD_PIN_D6; d7 = LCD_PIN_D7;
+#endif
     lcd->mcp = mcp;
+    lcd_useMcp23008(lcd);
 
     lcd->rs_pin     = rs_pin;
     lcd->rw_pin     = rw_pin;   // 255 if unused
-    lcd->enable_pin = enable_pin;
+    lcd->enable_pins[0] = enable_pin;
+    for (int c = 1; c < LCD_MAX_CONTROLLERS; c++) {
+        lcd->enable_pins[c] = 0xFF;
+    }
+    lcd->num_ctrl = 1;
+#if defined(LCD_FIXED_PINS) && LCD_PIN_EN2 != 0xFF
+    lcd->enable_pins[1] = LCD_PIN_EN2;
+    lcd->num_ctrl = 2;
+#endif
+    lcd->ctrl_lines = 1;
+    lcd->cur_ctrl   = 0;
+    lcd->data_sel   = 1;
+    lcd->send_sel   = 1;
+    lcd->busy_sel   = 1;
 
     lcd->data_pins[0] = d0;
     lcd->data_pins[1] = d1;
@@ -58,6 +520,11 @@ void LCD_Init(LiquidCrystal_C *lcd,
     lcd->data_pins[5] = d5;
     lcd->data_pins[6] = d6;
     lcd->data_pins[7] = d7;
+#ifdef LCD_FIXED_PINS
+    lcd->backlight_pin = LCD_PIN_BL;
+#else
+    lcd->backlight_pin = LCD_BACKLIGHT_PIN;
+#endif
 
     if (fourbitmode) {
         lcd->displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
@@ -65,244 +532,1736 @@ void LCD_Init(LiquidCrystal_C *lcd,
         lcd->displayfunction = LCD_8BITMODE | LCD_1LINE | LCD_5x8DOTS;
     }
 
+    lcd->displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+    lcd->displaymode    = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+
     lcd->numlines  = 1;
     lcd->currline  = 0;
+    lcd->numcols   = 0;
+    lcd->fb_redraw = true;
+
+    LCD_InvalidateState(lcd);
+
+    lcd->gpio_shadow       = 0;
+    lcd->gpio_shadow_valid = false;
+    LCD_ResetBusStats(lcd);
+
+    lcd->burst_i2c   = NULL;
+    lcd->burst_addr  = 0;
+    lcd->burst_max   = LCD_BURST_BUFSIZE;
+    lcd->burst_len   = 0;
+    lcd->burst_depth = 0;
+
+    lcd->tap      = NULL;
+    lcd->tap_ctx  = NULL;
+    lcd->tap_sync = true;
+
+    lcd->clock.now_us   = NULL;
+    lcd->clock.delay_us = NULL;
+    lcd->clock.ctx      = NULL;
+    lcd->bus_hz         = LCD_DEFAULT_BUS_HZ;
+    lcd->pending_us     = 0;
+
+    lcd->busy_poll       = (rw_pin != 0xFF);
+    lcd->busy_timeout_us = LCD_BUSY_TIMEOUT_US;
+    lcd->iodir           = 0x00;
+
+    lcd->async.enabled   = false;
+    lcd->async.use_dma   = false;
+    lcd->async.tx_fn     = NULL;
+    lcd->async.tx_ctx    = NULL;
+    lcd->async.timer_fn  = NULL;
+    lcd->async.timer_ctx = NULL;
+    lcd_asyncReset(lcd);
+
+    lcd->warm      = NULL;
+    lcd->init_step = 0;
+    lcd->cgram_depth = 0;
+
+#ifdef LCD_ENABLE_INSTRUMENTATION
+    lcd->instr.api_depth = 0;
+    LCD_ResetInstrumentation(lcd);
+#endif
+
+    lcd_buildNibbleTables(lcd);
 }
 
-// Finalize LCD initialization and configure display parameters
-bool LCD_Begin(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize)
+#ifdef LCD_FIXED_PINS
+void LCD_InitFixed(LiquidCrystal_C *lcd, MCP23008_HandleTypeDef *mcp)
+{
+    LCD_Init(lcd, mcp, LCD_PIN_FOURBIT, LCD_PIN_RS, LCD_PIN_RW, LCD_PIN_EN,
+             LCD_PIN_D0, LCD_PIN_D1, LCD_PIN_D2, LCD_PIN_D3,
+             LCD_PIN_D4, LCD_PIN_D5, LCD_PIN_D6, LCD_PIN_D7);
+}
+#endif
+
+// Geometry and function set flags for LCD_Begin() and its variants
+static void lcd_beginSetup(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize)
 {
+    // Nothing is known about the controller until the init sequence has run
+    LCD_InvalidateState(lcd);
+    lcd->init_step = 0;
+
+    lcd->numlines = (lines > LCD_MAX_LINES) ? LCD_MAX_LINES : lines;
+    lcd->numcols  = (cols > LCD_MAX_COLS) ? LCD_MAX_COLS : cols;
+    if (lcd->numlines == 0) lcd->numlines = 1;
+    // Each controller gets its share of the lines: a 40x4 module is two 40x2 ones
+    lcd->ctrl_lines = (lcd->numlines + lcd->num_ctrl - 1) / lcd->num_ctrl;
+    lcd->cur_ctrl = 0;
+
     // Check if we have two lines
-    if (lines > 1) {
+    if (lcd->ctrl_lines > 1) {
         lcd->displayfunction |= LCD_2LINE;
     }
-    lcd->numlines = lines;
+    LCD_FbClear(lcd);
 
     // 5x10 font if we only have 1 line
     if ((dotsize != 0) && (lines == 1)) {
         lcd->displayfunction |= LCD_5x10DOTS;
     }
+}
 
-    // Wait for LCD power up
-    HAL_Delay(50);
-
-    // Set RS, EN, RW low
+// Set EN, RS, RW low. EN goes first: some expanders (PCF8574) come up with every pin
+// high, and RS must not change while EN is high.
+static void lcd_beginPins(LiquidCrystal_C *lcd)
+{
+    for (int c = 0; c < lcd->num_ctrl; c++) {
+        lcd_digitalWrite(lcd, lcd->enable_pins[c], false);
+    }
     lcd_digitalWrite(lcd, lcd->rs_pin, false);
-    lcd_digitalWrite(lcd, lcd->enable_pin, false);
     if (lcd->rw_pin != 0xFF) {
         lcd_digitalWrite(lcd, lcd->rw_pin, false);
     }
+}
 
-    // HD44780 initialization sequence for 4-bit or 8-bit mode
-    if (!(lcd->displayfunction & LCD_8BITMODE)) {
-        // 4-bit mode
-        lcd_write4bits(lcd, 0x03);
-        HAL_Delay(5);
-        lcd_write4bits(lcd, 0x03);
-        HAL_Delay(5);
-        lcd_write4bits(lcd, 0x03);
-        HAL_Delay(1);
-        lcd_write4bits(lcd, 0x02);
-    } else {
-        // 8-bit mode
-        lcd_command(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
-        HAL_Delay(5);
-        lcd_command(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
-        HAL_Delay(1);
+// One step of the HD44780 initialization sequence for 4-bit or 8-bit mode: three
+// function sets for 8 bits, then (4-bit mode) the switch to 4 bits, each followed by
+// wait_us. The busy flag can't be read until the interface width is set, so these
+// waits are always fixed. Returns false once every step has been sent.
+static bool lcd_beginWake(LiquidCrystal_C *lcd, uint8_t step, uint32_t wait_us)
+{
+    if (step >= (LCD_EIGHTBIT(lcd) ? 3 : 4)) return false;
+
+    bool busy_poll = lcd->busy_poll;
+    lcd->busy_poll = false;
+    lcd->send_sel = lcd_allCtrl(lcd);
+    lcd->busy_sel = lcd_allCtrl(lcd);
+    if (LCD_EIGHTBIT(lcd)) {
         lcd_command(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
+    } else {
+        lcd->tap_sync = true;
+        lcd_write4bits(lcd, (step < 3) ? 0x03 : 0x02, false);
     }
+    lcd->pending_us = wait_us;
+    lcd->busy_poll = busy_poll;
+    return true;
+}
 
+// Waits after each step of a cold start, from the datasheet
+static const uint32_t lcd_wake_cold_us[4] = { LCD_INIT_WAIT1_US, LCD_INIT_WAIT2_US, LCD_EXEC_US, LCD_EXEC_US };
+// A controller already running in 4-bit mode may be half way through a byte: the
+// first nibble then completes some instruction ending in 0x3, return home at worst
+static const uint32_t lcd_wake_warm_us[4] = { LCD_EXEC_HOME_US, LCD_EXEC_US, LCD_EXEC_US, LCD_EXEC_US };
+
+static uint8_t lcd_warmCheck(const LCD_WarmMarker *m)
+{
+    return (uint8_t)~(m->displayfunction + m->displaycontrol + m->displaymode + m->numcols + m->numlines);
+}
+
+static void lcd_warmSave(LiquidCrystal_C *lcd)
+{
+    LCD_WarmMarker *m = lcd->warm;
+
+    if (m == NULL) return;
+    m->displayfunction = lcd->displayfunction;
+    m->displaycontrol  = lcd->displaycontrol;
+    m->displaymode     = lcd->displaymode;
+    m->numcols         = lcd->numcols;
+    m->numlines        = lcd->numlines;
+    m->check           = lcd_warmCheck(m);
+    m->magic           = LCD_WARM_MAGIC;
+}
+
+// Function set, display control and entry mode once the interface width is set
+static void lcd_beginFinish(LiquidCrystal_C *lcd, bool clear)
+{
     // set lines, font size, etc.
     lcd_command(lcd, LCD_FUNCTIONSET | lcd->displayfunction);
+    // display control and entry mode are the defaults (cold start) or as they were (warm start)
+    lcd_updateControl(lcd);
+    if (clear) {
+        // clear display, also sends the entry mode
+        LCD_Clear(lcd);
+    } else {
+        lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+        // Undo any display shift and put the cursor top left, leaving DDRAM alone
+        LCD_Home(lcd);
+        LCD_FbInvalidate(lcd);
+    }
+    lcd_warmSave(lcd);
+}
+
+static void lcd_beginCold(LiquidCrystal_C *lcd)
+{
+    // Wait for LCD power up
+    lcd_delayUs(lcd, LCD_POWERUP_US);
+    lcd_beginPins(lcd);
+    for (uint8_t step = 0; lcd_beginWake(lcd, step, lcd_wake_cold_us[step & 3]); step++) {
+    }
 
-    // turn on display, no cursor, no blink
+    // turn on display, no cursor, no blink; left to right, no shift
     lcd->displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
-    LCD_Display(lcd);
+    lcd->displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+    lcd_beginFinish(lcd, true);
+}
 
-    // clear display
-    LCD_Clear(lcd);
+// Finalize LCD initialization and configure display parameters
+bool LCD_Begin(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize)
+{
+    LCD_INSTR(lcd_instrEnter(lcd));
+    lcd_beginSetup(lcd, cols, lines, dotsize);
+    lcd_beginCold(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_BEGIN));
+    return true;
+}
 
-    // set mode: left to right, no shift
-    lcd->displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
-    lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+bool LCD_BeginWarm(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize, LCD_WarmMarker *marker)
+{
+    LCD_INSTR(lcd_instrEnter(lcd));
+    lcd_beginSetup(lcd, cols, lines, dotsize);
+    lcd->warm = marker;
+
+    bool can_read = lcd->rw_pin != 0xFF && (lcd->transport.caps & LCD_TRANSPORT_READ) && !lcd->async.enabled;
+    bool warm = can_read;
+    if (marker != NULL) {
+        warm = marker->magic == LCD_WARM_MAGIC && marker->check == lcd_warmCheck(marker)
+               && marker->displayfunction == lcd->displayfunction
+               && marker->numcols == lcd->numcols && marker->numlines == lcd->numlines;
+    }
+    if (warm) {
+        lcd_beginPins(lcd);
+        for (uint8_t step = 0; lcd_beginWake(lcd, step, lcd_wake_warm_us[step & 3]); step++) {
+        }
+        // A controller that lost power is busy with its own reset, or no longer in
+        // 4-bit mode by the time it could answer: only trust one that reads back ready
+        if (can_read) {
+            lcd->busy_sel = lcd_allCtrl(lcd);
+            lcd_delayUs(lcd, lcd->pending_us);
+            warm = lcd_pollBusy(lcd);
+        }
+    }
+    if (warm) {
+        if (marker != NULL) {
+            lcd->displaycontrol = marker->displaycontrol;
+            lcd->displaymode = marker->displaymode;
+        } else {
+            lcd->displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+            lcd->displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+        }
+        lcd_beginFinish(lcd, false);
+    } else {
+        lcd_beginCold(lcd);
+    }
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_BEGIN));
+    return warm;
+}
+
+void LCD_BeginStart(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize)
+{
+    lcd_beginSetup(lcd, cols, lines, dotsize);
+    lcd->init_step = 1;
+    lcd->init_at   = lcd_nowUs(lcd);
+    lcd->init_wait = lcd_tickWait(lcd, LCD_POWERUP_US);
+}
 
+bool LCD_BeginPoll(LiquidCrystal_C *lcd)
+{
+    while (lcd->init_step != 0) {
+        if (lcd->init_wait != 0) {
+            if ((uint32_t)(lcd_nowUs(lcd) - lcd->init_at) < lcd->init_wait) return false;
+            // Waited out here, not before the next enable pulse
+            lcd->init_wait  = 0;
+            lcd->pending_us = 0;
+        }
+        uint8_t step = lcd->init_step - 1;
+        if (step == 0) {
+            lcd_beginPins(lcd);
+        }
+        if (!lcd_beginWake(lcd, step, lcd_wake_cold_us[step & 3])) {
+            lcd->init_step = 0;
+            lcd->displaycontrol = LCD_DISPLAYON | LCD_CURSOROFF | LCD_BLINKOFF;
+            lcd->displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+            lcd_beginFinish(lcd, true);
+            break;
+        }
+        lcd->init_step++;
+        // Long waits go back to the caller, short ones to the next enable pulse
+        if (lcd->pending_us >= LCD_INIT_WAIT1_US) {
+            lcd_flushBurst(lcd);
+            lcd->init_at   = lcd_nowUs(lcd);
+            lcd->init_wait = lcd_tickWait(lcd, lcd->pending_us);
+        }
+    }
     return true;
 }
 
 void LCD_Clear(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
+    // Every controller clears at once, the cursor ends up top left
+    lcd_selectCtrl(lcd, 0);
+    lcd->data_sel = 1;
     lcd_command(lcd, LCD_CLEARDISPLAY);
-    HAL_Delay(2);
+    // Clearing also sets the controller to left to right: put the entry mode back
+    lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+
+    // The display is blank now, the next flush redraws whatever the framebuffer holds
+    for (int i = 0; i < LCD_MAX_LINES * LCD_MAX_COLS; i++) {
+        lcd->fb_shown[i] = ' ';
+    }
+    lcd->fb_redraw = false;
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_CLEAR));
 }
 
 void LCD_Home(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
+    lcd_selectCtrl(lcd, 0);
+    lcd->data_sel = 1;
     lcd_command(lcd, LCD_RETURNHOME);
-    HAL_Delay(2);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_HOME));
 }
 
 void LCD_SetCursor(LiquidCrystal_C *lcd, uint8_t col, uint8_t row)
 {
-    static const uint8_t row_offsets[4] = {0x00, 0x40, 0x14, 0x54};
+    LCD_INSTR(lcd_instrEnter(lcd));
     if (row >= lcd->numlines) {
         row = lcd->numlines - 1;
     }
-    lcd_command(lcd, LCD_SETDDRAMADDR | (col + row_offsets[row]));
+    lcd_selectCtrl(lcd, lcd_rowCtrl(lcd, row));
+    lcd_command(lcd, LCD_SETDDRAMADDR | (col + lcd_rowOffset(lcd, row)));
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_SETCURSOR));
+}
+
+void LCD_InvalidateState(LiquidCrystal_C *lcd)
+{
+    for (int c = 0; c < LCD_MAX_CONTROLLERS; c++) {
+        LCD_ControllerState *st = &lcd->ctrl[c];
+        st->ac              = 0;
+        st->ac_cgram        = false;
+        st->ac_valid        = false;
+        st->entrymode       = 0;
+        st->entrymode_valid = false;
+        st->control         = 0;
+        st->control_valid   = false;
+        st->shift           = 0;
+        st->shift_valid     = false;
+    }
+}
+
+bool LCD_GetCursor(const LiquidCrystal_C *lcd, uint8_t *col, uint8_t *row)
+{
+    const LCD_ControllerState *st = &lcd->ctrl[lcd->cur_ctrl];
+    if (!st->ac_valid || st->ac_cgram) return false;
+
+    for (uint8_t r = 0; r < lcd->numlines; r++) {
+        uint8_t offset = lcd_rowOffset(lcd, r);
+        if (lcd_rowCtrl(lcd, r) == lcd->cur_ctrl && st->ac >= offset && st->ac < offset + lcd->numcols) {
+            *col = st->ac - offset;
+            *row = r;
+            return true;
+        }
+    }
+    return false;
 }
 
 void LCD_NoDisplay(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaycontrol &= ~LCD_DISPLAYON;
-    lcd_command(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+    lcd_updateControl(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_DISPLAYCONTROL));
 }
 
 void LCD_Display(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaycontrol |= LCD_DISPLAYON;
-    lcd_command(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+    lcd_updateControl(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_DISPLAYCONTROL));
 }
 
 void LCD_NoCursor(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaycontrol &= ~LCD_CURSORON;
-    lcd_command(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+    lcd_updateControl(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_DISPLAYCONTROL));
 }
 
 void LCD_Cursor(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaycontrol |= LCD_CURSORON;
-    lcd_command(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+    lcd_updateControl(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_DISPLAYCONTROL));
 }
 
 void LCD_NoBlink(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaycontrol &= ~LCD_BLINKON;
-    lcd_command(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+    lcd_updateControl(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_DISPLAYCONTROL));
 }
 
 void LCD_Blink(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaycontrol |= LCD_BLINKON;
-    lcd_command(lcd, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+    lcd_updateControl(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_DISPLAYCONTROL));
 }
 
 void LCD_ScrollDisplayLeft(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd_command(lcd, LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVELEFT);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_SCROLL));
 }
 
 void LCD_ScrollDisplayRight(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd_command(lcd, LCD_CURSORSHIFT | LCD_DISPLAYMOVE | LCD_MOVERIGHT);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_SCROLL));
 }
 
 void LCD_LeftToRight(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaymode |= LCD_ENTRYLEFT;
     lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+    lcd_warmSave(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_ENTRYMODE));
 }
 
 void LCD_RightToLeft(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaymode &= ~LCD_ENTRYLEFT;
     lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+    lcd_warmSave(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_ENTRYMODE));
 }
 
 void LCD_Autoscroll(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaymode |= LCD_ENTRYSHIFTINCREMENT;
     lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+    lcd_warmSave(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_ENTRYMODE));
 }
 
 void LCD_NoAutoscroll(LiquidCrystal_C *lcd)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
     lcd->displaymode &= ~LCD_ENTRYSHIFTINCREMENT;
     lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+    lcd_warmSave(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_ENTRYMODE));
 }
 
 void LCD_CreateChar(LiquidCrystal_C *lcd, uint8_t location, const uint8_t charmap[8])
 {
-    location &= 0x7;
-    lcd_command(lcd, LCD_SETCGRAMADDR | (location << 3));
-    for (int i = 0; i < 8; i++) {
-        LCD_WriteChar(lcd, charmap[i]);
+    LCD_INSTR(lcd_instrEnter(lcd));
+    LCD_WriteCGRAM(lcd, location, 0, charmap, 8);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_CREATECHAR));
+}
+
+void LCD_BeginCGRAM(LiquidCrystal_C *lcd)
+{
+    if (lcd->cgram_depth++ != 0) return;
+
+    LCD_BeginBurst(lcd);
+    lcd->cgram_data_sel = lcd->data_sel;
+    lcd->cgram_restore = 0;
+    for (int c = 0; c < lcd->num_ctrl; c++) {
+        lcd->cgram_ddram[c] = lcd->ctrl[c].ac;
+        if (lcd->ctrl[c].ac_valid && !lcd->ctrl[c].ac_cgram) lcd->cgram_restore |= 1 << c;
+    }
+}
+
+void LCD_WriteCGRAM(LiquidCrystal_C *lcd, uint8_t location, uint8_t first_row, const uint8_t *rows, uint8_t count)
+{
+    uint8_t addr = ((location & 0x7) << 3) + (first_row & 0x7);
+
+    if (count > 64 - addr) count = 64 - addr;
+    LCD_BeginCGRAM(lcd);
+    // Every controller has its own CGRAM: upload to all of them at once. The address
+    // is skipped when the last write left the counter there already.
+    lcd_command(lcd, LCD_SETCGRAMADDR | addr);
+    for (uint8_t i = 0; i < count; i++) {
+        LCD_WriteChar(lcd, rows[i]);
+    }
+    LCD_EndCGRAM(lcd);
+}
+
+void LCD_EndCGRAM(LiquidCrystal_C *lcd)
+{
+    if (lcd->cgram_depth == 0 || --lcd->cgram_depth != 0) return;
+
+    // Put the DDRAM addresses back, once for controllers that were at the same one
+    uint8_t restore = lcd->cgram_restore;
+    for (int c = 0; c < lcd->num_ctrl; c++) {
+        if (!(restore & (1 << c))) continue;
+        uint8_t same = 0;
+        for (int o = c; o < lcd->num_ctrl; o++) {
+            if ((restore & (1 << o)) && lcd->cgram_ddram[o] == lcd->cgram_ddram[c]) same |= 1 << o;
+        }
+        lcd_commandTo(lcd, same, LCD_SETDDRAMADDR | lcd->cgram_ddram[c]);
+        restore &= ~same;
     }
+    lcd->data_sel = lcd->cgram_data_sel;
+    LCD_EndBurst(lcd);
 }
 
 void LCD_WriteChar(LiquidCrystal_C *lcd, uint8_t value)
 {
-    lcd_send(lcd, value, true); // mode=true => data
+    LCD_INSTR(lcd_instrEnter(lcd));
+    lcd_send(lcd, lcd->data_sel, value, true); // mode=true => data
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_WRITECHAR));
 }
 
 void LCD_WriteString(LiquidCrystal_C *lcd, const char *str)
 {
+    LCD_INSTR(lcd_instrEnter(lcd));
+    LCD_BeginBurst(lcd);
     while (*str) {
         LCD_WriteChar(lcd, (uint8_t)*str++);
     }
+    LCD_EndBurst(lcd);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_WRITESTRING));
 }
 
 void LCD_SetBacklight(LiquidCrystal_C *lcd, bool on)
 {
-    if (on) {
-        // set bit 7
-        uint8_t current = MCP23008_ReadGPIO(lcd->mcp);
-        current |= (1 << 7);
-        MCP23008_WriteGPIO(lcd->mcp, current);
-    } else {
-        // clear bit 7
-        uint8_t current = MCP23008_ReadGPIO(lcd->mcp);
-        current &= ~(1 << 7);
-        MCP23008_WriteGPIO(lcd->mcp, current);
-    }
+    LCD_INSTR(lcd_instrEnter(lcd));
+    lcd_digitalWrite(lcd, lcd->backlight_pin, on);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_SETBACKLIGHT));
 }
 
-/*******************************************************************************
- * STATIC HELPER IMPLEMENTATIONS
- ******************************************************************************/
-// Send a byte either as a command (mode=false) or data (mode=true)
-static void lcd_send(LiquidCrystal_C *lcd, uint8_t value, bool mode)
+void LCD_SetBacklightPin(LiquidCrystal_C *lcd, uint8_t pin)
 {
-    lcd_digitalWrite(lcd, lcd->rs_pin, mode);
-    if (lcd->rw_pin != 0xFF) {
-        lcd_digitalWrite(lcd, lcd->rw_pin, false);
-    }
-
-    // check if 4-bit or 8-bit
-    if (lcd->displayfunction & LCD_8BITMODE) {
-        lcd_write8bits(lcd, value);
-    } else {
-        lcd_write4bits(lcd, (value >> 4) & 0x0F);
-        lcd_write4bits(lcd, value & 0x0F);
-    }
+    lcd->backlight_pin = pin;
 }
 
-// Writeh te lower 4-bits to D0..D3
-static void lcd_write4bits(LiquidCrystal_C *lcd, uint8_t value)
+#ifndef LCD_FIXED_PINS
+bool LCD_AddController(LiquidCrystal_C *lcd, uint8_t enable_pin)
 {
-    for (int i = 0; i < 4; i++) {
-        bool bitState = (value >> i) & 0x01;
-        lcd_digitalWrite(lcd, lcd->data_pins[i], bitState);
-    }
-    lcd_pulseEnable(lcd);
+    if (lcd->num_ctrl >= LCD_MAX_CONTROLLERS || enable_pin == 0xFF) return false;
+    lcd->enable_pins[lcd->num_ctrl++] = enable_pin;
+    lcd_buildNibbleTables(lcd);
+    return true;
 }
+#endif
 
-// Write the full 8-bits to D0..D7
-static void lcd_write8bits(LiquidCrystal_C *lcd, uint8_t value)
+void LCD_SetTransport(LiquidCrystal_C *lcd, const LCD_Transport *transport)
 {
-    for (int i = 0; i < 8; i++) {
-        bool bitState = (value >> i) & 0x01;
-        lcd_digitalWrite(lcd, lcd->data_pins[i], bitState);
+    lcd_flushBurst(lcd);
+    if (transport != NULL) {
+        lcd->transport = *transport;
+        lcd->burst_i2c = NULL;
+    } else {
+        lcd_useMcp23008(lcd);
+        if (lcd->burst_i2c != NULL) {
+            lcd->transport.caps |= LCD_TRANSPORT_BURST | LCD_TRANSPORT_ASYNC;
+        }
     }
+    if (lcd->transport.value_bytes != 2) {
+        lcd->transport.value_bytes = 1;
+    }
+    // Bursts hold whole values
+    uint16_t max = lcd->transport.max_batch;
+    max = (max == 0 || max > LCD_BURST_BUFSIZE) ? LCD_BURST_BUFSIZE : max;
+    max -= max % lcd->transport.value_bytes;
+    lcd->burst_max = (max != 0) ? max : lcd->transport.value_bytes;
+    lcd->burst_len = 0;
+
+    // New pins: nothing is known about their state, and they may not read back
+    lcd->gpio_shadow_valid = false;
+    lcd->busy_poll = (lcd->rw_pin != 0xFF) && (lcd->transport.caps & LCD_TRANSPORT_READ);
+    lcd_buildNibbleTables(lcd);
+}
+
+void LCD_SyncGPIO(LiquidCrystal_C *lcd)
+{
+    lcd_flushBurst(lcd);
+    if (lcd->async.enabled && !lcd->async.capturing) {
+        LCD_AsyncWaitIdle(lcd);
+    }
+    if (!(lcd->transport.caps & LCD_TRANSPORT_READ)) {
+        // Write-only pins: the shadow is all there is (all low before the first write)
+        if (!lcd->gpio_shadow_valid) {
+            lcd->gpio_shadow = 0;
+            lcd->gpio_shadow_valid = true;
+        }
+        return;
+    }
+    if (!lcd->transport.ops->read(lcd->transport.ctx, &lcd->gpio_shadow)) {
+        lcd_countError(lcd);
+    }
+    lcd->gpio_shadow_valid = true;
+    lcd_countRead(lcd);
+}
+
+void LCD_GetBusStats(const LiquidCrystal_C *lcd, LCD_BusStats *stats)
+{
+    *stats = lcd->stats;
+}
+
+void LCD_ResetBusStats(LiquidCrystal_C *lcd)
+{
+    lcd->stats.reads        = 0;
+    lcd->stats.writes       = 0;
+    lcd->stats.reads_saved  = 0;
+    lcd->stats.writes_saved = 0;
+    lcd->stats.gpio_bytes   = 0;
+    lcd->stats.commands_elided = 0;
+    lcd->stats.errors       = 0;
+}
+
+bool LCD_EnableBurst(LiquidCrystal_C *lcd, I2C_HandleTypeDef *hi2c, uint8_t addr, uint16_t max_bytes)
+{
+    uint8_t iocon;
+
+    if (!lcd_usesMcp23008(lcd)) return false;
+    LCD_DisableBurst(lcd);
+
+    // Keep the other IOCON bits, just stop the address pointer from incrementing
+    if (HAL_I2C_Mem_Read(hi2c, addr << 1, LCD_MCP23008_IOCON, I2C_MEMADD_SIZE_8BIT,
+                         &iocon, 1, LCD_I2C_TIMEOUT) != HAL_OK) {
+        lcd_countError(lcd);
+        return false;
+    }
+    iocon |= LCD_MCP23008_SEQOP;
+    if (HAL_I2C_Mem_Write(hi2c, addr << 1, LCD_MCP23008_IOCON, I2C_MEMADD_SIZE_8BIT,
+                          &iocon, 1, LCD_I2C_TIMEOUT) != HAL_OK) {
+        lcd_countError(lcd);
+        return false;
+    }
+    lcd_countRead(lcd);
+    lcd_countWrite(lcd);
+
+    if (max_bytes == 0 || max_bytes > LCD_BURST_BUFSIZE) {
+        max_bytes = LCD_BURST_BUFSIZE;
+    }
+    lcd->burst_i2c  = hi2c;
+    lcd->burst_addr = addr;
+    lcd->burst_max  = max_bytes;
+    lcd->burst_len  = 0;
+    lcd->transport.caps |= LCD_TRANSPORT_BURST | LCD_TRANSPORT_ASYNC;
+    return true;
+}
+
+void LCD_DisableBurst(LiquidCrystal_C *lcd)
+{
+    lcd_flushBurst(lcd);
+    lcd->transport.caps &= ~LCD_TRANSPORT_BURST;
+    if (lcd_usesMcp23008(lcd)) {
+        // The async engine writes the GPIO register in bursts too
+        lcd->transport.caps &= ~LCD_TRANSPORT_ASYNC;
+        lcd->burst_i2c = NULL;
+    }
+}
+
+void LCD_BeginBurst(LiquidCrystal_C *lcd)
+{
+    lcd->burst_depth++;
+}
+
+void LCD_EndBurst(LiquidCrystal_C *lcd)
+{
+    if (lcd->burst_depth == 0) return;
+    if (--lcd->burst_depth == 0) {
+        lcd_flushBurst(lcd);
+    }
+}
+
+uint16_t LCD_BurstBytesForLatency(uint32_t max_us, uint32_t bus_hz)
+{
+    uint32_t bits = (uint32_t)(((uint64_t)max_us * bus_hz) / 1000000);
+    if (bits <= LCD_I2C_OVERHEAD_BITS + LCD_I2C_BYTE_BITS) {
+        return 1;
+    }
+    bits = (bits - LCD_I2C_OVERHEAD_BITS) / LCD_I2C_BYTE_BITS;
+    return (bits > LCD_BURST_BUFSIZE) ? LCD_BURST_BUFSIZE : (uint16_t)bits;
+}
+
+void LCD_SetTap(LiquidCrystal_C *lcd, LCD_TapFn fn, void *ctx)
+{
+    lcd->tap      = fn;
+    lcd->tap_ctx  = ctx;
+    lcd->tap_sync = true;
+}
+
+void LCD_SetClock(LiquidCrystal_C *lcd, const LCD_Clock *clock)
+{
+    if (clock != NULL) {
+        lcd->clock = *clock;
+    } else {
+        lcd->clock.now_us   = NULL;
+        lcd->clock.delay_us = NULL;
+        lcd->clock.ctx      = NULL;
+    }
+}
+
+#ifdef DWT
+// DWT-backed clock. The cycle counter wraps every few tens of seconds, so now_us
+// accumulates elapsed cycles into a counter that wraps at 2^32 microseconds instead.
+typedef struct {
+    uint32_t last_cycles;
+    uint32_t cycles_left; // cycles not yet converted into a whole microsecond
+    uint32_t us;
+} lcd_dwt_clock;
+
+static lcd_dwt_clock lcd_dwt;
+
+static uint32_t lcd_dwtNowUs(void *ctx)
+{
+    lcd_dwt_clock *c = (lcd_dwt_clock *)ctx;
+    uint32_t per_us = SystemCoreClock / 1000000;
+    uint32_t now = DWT->CYCCNT;
+
+    c->cycles_left += now - c->last_cycles;
+    c->last_cycles = now;
+    c->us += c->cycles_left / per_us;
+    c->cycles_left %= per_us;
+    return c->us;
+}
+
+static void lcd_dwtDelayUs(void *ctx, uint32_t us)
+{
+    (void)ctx;
+    uint32_t start = DWT->CYCCNT;
+    uint32_t cycles = us * (SystemCoreClock / 1000000);
+    while ((DWT->CYCCNT - start) < cycles) {
+    }
+}
+
+void LCD_UseDWTClock(LiquidCrystal_C *lcd)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    lcd_dwt.last_cycles = DWT->CYCCNT;
+    lcd_dwt.cycles_left = 0;
+    lcd_dwt.us          = 0;
+
+    lcd->clock.now_us   = lcd_dwtNowUs;
+    lcd->clock.delay_us = lcd_dwtDelayUs;
+    lcd->clock.ctx      = &lcd_dwt;
+}
+#endif
+
+void LCD_SetBusClock(LiquidCrystal_C *lcd, uint32_t bus_hz)
+{
+    lcd->bus_hz = (bus_hz != 0) ? bus_hz : LCD_DEFAULT_BUS_HZ;
+}
+
+void LCD_SetBusyPolling(LiquidCrystal_C *lcd, bool enable, uint32_t timeout_us)
+{
+    lcd->busy_poll = enable && (lcd->rw_pin != 0xFF) && (lcd->transport.caps & LCD_TRANSPORT_READ);
+    lcd->busy_timeout_us = (timeout_us != 0) ? timeout_us : LCD_BUSY_TIMEOUT_US;
+}
+
+bool LCD_ReadStatus(LiquidCrystal_C *lcd, uint8_t *status)
+{
+    if (lcd->rw_pin == 0xFF || lcd->async.enabled || !(lcd->transport.caps & LCD_TRANSPORT_READ)) return false;
+
+    LCD_INSTR(lcd_instrEnter(lcd));
+    uint16_t saved = lcd_statusBegin(lcd);
+    *status = lcd_statusRead(lcd, LCD_EN_BITS(lcd, 1 << lcd->cur_ctrl));
+    lcd_statusEnd(lcd, saved);
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_READSTATUS));
+    return true;
+}
+
+/*******************************************************************************
+ * FRAMEBUFFER
+ ******************************************************************************/
+void LCD_FbClear(LiquidCrystal_C *lcd)
+{
+    for (int i = 0; i < LCD_MAX_LINES * LCD_MAX_COLS; i++) {
+        lcd->fb[i] = ' ';
+    }
+}
+
+void LCD_FbPutChar(LiquidCrystal_C *lcd, uint8_t col, uint8_t row, uint8_t value)
+{
+    if (col >= lcd->numcols || row >= lcd->numlines) return;
+    lcd->fb[row * LCD_MAX_COLS + col] = value;
+}
+
+void LCD_FbWrite(LiquidCrystal_C *lcd, uint8_t col, uint8_t row, const char *str)
+{
+    if (row >= lcd->numlines) return;
+    uint8_t *cell = &lcd->fb[row * LCD_MAX_COLS];
+    while (*str && col < lcd->numcols) {
+        cell[col++] = (uint8_t)*str++;
+    }
+}
+
+uint8_t LCD_FbGetChar(const LiquidCrystal_C *lcd, uint8_t col, uint8_t row)
+{
+    if (col >= lcd->numcols || row >= lcd->numlines) return ' ';
+    return lcd->fb[row * LCD_MAX_COLS + col];
+}
+
+void LCD_FbInvalidate(LiquidCrystal_C *lcd)
+{
+    lcd->fb_redraw = true;
+}
+
+// Bus cost of one lcd_send() in the middle of a flush, in bits: the GPIO values its latches
+// take (two per latch with the fast latch, else three), each with the write around it unless
+// they go out in a burst. Transports with no bus time (direct GPIO) count values instead.
+// rs_changes: RS differs from the send before, which costs the fast latch a value each time
+// RS isn't on the data byte.
+static uint32_t lcd_sendCost(const LiquidCrystal_C *lcd, bool rs_changes)
+{
+    uint32_t value_cost = lcd->transport.value_bits + (lcd_bursting(lcd) ? 0 : lcd->transport.transfer_bits);
+    uint32_t values = (LCD_EIGHTBIT(lcd) ? 1 : 2) * (lcd->fast_latch ? 2 : 3);
+    uint16_t rs = LCD_NIBBLE(lcd, true, 0) ^ LCD_NIBBLE(lcd, false, 0);
+
+    if (rs_changes && lcd->fast_latch && (rs & 0xFF00)) {
+        values++;
+    }
+    return values * (value_cost ? value_cost : 1);
+}
+
+void LCD_Flush(LiquidCrystal_C *lcd)
+{
+    LCD_INSTR(lcd_instrEnter(lcd));
+    LCD_BusStats before = lcd->stats;
+    LCD_FlushStats fs = {0};
+    int ac = -1;      // DDRAM address the next data byte lands on, -1 = unknown
+    int ac_row = -1;  // row that address belongs to
+    uint8_t mode = lcd->displaymode;
+
+    // Start from where the driver's tracked address counter says the cursor is
+    uint8_t ac_col, ac_r;
+    if (lcd->data_sel == (1 << lcd->cur_ctrl) && LCD_GetCursor(lcd, &ac_col, &ac_r)) {
+        ac = lcd_rowOffset(lcd, ac_r) + ac_col;
+        ac_row = ac_r;
+    }
+
+    // Rows by controller, then in DDRAM address order, so that on a 20x4 display row 0
+    // runs straight on into row 2
+    uint8_t order[LCD_MAX_LINES];
+    uint8_t key[LCD_MAX_LINES];
+    for (int i = 0; i < lcd->numlines; i++) {
+        order[i] = i;
+        key[i] = lcd_rowCtrl(lcd, i) * 0x80 + lcd_rowOffset(lcd, i);
+    }
+    for (int i = 1; i < lcd->numlines; i++) {
+        for (int j = i; j > 0 && key[order[j]] < key[order[j - 1]]; j--) {
+            uint8_t t = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = t;
+        }
+    }
+
+    LCD_BeginBurst(lcd);
+    // A cell is one data byte; a jump is a command between data bytes, so RS changes twice
+    uint32_t cell_cost = lcd_sendCost(lcd, false);
+    uint32_t rs_cost   = lcd_sendCost(lcd, true) - cell_cost;
+    uint32_t jump_cost = cell_cost + 2 * rs_cost;
+    for (int r = 0; r < lcd->numlines; r++) {
+        uint8_t row = order[r];
+        uint8_t *cell = &lcd->fb[row * LCD_MAX_COLS];
+        uint8_t *shown = &lcd->fb_shown[row * LCD_MAX_COLS];
+
+        for (int col = 0; col < lcd->numcols; col++) {
+            if (!lcd->fb_redraw && cell[col] == shown[col]) continue;
+
+            // Auto-increment only works left to right without display shift
+            if (mode != LCD_ENTRYLEFT) {
+                lcd_command(lcd, LCD_ENTRYMODESET | LCD_ENTRYLEFT);
+                mode = LCD_ENTRYLEFT;
+            }
+
+            // Another controller: its address counter is somewhere else
+            if (lcd_rowCtrl(lcd, row) != lcd->cur_ctrl || lcd->data_sel != (1 << lcd->cur_ctrl)) {
+                lcd_selectCtrl(lcd, lcd_rowCtrl(lcd, row));
+                ac = -1;
+            }
+
+            int addr = lcd_rowOffset(lcd, row) + col;
+            if (addr != ac) {
+                // Rewriting the unchanged cells in between costs one data byte each,
+                // a jump costs one command: take whichever sends fewer bytes
+                int gap = addr - ac;
+                if (ac_row == row && gap > 0 && (uint32_t)gap * cell_cost <= jump_cost) {
+                    for (int c = col - gap; c < col; c++) {
+                        LCD_WriteChar(lcd, cell[c]);
+                        shown[c] = cell[c];
+                        fs.cells_written++;
+                    }
+                } else {
+                    lcd_command(lcd, LCD_SETDDRAMADDR | addr);
+                    fs.jumps++;
+                }
+            }
+
+            LCD_WriteChar(lcd, cell[col]);
+            shown[col] = cell[col];
+            fs.cells_changed++;
+            fs.cells_written++;
+            ac = addr + 1;
+            ac_row = row;
+        }
+    }
+    if (mode != lcd->displaymode) {
+        lcd_command(lcd, LCD_ENTRYMODESET | lcd->displaymode);
+    }
+    LCD_EndBurst(lcd);
+    lcd->fb_redraw = false;
+
+    fs.bus_bytes    = lcd->stats.gpio_bytes - before.gpio_bytes;
+    fs.transactions = lcd->stats.writes - before.writes;
+    lcd->flush_stats = fs;
+    LCD_INSTR(lcd_instrLeave(lcd, LCD_API_FLUSH));
+}
+
+void LCD_GetFlushStats(const LiquidCrystal_C *lcd, LCD_FlushStats *stats)
+{
+    *stats = lcd->flush_stats;
+}
+
+/*******************************************************************************
+ * ASYNC ENGINE
+ ******************************************************************************/
+// Microseconds from the handle's clock, or from the HAL tick without one
+static uint32_t lcd_nowUs(LiquidCrystal_C *lcd)
+{
+    if (lcd->clock.now_us != NULL) {
+        return lcd->clock.now_us(lcd->clock.ctx);
+    }
+    return HAL_GetTick() * 1000;
+}
+
+// A wait of us to be timed on lcd_nowUs(). On the HAL tick the start may have been taken
+// just before a tick edge, so one more tick has to pass before the wait is surely over.
+static uint32_t lcd_tickWait(const LiquidCrystal_C *lcd, uint32_t us)
+{
+    return (lcd->clock.now_us != NULL) ? us : us + 1000;
+}
+
+static void lcd_asyncReset(LiquidCrystal_C *lcd)
+{
+    LCD_Async *a = &lcd->async;
+
+    a->capturing  = false;
+    a->implicit   = false;
+    a->stalled    = false;
+    a->depth      = 0;
+    a->cap_tail   = 0;
+    a->run_at     = LCD_ASYNC_NO_RUN;
+    a->head       = 0;
+    a->tail       = 0;
+    a->tx_busy    = false;
+    a->running    = false;
+    a->rerun      = false;
+    a->tx_len     = 0;
+    a->tx_retries = 0;
+    a->waiting    = false;
+    a->wait_start = 0;
+    a->wait_us    = 0;
+    a->errors     = 0;
+}
+
+static void lcd_asyncPut(LCD_Async *a, uint8_t value)
+{
+    a->q[a->cap_tail] = value;
+    a->cap_tail = (a->cap_tail + 1) % LCD_ASYNC_QUEUE_SIZE;
+}
+
+static uint8_t lcd_asyncGet(const LCD_Async *a, uint16_t *index)
+{
+    uint8_t value = a->q[*index];
+    *index = (*index + 1) % LCD_ASYNC_QUEUE_SIZE;
+    return value;
+}
+
+static uint16_t lcd_asyncFree(const LCD_Async *a)
+{
+    uint16_t used = (a->cap_tail + LCD_ASYNC_QUEUE_SIZE - a->head) % LCD_ASYNC_QUEUE_SIZE;
+    return LCD_ASYNC_QUEUE_SIZE - 1 - used;
+}
+
+static bool lcd_asyncTransportTx(void *ctx, const uint8_t *buf, uint16_t len)
+{
+    LiquidCrystal_C *lcd = (LiquidCrystal_C *)ctx;
+
+    return lcd->transport.ops->write_async(lcd->transport.ctx, buf, len, lcd->async.use_dma);
+}
+
+// The state machine: send data runs, wait out delays and run callbacks until it has to
+// wait for a transfer or a delay. Re-entrant calls (from a completion interrupt during
+// a transfer started here) just ask the running instance to go round again.
+static void lcd_asyncRun(LiquidCrystal_C *lcd)
+{
+    LCD_Async *a = &lcd->async;
+
+    if (a->running) {
+        a->rerun = true;
+        return;
+    }
+    do {
+        a->running = true;
+        a->rerun = false;
+        while (!a->tx_busy) {
+            if (a->tx_len > 0) {
+                a->tx_busy = true;
+                if (!a->tx_fn(a->tx_ctx, lcd->burst_buf, a->tx_len)) {
+                    // Bus not available, try again on the next poll
+                    a->tx_busy = false;
+                    a->errors++;
+                    lcd_countError(lcd);
+                    break;
+                }
+                lcd_countWrite(lcd);
+                continue;
+            }
+            if (a->waiting) {
+                if ((uint32_t)(lcd_nowUs(lcd) - a->wait_start) < a->wait_us) break;
+                a->waiting = false;
+            }
+            if (a->head == a->tail) break;
+
+            uint16_t i = a->head;
+            uint8_t tag = lcd_asyncGet(a, &i);
+            if (tag <= LCD_ASYNC_RUN_MAX) {
+                for (uint8_t n = 0; n < tag; n++) {
+                    lcd->burst_buf[n] = lcd_asyncGet(a, &i);
+                }
+                a->tx_len = tag;
+                a->tx_retries = 0;
+                a->head = i;
+            } else if (tag == LCD_ASYNC_TAG_DELAY) {
+                uint32_t us = 0;
+                for (int n = 0; n < 4; n++) {
+                    us |= (uint32_t)lcd_asyncGet(a, &i) << (8 * n);
+                }
+                a->head = i;
+                a->waiting = true;
+                a->wait_start = lcd_nowUs(lcd);
+                a->wait_us = lcd_tickWait(lcd, us);
+                if (a->timer_fn != NULL) {
+                    a->timer_fn(a->timer_ctx, a->wait_us);
+                }
+            } else {
+                LCD_AsyncCallback cb;
+                void *ctx;
+                uint8_t raw[sizeof(cb) + sizeof(ctx)];
+                for (size_t n = 0; n < sizeof(raw); n++) {
+                    raw[n] = lcd_asyncGet(a, &i);
+                }
+                memcpy(&cb, raw, sizeof(cb));
+                memcpy(&ctx, raw + sizeof(cb), sizeof(ctx));
+                a->head = i; // before the callback, which may queue more work
+                cb(lcd, ctx);
+            }
+        }
+        // Let go before looking at rerun: a completion that comes in after the look
+        // then runs the engine itself instead of asking this instance to go round
+        a->running = false;
+    } while (a->rerun);
+}
+
+// Hand everything captured so far to the engine
+static void lcd_asyncPublish(LiquidCrystal_C *lcd)
+{
+    lcd->async.run_at = LCD_ASYNC_NO_RUN;
+    lcd->async.tail = lcd->async.cap_tail;
+    lcd_asyncRun(lcd);
+}
+
+// Let the engine make progress while the caller waits, sleeping through delays if the clock
+// can, a tick at a time without one
+static void lcd_asyncWaitStep(LiquidCrystal_C *lcd)
+{
+    LCD_Async *a = &lcd->async;
+
+    if (a->waiting && !a->tx_busy) {
+        uint32_t elapsed = lcd_nowUs(lcd) - a->wait_start;
+        if (elapsed < a->wait_us && lcd->clock.delay_us != NULL) {
+            lcd->clock.delay_us(lcd->clock.ctx, a->wait_us - elapsed);
+        } else if (elapsed < a->wait_us && lcd->clock.now_us == NULL) {
+            HAL_Delay(1);
+        }
+    }
+    lcd_asyncRun(lcd);
+}
+
+// Make room for n more queue bytes, sending what's captured so far if the queue is full
+static void lcd_asyncReserve(LiquidCrystal_C *lcd, uint16_t n)
+{
+    if (lcd_asyncFree(&lcd->async) >= n) return;
+
+    lcd->async.stalled = true;
+    lcd_asyncPublish(lcd);
+    while (lcd_asyncFree(&lcd->async) < n) {
+        lcd_asyncWaitStep(lcd);
+    }
+}
+
+// Start capturing if nothing is yet. Output that arrives outside LCD_AsyncBegin() comes
+// from a blocking call, which sends it and waits at its end.
+static void lcd_asyncOpen(LiquidCrystal_C *lcd)
+{
+    if (lcd->async.capturing) return;
+    lcd->async.capturing = true;
+    lcd->async.implicit  = true;
+    lcd->async.stalled   = false;
+    lcd->async.run_at    = LCD_ASYNC_NO_RUN;
+}
+
+static void lcd_asyncFinishImplicit(LiquidCrystal_C *lcd)
+{
+    if (!lcd->async.capturing || !lcd->async.implicit) return;
+    lcd->async.capturing = false;
+    lcd->async.implicit  = false;
+    lcd_asyncPublish(lcd);
+    LCD_AsyncWaitIdle(lcd);
+}
+
+// Blocking output outside any burst group is complete as soon as it is queued
+static void lcd_asyncMaybeFinish(LiquidCrystal_C *lcd)
+{
+    if (lcd->async.implicit && lcd->burst_depth == 0) {
+        lcd_asyncFinishImplicit(lcd);
+    }
+}
+
+static void lcd_asyncAppend(LiquidCrystal_C *lcd, uint16_t value)
+{
+    LCD_Async *a = &lcd->async;
+    uint8_t width = lcd->transport.value_bytes;
+    uint8_t run_max = (lcd->burst_max < LCD_ASYNC_RUN_MAX) ? lcd->burst_max : LCD_ASYNC_RUN_MAX;
+
+    run_max -= run_max % width;
+    lcd_asyncOpen(lcd);
+    lcd_asyncReserve(lcd, 1 + width);
+    if (a->run_at == LCD_ASYNC_NO_RUN || a->q[a->run_at] + width > run_max) {
+        a->run_at = a->cap_tail;
+        lcd_asyncPut(a, 0);
+        lcd_busElapsed(lcd, lcd->transport.transfer_bits);
+    }
+    lcd_asyncPut(a, (uint8_t)value);
+    if (width > 1) {
+        lcd_asyncPut(a, (uint8_t)(value >> 8));
+    }
+    a->q[a->run_at] += width;
+    lcd_busElapsed(lcd, lcd->transport.value_bits);
+    lcd_asyncMaybeFinish(lcd);
+}
+
+static void lcd_asyncDelay(LiquidCrystal_C *lcd, uint32_t us)
+{
+    LCD_Async *a = &lcd->async;
+
+    lcd_asyncOpen(lcd);
+    lcd_asyncReserve(lcd, 5);
+    a->run_at = LCD_ASYNC_NO_RUN;
+    lcd_asyncPut(a, LCD_ASYNC_TAG_DELAY);
+    for (int n = 0; n < 4; n++) {
+        lcd_asyncPut(a, (uint8_t)(us >> (8 * n)));
+    }
+    lcd_asyncMaybeFinish(lcd);
+}
+
+static void lcd_asyncDone(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_Async *a = &lcd->async;
+    uint8_t raw[sizeof(cb) + sizeof(ctx)];
+
+    memcpy(raw, &cb, sizeof(cb));
+    memcpy(raw + sizeof(cb), &ctx, sizeof(ctx));
+    lcd_asyncReserve(lcd, 1 + sizeof(raw));
+    a->run_at = LCD_ASYNC_NO_RUN;
+    lcd_asyncPut(a, LCD_ASYNC_TAG_DONE);
+    for (size_t n = 0; n < sizeof(raw); n++) {
+        lcd_asyncPut(a, raw[n]);
+    }
+}
+
+bool LCD_AsyncInit(LiquidCrystal_C *lcd, bool use_dma)
+{
+    if (lcd->async.tx_fn == NULL) {
+        if (!(lcd->transport.caps & LCD_TRANSPORT_ASYNC)) return false;
+        lcd->async.tx_fn  = lcd_asyncTransportTx;
+        lcd->async.tx_ctx = lcd;
+    }
+    lcd_flushBurst(lcd);
+    if (!lcd->gpio_shadow_valid) {
+        LCD_SyncGPIO(lcd);
+    }
+    lcd_asyncReset(lcd);
+    lcd->async.use_dma = use_dma;
+    lcd->async.enabled = true;
+    return true;
+}
+
+void LCD_AsyncStop(LiquidCrystal_C *lcd)
+{
+    if (!lcd->async.enabled) return;
+    LCD_AsyncWaitIdle(lcd);
+    lcd->async.enabled = false;
+}
+
+void LCD_AsyncSetTransport(LiquidCrystal_C *lcd, LCD_AsyncTxFn tx, void *ctx)
+{
+    LCD_AsyncWaitIdle(lcd);
+    lcd->async.tx_fn  = tx;
+    lcd->async.tx_ctx = ctx;
+}
+
+void LCD_AsyncSetTimer(LiquidCrystal_C *lcd, LCD_AsyncTimerFn start, void *ctx)
+{
+    lcd->async.timer_fn  = start;
+    lcd->async.timer_ctx = ctx;
+}
+
+void LCD_AsyncTxComplete(LiquidCrystal_C *lcd)
+{
+    lcd->async.tx_busy    = false;
+    lcd->async.tx_len     = 0;
+    lcd->async.tx_retries = 0;
+    lcd_asyncRun(lcd);
+}
+
+void LCD_AsyncTxError(LiquidCrystal_C *lcd)
+{
+    // Resend the whole run; give up on it after LCD_ASYNC_RETRIES attempts
+    lcd->async.tx_busy = false;
+    lcd->async.errors++;
+    lcd_countError(lcd);
+    if (++lcd->async.tx_retries > LCD_ASYNC_RETRIES) {
+        lcd->async.tx_len     = 0;
+        lcd->async.tx_retries = 0;
+    } else {
+        LCD_INSTR(lcd->instr.retries++);
+    }
+    lcd_asyncRun(lcd);
+}
+
+void LCD_AsyncPoll(LiquidCrystal_C *lcd)
+{
+    if (!lcd->async.enabled) return;
+    lcd_asyncRun(lcd);
+}
+
+bool LCD_IsIdle(const LiquidCrystal_C *lcd)
+{
+    const LCD_Async *a = &lcd->async;
+
+    if (!a->enabled) return true;
+    return a->head == a->tail && !a->tx_busy && a->tx_len == 0 && !a->waiting;
+}
+
+void LCD_AsyncWaitIdle(LiquidCrystal_C *lcd)
+{
+    while (!LCD_IsIdle(lcd)) {
+        lcd_asyncWaitStep(lcd);
+    }
+}
+
+void LCD_AsyncBegin(LiquidCrystal_C *lcd)
+{
+    LCD_Async *a = &lcd->async;
+
+    if (!a->enabled) {
+        // Without the engine the calls simply run, grouped into one burst
+        LCD_BeginBurst(lcd);
+        return;
+    }
+    if (a->depth++ == 0) {
+        lcd_asyncOpen(lcd);
+        a->implicit = false;
+    }
+}
+
+bool LCD_AsyncEnd(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_Async *a = &lcd->async;
+
+    if (!a->enabled) {
+        LCD_EndBurst(lcd);
+        if (cb != NULL) cb(lcd, ctx);
+        return true;
+    }
+    if (cb != NULL) {
+        lcd_asyncDone(lcd, cb, ctx);
+    }
+    if (a->depth == 0 || --a->depth > 0) return true;
+
+    a->capturing = false;
+    lcd_asyncPublish(lcd);
+    return !a->stalled;
+}
+
+bool LCD_ClearAsync(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_Clear(lcd);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+bool LCD_HomeAsync(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_Home(lcd);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+bool LCD_SetCursorAsync(LiquidCrystal_C *lcd, uint8_t col, uint8_t row, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_SetCursor(lcd, col, row);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+bool LCD_WriteCharAsync(LiquidCrystal_C *lcd, uint8_t value, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_WriteChar(lcd, value);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+bool LCD_WriteStringAsync(LiquidCrystal_C *lcd, const char *str, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_WriteString(lcd, str);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+bool LCD_CreateCharAsync(LiquidCrystal_C *lcd, uint8_t location, const uint8_t charmap[8],
+                         LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_CreateChar(lcd, location, charmap);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+bool LCD_SetBacklightAsync(LiquidCrystal_C *lcd, bool on, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_SetBacklight(lcd, on);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+bool LCD_FlushAsync(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx)
+{
+    LCD_AsyncBegin(lcd);
+    LCD_Flush(lcd);
+    return LCD_AsyncEnd(lcd, cb, ctx);
+}
+
+#ifdef LCD_ENABLE_INSTRUMENTATION
+/*******************************************************************************
+ * INSTRUMENTATION
+ ******************************************************************************/
+// Start timing a public call, unless it's running inside another one
+static void lcd_instrEnter(LiquidCrystal_C *lcd)
+{
+    if (lcd->instr.api_depth++ == 0) {
+        lcd->instr.api_start = lcd_nowUs(lcd);
+    }
+}
+
+// Record the latency of the outermost public call in its log2 histogram
+static void lcd_instrLeave(LiquidCrystal_C *lcd, LCD_ApiId id)
+{
+    LCD_Instrumentation *in = &lcd->instr;
+
+    if (in->api_depth == 0 || --in->api_depth > 0) return;
+
+    uint32_t us = lcd_nowUs(lcd) - in->api_start;
+    LCD_ApiLatency *lat = &in->api[id];
+    uint8_t bucket = 0;
+    while (bucket < LCD_INSTR_BUCKETS - 1 && (us >> bucket) != 0) {
+        bucket++;
+    }
+    lat->hist[bucket]++;
+    lat->calls++;
+    lat->total_us += us;
+    if (us > lat->max_us) {
+        lat->max_us = us;
+    }
+}
+
+void LCD_GetInstrumentation(const LiquidCrystal_C *lcd, LCD_Instrumentation *snapshot)
+{
+    *snapshot = lcd->instr;
+}
+
+void LCD_ResetInstrumentation(LiquidCrystal_C *lcd)
+{
+    // Keep the timing of a call in progress (the reset may come from a callback)
+    uint8_t depth = lcd->instr.api_depth;
+    uint32_t start = lcd->instr.api_start;
+
+    memset(&lcd->instr, 0, sizeof(lcd->instr));
+    lcd->instr.api_depth = depth;
+    lcd->instr.api_start = start;
+}
+#endif
+
+/*******************************************************************************
+ * STATIC HELPER IMPLEMENTATIONS
+ ******************************************************************************/
+// Send a byte either as a command (mode=false) or data (mode=true)
+// to the controllers in sel, latched by all of them with one setup
+static void lcd_send(LiquidCrystal_C *lcd, uint8_t sel, uint8_t value, bool mode)
+{
+    LCD_INSTR(if (mode) lcd->instr.data_bytes++; else lcd->instr.commands++);
+    LCD_BeginBurst(lcd);
+    lcd->send_sel = sel;
+    lcd->tap_sync = true;
+    // RS, RW and the data lines are set up together by the nibble tables
+    if (LCD_EIGHTBIT(lcd)) {
+        lcd_write8bits(lcd, value, mode);
+    } else {
+        lcd_write4bits(lcd, (value >> 4) & 0x0F, mode);
+        lcd_write4bits(lcd, value & 0x0F, mode);
+    }
+    // Clear display and return home take much longer than anything else
+    lcd->pending_us = (!mode && value < LCD_ENTRYMODESET) ? LCD_EXEC_HOME_US : LCD_EXEC_US;
+    lcd->busy_sel = sel;
+    for (int c = 0; c < lcd->num_ctrl; c++) {
+        if (sel & (1 << c)) lcd_trackState(lcd, &lcd->ctrl[c], value, mode);
+    }
+    LCD_EndBurst(lcd);
+}
+
+// Step the address counter like the controller does after a data byte or a cursor move
+static void lcd_stepAC(const LiquidCrystal_C *lcd, LCD_ControllerState *st, bool up)
+{
+    if (st->ac_cgram) {
+        st->ac = (st->ac + (up ? 1 : 0x3F)) & 0x3F;
+    } else if (!(lcd->displayfunction & LCD_2LINE)) {
+        // One line: 0x00..0x4F
+        st->ac = up ? (st->ac + 1) % 0x50 : (st->ac + 0x4F) % 0x50;
+    } else if (up) {
+        // Two lines: 0x00..0x27 runs on into 0x40..0x67 and back
+        st->ac = (st->ac == 0x27) ? 0x40 : (st->ac == 0x67) ? 0x00 : st->ac + 1;
+    } else {
+        st->ac = (st->ac == 0x40) ? 0x27 : (st->ac == 0x00) ? 0x67 : st->ac - 1;
+    }
+}
+
+// Move the display shift one position left (or right)
+static void lcd_stepShift(const LiquidCrystal_C *lcd, LCD_ControllerState *st, bool left)
+{
+    uint8_t len = (lcd->displayfunction & LCD_2LINE) ? 40 : 80;
+    st->shift = left ? (st->shift + 1) % len : (st->shift + len - 1) % len;
+}
+
+// Follow the controller state through a command (mode=false) or data byte (mode=true)
+static void lcd_trackState(LiquidCrystal_C *lcd, LCD_ControllerState *st, uint8_t value, bool mode)
+{
+    if (mode) {
+        // Data goes where the address counter points, which then moves by the entry mode
+        if (!st->entrymode_valid) {
+            st->ac_valid = false;
+            st->shift_valid = false;
+            return;
+        }
+        bool up = st->entrymode & LCD_ENTRYLEFT;
+        if (st->ac_valid) lcd_stepAC(lcd, st, up);
+        if (!st->ac_cgram && (st->entrymode & LCD_ENTRYSHIFTINCREMENT) && st->shift_valid) {
+            lcd_stepShift(lcd, st, up);
+        }
+    } else if (value & LCD_SETDDRAMADDR) {
+        st->ac = value & 0x7F;
+        st->ac_cgram = false;
+        st->ac_valid = true;
+    } else if (value & LCD_SETCGRAMADDR) {
+        st->ac = value & 0x3F;
+        st->ac_cgram = true;
+        st->ac_valid = true;
+    } else if (value & LCD_FUNCTIONSET) {
+        // Function set leaves the rest of the state alone
+    } else if (value & LCD_CURSORSHIFT) {
+        if (!(value & LCD_DISPLAYMOVE)) {
+            if (st->ac_valid) lcd_stepAC(lcd, st, value & LCD_MOVERIGHT);
+        } else if (st->shift_valid) {
+            lcd_stepShift(lcd, st, !(value & LCD_MOVERIGHT));
+        }
+    } else if (value & LCD_DISPLAYCONTROL) {
+        st->control = value & 0x07;
+        st->control_valid = true;
+    } else if (value & LCD_ENTRYMODESET) {
+        st->entrymode = value & 0x03;
+        st->entrymode_valid = true;
+    } else {
+        // Clear display also sets the entry mode to increment
+        if (value & LCD_CLEARDISPLAY) {
+            st->entrymode |= LCD_ENTRYLEFT;
+        }
+        st->ac = 0;
+        st->ac_cgram = false;
+        st->ac_valid = true;
+        st->shift = 0;
+        st->shift_valid = true;
+    }
+}
+
+// Send the display control flags. Only the controller holding the cursor shows it;
+// without cursor and blink every controller gets the same command at once.
+static void lcd_updateControl(LiquidCrystal_C *lcd)
+{
+    uint8_t cursor = lcd->displaycontrol & (LCD_CURSORON | LCD_BLINKON);
+    uint8_t all = lcd_allCtrl(lcd);
+    uint8_t here = 1 << lcd->cur_ctrl;
+
+    lcd_warmSave(lcd);
+    if (cursor == 0 || all == here) {
+        lcd_commandTo(lcd, all, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+        return;
+    }
+    lcd_commandTo(lcd, all & ~here, LCD_DISPLAYCONTROL | (lcd->displaycontrol & ~cursor));
+    lcd_commandTo(lcd, here, LCD_DISPLAYCONTROL | lcd->displaycontrol);
+}
+
+// Put a GPIO value on the pins with EN low and latch it into the LCD
+static void lcd_latch(LiquidCrystal_C *lcd, uint16_t value)
+{
+    // Only the data (low byte) changes: it reaches the pins ahead of EN in the same
+    // write, which saves a write per edge (two per byte instead of three)
+    if (lcd->fast_latch && ((lcd_readShadow(lcd) ^ value) & 0xFF00) == 0) {
+        // EN rises with the last byte of the write, after the value's own bus time
+        lcd_busElapsed(lcd, lcd->transport.value_bits);
+        lcd_enableWait(lcd);
+        lcd_writeGPIO(lcd, value | LCD_EN_BITS(lcd, lcd->send_sel));
+        lcd_writeGPIO(lcd, value);
+        return;
+    }
+    lcd_writeGPIO(lcd, value);
     lcd_pulseEnable(lcd);
 }
 
-// Pulse enable pin to latch the data into the LCD
+// Write the lower 4-bits to D0..D3 with a single GPIO write, then latch them
+static void lcd_write4bits(LiquidCrystal_C *lcd, uint8_t value, bool mode)
+{
+    uint16_t current = lcd_readShadow(lcd) & ~LCD_BUS_MASK(lcd);
+    lcd_latch(lcd, current | LCD_NIBBLE(lcd, mode, value & 0x0F));
+}
+
+// Write the full 8-bits to D0..D7 with a single GPIO write, then latch them
+static void lcd_write8bits(LiquidCrystal_C *lcd, uint8_t value, bool mode)
+{
+    uint16_t current = lcd_readShadow(lcd) & ~LCD_BUS_MASK(lcd);
+    lcd_latch(lcd, current | LCD_NIBBLE(lcd, mode, value & 0x0F)
+                           | LCD_NIBBLE_HI(lcd, value >> 4));
+}
+
+// Build the nibble -> GPIO value tables from the pin mapping. In 4-bit mode
+// only data_pins[0..3] are wired, so d4..d7 are ignored. A compile-time pin
+// map has the tables already, only the transport-dependent part is left.
+static void lcd_buildNibbleTables(LiquidCrystal_C *lcd)
+{
+#ifndef LCD_FIXED_PINS
+    bool eightbit = lcd->displayfunction & LCD_8BITMODE;
+    uint16_t rs = (lcd->rs_pin == 0xFF) ? 0 : (1u << lcd->rs_pin);
+
+    lcd->bus_mask = rs;
+    if (lcd->rw_pin != 0xFF) {
+        lcd->bus_mask |= (1u << lcd->rw_pin);
+    }
+    for (int sel = 0; sel < (1 << LCD_MAX_CONTROLLERS); sel++) {
+        lcd->en_bits[sel] = 0;
+        for (int c = 0; c < lcd->num_ctrl; c++) {
+            if ((sel & (1 << c)) && lcd->enable_pins[c] != 0xFF) {
+                lcd->en_bits[sel] |= (1u << lcd->enable_pins[c]);
+            }
+        }
+    }
+    lcd->bus_mask |= lcd->en_bits[lcd_allCtrl(lcd)];
+
+    for (int n = 0; n < 16; n++) {
+        uint16_t lo = 0;
+        uint16_t hi = 0;
+        for (int i = 0; i < 4; i++) {
+            if (((n >> i) & 0x01) && lcd->data_pins[i] != 0xFF) {
+                lo |= (1u << lcd->data_pins[i]);
+            }
+            if (eightbit && ((n >> i) & 0x01) && lcd->data_pins[i + 4] != 0xFF) {
+                hi |= (1u << lcd->data_pins[i + 4]);
+            }
+        }
+        lcd->nibble_lut[0][n] = lo;
+        lcd->nibble_lut[1][n] = lo | rs;
+        lcd->nibble_hi_lut[n] = hi;
+    }
+
+    lcd->data_mask = 0;
+    for (int i = 0; i < (eightbit ? 8 : 4); i++) {
+        if (lcd->data_pins[i] != 0xFF) {
+            lcd->data_mask |= (1u << lcd->data_pins[i]);
+        }
+    }
+    lcd->bus_mask |= lcd->data_mask;
+#endif
+
+    uint16_t en = LCD_EN_BITS(lcd, lcd_allCtrl(lcd));
+    lcd->fast_latch = (lcd->transport.caps & LCD_TRANSPORT_LOW_FIRST) && lcd->transport.value_bytes == 2
+                      && en != 0 && (en & 0x00FF) == 0 && (LCD_DATA_MASK(lcd) & 0xFF00) == 0;
+}
+
+// Modelled bus time of one busy flag poll, including switching the pin directions
+static uint32_t lcd_pollCostUs(const LiquidCrystal_C *lcd)
+{
+    uint32_t write_bits = lcd->transport.transfer_bits + lcd->transport.value_bits;
+    uint32_t cycles = (lcd->displayfunction & LCD_8BITMODE) ? 1 : 2;
+    uint32_t bits = 4 * write_bits + cycles * (2 * write_bits + lcd->transport.read_bits);
+    return (uint32_t)(((uint64_t)bits * 1000000) / lcd->bus_hz);
+}
+
+// Poll the busy flag until it clears. Returns false on timeout. With a clock the
+// timeout is measured; without one it's the modelled bus time of the polls so far.
+static bool lcd_pollBusy(LiquidCrystal_C *lcd)
+{
+    bool timed = (lcd->clock.now_us != NULL);
+    uint32_t start = timed ? lcd_nowUs(lcd) : 0;
+    uint32_t spent = 0;
+    uint32_t cycle_us = lcd_pollCostUs(lcd);
+    bool ready = false;
+
+    // Transports without bus time still need the timeout to run out eventually
+    if (cycle_us == 0) cycle_us = 1;
+    uint16_t saved = lcd_statusBegin(lcd);
+    // Every controller the last instruction went to has to be done with it
+    for (int c = 0; c < lcd->num_ctrl; c++) {
+        if (!(lcd->busy_sel & (1 << c))) continue;
+        ready = false;
+        while (spent < lcd->busy_timeout_us) {
+            if (!(lcd_statusRead(lcd, LCD_EN_BITS(lcd, 1 << c)) & LCD_BUSYFLAG)) {
+                ready = true;
+                break;
+            }
+            spent = timed ? lcd_nowUs(lcd) - start : spent + cycle_us;
+        }
+        if (!ready) break;
+    }
+    lcd_statusEnd(lcd, saved);
+    return ready;
+}
+
+// Wait until the controller can take the next enable pulse
+static void lcd_enableWait(LiquidCrystal_C *lcd)
+{
+#ifdef LCD_ENABLE_INSTRUMENTATION
+    uint32_t start = lcd_nowUs(lcd);
+    lcd_waitReady(lcd);
+    lcd->instr.ready_wait_us += lcd_nowUs(lcd) - start;
+    lcd->instr.enable_pulses++;
+#else
+    lcd_waitReady(lcd);
+#endif
+}
+
+// Pulse enable pin to latch the data into the LCD. The 450 ns pulse width is always
+// covered by the transport (one GPIO write on the bus, or the backend's hold time, on
+// its clock or LCD_SpinUs() without one), so only the previous instruction's execution
+// time is ever waited for.
 static void lcd_pulseEnable(LiquidCrystal_C *lcd)
 {
-    lcd_digitalWrite(lcd, lcd->enable_pin, false);
-    HAL_Delay(1);
-    lcd_digitalWrite(lcd, lcd->enable_pin, true);
-    HAL_Delay(1);
-    lcd_digitalWrite(lcd, lcd->enable_pin, false);
-    HAL_Delay(1);
+    uint16_t en = LCD_EN_BITS(lcd, lcd->send_sel);
+    uint16_t current = lcd_readShadow(lcd) & ~en;
+
+    lcd_writeGPIO(lcd, current);
+    lcd_enableWait(lcd);
+    lcd_writeGPIO(lcd, current | en);
+    lcd_writeGPIO(lcd, current);
+}
+
+// Send the buffered burst as a single transport write (for the MCP23008, one I2C write to GPIO)
+static void lcd_flushBurst(LiquidCrystal_C *lcd)
+{
+    if (lcd->async.enabled) {
+        // The end of a blocking call: queue its output and wait for it
+        lcd_asyncFinishImplicit(lcd);
+        return;
+    }
+    if (lcd->burst_len == 0) return;
+    lcd_transportWrite(lcd, lcd->burst_buf, lcd->burst_len);
+    lcd->burst_len = 0;
+    lcd_busElapsed(lcd, lcd->transport.transfer_bits);
+}
+
+// Spin loops per millisecond, measured the first time a wait needs them
+static uint32_t lcd_spin_per_ms;
+
+static void lcd_spin(uint32_t loops)
+{
+    while (loops-- > 0) {
+        __NOP();
+    }
+}
+
+// Count the loops that fit in one HAL tick. The tick is only read between batches
+// so reading it barely counts, and the result is rounded up by an eighth (interrupts
+// during the count) so waits err on the long side.
+static void lcd_spinCalibrate(void)
+{
+    uint32_t tick = HAL_GetTick();
+    uint32_t loops = 0;
+
+    while (HAL_GetTick() == tick) {
+        lcd_spin(LCD_SPIN_BATCH);
+    }
+    tick = HAL_GetTick();
+    while (HAL_GetTick() == tick) {
+        lcd_spin(LCD_SPIN_BATCH);
+        loops += LCD_SPIN_BATCH;
+    }
+    lcd_spin_per_ms = loops + loops / 8 + 1;
+}
+
+void LCD_SpinUs(uint32_t us)
+{
+    if (lcd_spin_per_ms == 0) {
+        lcd_spinCalibrate();
+    }
+    lcd_spin((uint32_t)(((uint64_t)us * lcd_spin_per_ms + 999) / 1000));
+}
+
+// Wait us microseconds, sending any buffered burst first so the wait happens on the bus
+static void lcd_delayUs(LiquidCrystal_C *lcd, uint32_t us)
+{
+    if (lcd->async.enabled) {
+        // Queued as a delay record, the engine waits it out between transfers
+        lcd_asyncDelay(lcd, us);
+        LCD_INSTR(lcd->instr.delay_us += us);
+        lcd->pending_us = (us >= lcd->pending_us) ? 0 : lcd->pending_us - us;
+        return;
+    }
+    lcd_flushBurst(lcd);
+    LCD_INSTR(lcd->instr.delay_us += us);
+    if (lcd->clock.delay_us != NULL) {
+        lcd->clock.delay_us(lcd->clock.ctx, us);
+    } else if (lcd->clock.now_us != NULL) {
+        uint32_t start = lcd->clock.now_us(lcd->clock.ctx);
+        while ((lcd->clock.now_us(lcd->clock.ctx) - start) < us) {
+        }
+    } else if (us < LCD_SPIN_MAX_US) {
+        LCD_SpinUs(us);
+    } else {
+        HAL_Delay((us + 999) / 1000);
+    }
+    lcd->pending_us = (us >= lcd->pending_us) ? 0 : lcd->pending_us - us;
 }
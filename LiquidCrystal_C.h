@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include "MCP23008.h"  // From https://github.com/m1geo/MCP23008_STM32
 
 /******************************************************************************
@@ -45,17 +46,331 @@
 #define LCD_5x10DOTS 0x04
 #define LCD_5x8DOTS  0x00
 
+// Instruction execution times from the HD44780 datasheet (fosc = 270 kHz), in microseconds
+#define LCD_EXEC_US       37    // most instructions and data writes
+#define LCD_EXEC_HOME_US  1520  // clear display and return home
+#define LCD_POWERUP_US    50000 // more than 40 ms after Vcc rises
+#define LCD_INIT_WAIT1_US 4100  // after the first function set of the init sequence
+#define LCD_INIT_WAIT2_US 100   // after the second function set of the init sequence
+
+// Busy flag polling gives up (and falls back to fixed delays) after this long
+#ifndef LCD_BUSY_TIMEOUT_US
+#define LCD_BUSY_TIMEOUT_US 10000
+#endif
+#define LCD_BUSYFLAG 0x80 // status byte: busy flag, the other bits are the address counter
+
+// I2C clock assumed until LCD_SetBusClock() is called (matches hi2c1 in main.c)
+#define LCD_DEFAULT_BUS_HZ 100000
+// I2C bit times: START + address + register + STOP per transaction, plus 9 per data byte
+#define LCD_I2C_OVERHEAD_BITS 20
+#define LCD_I2C_BYTE_BITS     9
+#define LCD_I2C_READ_BITS     39 // register read: START, address, register, RESTART, address, data, STOP
+
+// MCP23008 pin driving the backlight on the Adafruit backpack (see LCD_SetBacklightPin)
+#define LCD_BACKLIGHT_PIN 7
+
 /******************************************************************************
- * LiquidCrystal_C structure
+ * Compile-time pin map (optional)
+ *
+ * Define LCD_PINMAP_ADAFRUIT, or LCD_FIXED_PINS and the LCD_PIN_* macros, to
+ * build the driver for a single wiring. The nibble tables become constants
+ * in flash and the enable pulse straight-line code, and the handle loses the
+ * tables. LCD_Init() then ignores its pin arguments: call LCD_InitFixed().
  ******************************************************************************/
+#ifdef LCD_PINMAP_ADAFRUIT
+// Adafruit I2C/SPI character LCD backpack (#292): RS=GP1, EN=GP2, D4..D7=GP3..GP6, backlight=GP7
+#define LCD_FIXED_PINS
+#define LCD_PIN_FOURBIT 1
+#define LCD_PIN_RS 1
+#define LCD_PIN_RW 0xFF
+#define LCD_PIN_EN 2
+#define LCD_PIN_D0 3
+#define LCD_PIN_D1 4
+#define LCD_PIN_D2 5
+#define LCD_PIN_D3 6
+#define LCD_PIN_BL 7
+#endif
+
+#ifdef LCD_FIXED_PINS
+// As for LCD_Init(): D0..D3 are the data lines in 4-bit mode, D4..D7 only exist in 8-bit mode
+#ifndef LCD_PIN_RW
+#define LCD_PIN_RW 0xFF
+#endif
+#ifndef LCD_PIN_EN2
+#define LCD_PIN_EN2 0xFF // enable of a second controller, as with LCD_AddController()
+#endif
+#ifndef LCD_PIN_D4
+#define LCD_PIN_D4 0xFF
+#define LCD_PIN_D5 0xFF
+#define LCD_PIN_D6 0xFF
+#define LCD_PIN_D7 0xFF
+#endif
+#ifndef LCD_PIN_BL
+#define LCD_PIN_BL LCD_BACKLIGHT_PIN
+#endif
+#endif
+
+// MCP23008 registers used by the burst transport
+#define LCD_MCP23008_IOCON 0x05
+#define LCD_MCP23008_GPIO  0x09
+#define LCD_MCP23008_SEQOP 0x20 // IOCON bit: address pointer does not increment
+
+// Largest burst buffered in the handle (GPIO bytes per I2C transaction)
+#ifndef LCD_BURST_BUFSIZE
+#define LCD_BURST_BUFSIZE 64
+#endif
+
+// A burst that has to wait less than this many bytes' worth of bus time repeats
+// the last GPIO value instead of being split around a delay
+#ifndef LCD_BURST_PAD_MAX
+#define LCD_BURST_PAD_MAX 4
+#endif
+
+// Framebuffer size (see LCD_Flush). Displays larger than this are only drawn in part.
+#ifndef LCD_MAX_COLS
+#define LCD_MAX_COLS 40
+#endif
+#ifndef LCD_MAX_LINES
+#define LCD_MAX_LINES 4
+#endif
+
+// HD44780 controllers on one handle, each with its own enable line (see LCD_AddController)
+#ifndef LCD_MAX_CONTROLLERS
+#define LCD_MAX_CONTROLLERS 2
+#endif
+
+// Async engine queue (GPIO values, delays and completion callbacks)
+#ifndef LCD_ASYNC_QUEUE_SIZE
+#define LCD_ASYNC_QUEUE_SIZE 256
+#endif
+// Failed transfers are retried this many times before they are dropped
+#ifndef LCD_ASYNC_RETRIES
+#define LCD_ASYNC_RETRIES 3
+#endif
+
+/******************************************************************************
+ * Microsecond clock
+ ******************************************************************************/
+typedef struct {
+    uint32_t (*now_us)(void *ctx);            // free-running microsecond counter, may wrap
+    void (*delay_us)(void *ctx, uint32_t us); // optional, busy-waits on now_us when NULL
+    void *ctx;
+} LCD_Clock;
+
+/******************************************************************************
+ * Bus statistics
+ ******************************************************************************/
+typedef struct {
+    uint32_t reads;        // expander reads actually sent over I2C
+    uint32_t writes;       // expander writes actually sent over I2C
+    uint32_t reads_saved;  // reads answered from the shadow register instead
+    uint32_t writes_saved; // writes skipped because the latch already held the value
+    uint32_t gpio_bytes;   // GPIO values delivered (a burst carries many per write)
+    uint32_t commands_elided; // commands skipped because the controller was already in that state
+    uint32_t errors;       // transport writes and reads that failed, bursts and async transfers included
+} LCD_BusStats;
+
+/******************************************************************************
+ * Transport: how GPIO values get to the pins (see LCD_SetTransport)
+ *
+ * The driver works on GPIO values with one bit per pin number given to
+ * LCD_Init(): 8 pins, or 16 on expanders like the MCP23017. A transport puts
+ * those values on the pins: the built-in one writes the MCP23008,
+ * LCD_Transport.h has more backends. Its capabilities decide which strategies
+ * the driver uses.
+ ******************************************************************************/
+#define LCD_TRANSPORT_BURST 0x01 // several values per write() go out as one transfer: worth collecting
+#define LCD_TRANSPORT_READ  0x02 // read() and set_inputs() work: busy flag, LCD_SyncGPIO
+#define LCD_TRANSPORT_ASYNC 0x04 // write_async() works: the async engine can run on it
+#define LCD_TRANSPORT_LOW_FIRST 0x08 // 16-bit values: the low byte reaches the pins before the high byte
+
 typedef struct {
-    MCP23008_HandleTypeDef *mcp; // Point to the MCP23008 handle
+    // Put the values on the pins one after another, each held for at least the
+    // 450 ns enable pulse width. len is in bytes: values are value_bytes long,
+    // low byte first. Returns false if the transfer failed.
+    bool (*write)(void *ctx, const uint8_t *values, uint16_t len);
+    // Pin levels (LCD_TRANSPORT_READ)
+    bool (*read)(void *ctx, uint16_t *levels);
+    // Turn the pins in mask into inputs and the rest into outputs (LCD_TRANSPORT_READ)
+    bool (*set_inputs)(void *ctx, uint16_t mask);
+    // Start writing and return at once; the completion interrupt calls
+    // LCD_AsyncTxComplete() or LCD_AsyncTxError() (LCD_TRANSPORT_ASYNC)
+    bool (*write_async)(void *ctx, const uint8_t *values, uint16_t len, bool dma);
+} LCD_TransportOps;
 
-    // Pin mappings on the MCP23008
+typedef struct {
+    const LCD_TransportOps *ops;
+    void *ctx;
+    uint8_t caps;          // LCD_TRANSPORT_* flags
+    uint8_t value_bytes;   // bytes per GPIO value: 1 (or 0), or 2 for 16 pins
+    uint16_t max_batch;    // bytes per write() (0 = LCD_BURST_BUFSIZE)
+    // Cost model in bit times at the clock given to LCD_SetBusClock(). All zero for
+    // transports that take no bus time worth counting against execution delays.
+    uint16_t transfer_bits; // per write()
+    uint16_t value_bits;    // per value
+    uint16_t read_bits;     // per read()
+} LCD_Transport;
+
+/******************************************************************************
+ * Framebuffer statistics (last LCD_Flush)
+ ******************************************************************************/
+typedef struct {
+    uint16_t cells_changed; // cells that differed from what the display showed
+    uint16_t cells_written; // changed cells plus unchanged cells rewritten instead of jumping
+    uint16_t jumps;         // LCD_SETDDRAMADDR commands sent
+    uint32_t bus_bytes;     // GPIO bytes sent to the expander
+    uint32_t transactions;  // I2C transactions used
+} LCD_FlushStats;
+
+/******************************************************************************
+ * Async engine state (see LCD_AsyncInit)
+ ******************************************************************************/
+struct LiquidCrystal_C;
+
+// Sees every GPIO value handed to the transport (see LCD_SetTap). sync is true on the
+// first value of a byte (or of a nibble of the init sequence): a decoder can start there.
+typedef void (*LCD_TapFn)(void *ctx, uint16_t value, uint32_t now_us, bool sync);
+
+// Called once an async operation has gone out on the bus
+typedef void (*LCD_AsyncCallback)(struct LiquidCrystal_C *lcd, void *ctx);
+// Start sending len GPIO values; the transport calls LCD_AsyncTxComplete() (or
+// LCD_AsyncTxError()) when done. Returns false if the transfer couldn't be started.
+typedef bool (*LCD_AsyncTxFn)(void *ctx, const uint8_t *buf, uint16_t len);
+// Arrange for LCD_AsyncPoll() to be called in 'us' microseconds
+typedef void (*LCD_AsyncTimerFn)(void *ctx, uint32_t us);
+
+typedef struct {
+    bool enabled;
+    bool use_dma;
+    LCD_AsyncTxFn tx_fn;
+    void *tx_ctx;
+    LCD_AsyncTimerFn timer_fn;
+    void *timer_ctx;
+
+    // Capture: public calls render into the queue instead of the bus
+    bool capturing;
+    bool implicit;        // capture opened by a blocking call, which waits for it to finish
+    bool stalled;         // the capture had to wait for room in the queue
+    uint8_t depth;        // nesting of LCD_AsyncBegin()/LCD_AsyncEnd()
+    uint16_t cap_tail;    // end of the records not yet handed to the engine
+    uint16_t run_at;      // length byte of the data run being appended to
+
+    // Engine
+    volatile uint16_t head;
+    volatile uint16_t tail;
+    volatile bool tx_busy;
+    volatile bool running;
+    volatile bool rerun;
+    uint16_t tx_len;      // GPIO bytes in burst_buf waiting for (re)transmission
+    uint8_t tx_retries;
+    bool waiting;         // an inter-instruction delay is running
+    uint32_t wait_start;
+    uint32_t wait_us;
+    uint32_t errors;
+
+    uint8_t q[LCD_ASYNC_QUEUE_SIZE];
+} LCD_Async;
+
+#ifdef LCD_ENABLE_INSTRUMENTATION
+/******************************************************************************
+ * Instrumentation (build with LCD_ENABLE_INSTRUMENTATION defined)
+ ******************************************************************************/
+// Latency histogram buckets: [0] is under 1 us, [k] is 2^(k-1) .. 2^k - 1 us,
+// the last bucket takes everything longer
+#ifndef LCD_INSTR_BUCKETS
+#define LCD_INSTR_BUCKETS 16
+#endif
+
+// Public calls with their own latency histogram. Calls made from inside another
+// public call (LCD_WriteChar from LCD_WriteString, ...) count towards the outer one.
+typedef enum {
+    LCD_API_BEGIN,
+    LCD_API_CLEAR,
+    LCD_API_HOME,
+    LCD_API_SETCURSOR,
+    LCD_API_DISPLAYCONTROL, // LCD_(No)Display, LCD_(No)Cursor, LCD_(No)Blink
+    LCD_API_SCROLL,         // LCD_ScrollDisplayLeft/Right
+    LCD_API_ENTRYMODE,      // LCD_LeftToRight, LCD_RightToLeft, LCD_(No)Autoscroll
+    LCD_API_CREATECHAR,
+    LCD_API_WRITECHAR,
+    LCD_API_WRITESTRING,
+    LCD_API_SETBACKLIGHT,
+    LCD_API_FLUSH,
+    LCD_API_READSTATUS,
+    LCD_API_COUNT
+} LCD_ApiId;
+
+typedef struct {
+    uint32_t calls;
+    uint32_t total_us;
+    uint32_t max_us;
+    uint32_t hist[LCD_INSTR_BUCKETS];
+} LCD_ApiLatency;
+
+typedef struct {
+    uint32_t commands;        // instruction bytes sent to the controller
+    uint32_t data_bytes;      // data bytes sent to the controller
+    uint32_t pin_writes;      // single pin changes (lcd_digitalWrite)
+    uint32_t enable_pulses;
+    uint32_t expander_reads;  // I2C reads of the expander
+    uint32_t expander_writes; // I2C writes to the expander (a burst is one write)
+    uint32_t delay_us;        // time spent in fixed delays
+    uint32_t ready_wait_us;   // time spent before enable pulses waiting for the controller
+    uint32_t hal_errors;      // HAL calls that did not return HAL_OK
+    uint32_t retries;         // async transfers sent again after an error
+    LCD_ApiLatency api[LCD_API_COUNT];
+
+    // Bookkeeping for the latency of the outermost public call
+    uint8_t api_depth;
+    uint32_t api_start;
+} LCD_Instrumentation;
+#endif
+
+/******************************************************************************
+ * Warm start marker (see LCD_BeginWarm). Keep it in RAM that survives a reset
+ * but not a power cycle, e.g. a .noinit section, and zero it on power-on reset.
+ ******************************************************************************/
+#define LCD_WARM_MAGIC 0x4C434457u // "LCDW"
+
+typedef struct {
+    uint32_t magic;          // LCD_WARM_MAGIC while the rest is valid
+    uint8_t displayfunction; // as last sent by LCD_Begin()
+    uint8_t displaycontrol;  // kept up to date by every display control and entry mode call
+    uint8_t displaymode;
+    uint8_t numcols;
+    uint8_t numlines;
+    uint8_t check;           // guards against RAM that happens to hold the magic
+} LCD_WarmMarker;
+
+/******************************************************************************
+ * Controller state as it was last sent, followed through every byte so that
+ * commands which would change nothing can be skipped (see LCD_InvalidateState)
+ ******************************************************************************/
+typedef struct {
+    uint8_t ac;         // address counter, including auto-increment/decrement
+    bool ac_cgram;      // the last address set was a CGRAM address
+    bool ac_valid;      // false until the first clear, home or address set
+    uint8_t entrymode;  // LCD_ENTRYLEFT/LCD_ENTRYSHIFTINCREMENT flags the controller has
+    bool entrymode_valid;
+    uint8_t control;    // LCD_DISPLAYON/CURSORON/BLINKON flags the controller has
+    bool control_valid;
+    uint8_t shift;      // display shift: positions the display has moved left
+    bool shift_valid;
+} LCD_ControllerState;
+
+/******************************************************************************
+ * LiquidCrystal_C structure
+ ******************************************************************************/
+typedef struct LiquidCrystal_C {
+    MCP23008_HandleTypeDef *mcp; // Point to the MCP23008 handle (built-in transport)
+    LCD_Transport transport;
+
+    // Pin mappings on the MCP23008 (bits of the transport's GPIO values, 0..15 on 16 pins)
     uint8_t rs_pin;
     uint8_t rw_pin; // set to 255 (or 0xFF) if unused (tied to ground)
-    uint8_t enable_pin;
+    uint8_t enable_pins[LCD_MAX_CONTROLLERS]; // E of each controller (E1, E2 on 40x4 modules)
     uint8_t data_pins[8];
+    uint8_t backlight_pin; // 255 if there is no backlight control
 
     // Display state
     uint8_t displayfunction;
@@ -64,13 +379,101 @@ typedef struct {
 
     uint8_t numlines;
     uint8_t currline;
+    uint8_t numcols;
+
+    // Controllers sharing the data, RS and RW lines. Each shows ctrl_lines rows,
+    // the first one rows 0.., the next one the rows after. Sets of controllers are
+    // bitmasks: the RS/data setup goes out once and their EN lines pulse together.
+    uint8_t num_ctrl;
+    uint8_t ctrl_lines;
+    uint8_t cur_ctrl;  // controller holding the cursor
+    uint8_t data_sel;  // controllers data bytes go to: where the last address was set
+    uint8_t send_sel;  // controllers the byte being sent is latched into
+    uint8_t busy_sel;  // controllers executing the last instruction
+    LCD_ControllerState ctrl[LCD_MAX_CONTROLLERS];
+
+#ifndef LCD_FIXED_PINS
+    // GPIO values for every nibble, built by LCD_Init() from data_pins[].
+    // nibble_lut[rs][n] drives D0..D3 (or the 4-bit data lines) and RS,
+    // nibble_hi_lut[n] drives D4..D7 in 8-bit mode. Bits outside bus_mask
+    // (e.g. the backlight) are carried over from the shadow register.
+    // A compile-time pin map has these as constants instead.
+    uint16_t nibble_lut[2][16];
+    uint16_t nibble_hi_lut[16];
+    uint16_t bus_mask;  // data pins, RS, RW and EN
+    uint16_t data_mask; // data pins only
+    uint16_t en_bits[1 << LCD_MAX_CONTROLLERS]; // EN lines of each set of controllers
+#endif
+    // Data pins on the low byte and EN on the high byte of a LCD_TRANSPORT_LOW_FIRST
+    // transport: the data can change in the same write that raises EN
+    bool fast_latch;
+
+    // Cached copy of the output latch. Every pin change is applied here
+    // first, so the expander never has to be read back.
+    uint16_t gpio_shadow;
+    bool gpio_shadow_valid; // false until the first read from the expander
+
+    // Burst transport. With LCD_TRANSPORT_BURST, GPIO values are collected in
+    // burst_buf and handed to the transport in one write (for the MCP23008,
+    // one I2C write to the GPIO register, see LCD_EnableBurst()).
+    I2C_HandleTypeDef *burst_i2c; // MCP23008 burst mode: NULL while off
+    uint8_t burst_addr;           // 7-bit I2C address of the MCP23008
+    uint16_t burst_max;           // cap on bytes per write (whole GPIO values)
+    uint16_t burst_len;
+    uint8_t burst_depth;          // nesting of LCD_BeginBurst()/LCD_EndBurst()
+    uint8_t burst_buf[LCD_BURST_BUFSIZE];
+
+    // Tap on the GPIO values going out (NULL = none), and whether the next one starts a byte
+    LCD_TapFn tap;
+    void *tap_ctx;
+    bool tap_sync;
+
+    // Timing. pending_us is what is left of the last instruction's execution
+    // time; bus traffic counts against it before anything is waited out.
+    LCD_Clock clock;  // all NULL = fall back to HAL_Delay (millisecond resolution)
+    uint32_t bus_hz;
+    uint32_t pending_us;
+
+    // Busy flag polling, only possible when rw_pin is wired
+    bool busy_poll;
+    uint32_t busy_timeout_us;
+    uint16_t iodir; // input pins outside of status reads (0x00 = all outputs, MCP23008 IODIR)
+
+    // Framebuffer: fb is drawn into, fb_shown is what the display holds
+    uint8_t fb[LCD_MAX_LINES * LCD_MAX_COLS];
+    uint8_t fb_shown[LCD_MAX_LINES * LCD_MAX_COLS];
+    bool fb_redraw; // fb_shown can't be trusted, rewrite every cell
+    LCD_FlushStats flush_stats;
+
+    LCD_Async async;
+
+    // Warm start marker kept up to date, NULL for none (see LCD_BeginWarm)
+    LCD_WarmMarker *warm;
+    // Non-blocking LCD_Begin: step of the init sequence (0 = not running) and the
+    // wait that has to be over before the next one (see LCD_BeginStart)
+    uint8_t init_step;
+    uint32_t init_at;
+    uint32_t init_wait;
+
+    // CGRAM writes between LCD_BeginCGRAM() and LCD_EndCGRAM(): the DDRAM addresses
+    // to put back at the end, on the controllers that had a known one
+    uint8_t cgram_depth;
+    uint8_t cgram_restore;
+    uint8_t cgram_ddram[LCD_MAX_CONTROLLERS];
+    uint8_t cgram_data_sel;
+
+    LCD_BusStats stats;
+
+#ifdef LCD_ENABLE_INSTRUMENTATION
+    LCD_Instrumentation instr;
+#endif
 } LiquidCrystal_C;
 
 /*******************************************************************************
  * Public API
  ******************************************************************************/
 // Initialization functions, just splitting the struct/constructor initialization and the hardware initialization.
-// Initialize data structures
+// Initialize data structures. mcp may be NULL if another transport is set before LCD_Begin().
 void LCD_Init(LiquidCrystal_C *lcd,
               MCP23008_HandleTypeDef *mcp,
               uint8_t fourbitmode,
@@ -78,7 +481,27 @@ void LCD_Init(LiquidCrystal_C *lcd,
               uint8_t d0, uint8_t d1, uint8_t d2, uint8_t d3,
               uint8_t d4, uint8_t d5, uint8_t d6, uint8_t d7);
 // Send the actual commands
+#ifdef LCD_FIXED_PINS
+// LCD_Init() with the compile-time pin map
+void LCD_InitFixed(LiquidCrystal_C *lcd, MCP23008_HandleTypeDef *mcp);
+#endif
 bool LCD_Begin(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize);
+// LCD_Begin() after an MCU reset that left the display powered: skips the power-up
+// wait, resyncs the 4-bit interface, restores display control and entry mode and
+// returns the cursor home, without clearing what the display shows (~2 ms instead of
+// ~55 ms). The controller counts as initialized when the marker is valid and matches
+// the geometry, and (RW wired) answers a busy flag read after the resync; without a
+// marker the read alone decides. Otherwise it runs LCD_Begin(). Returns true if it
+// took the warm path. Either way the marker (may be NULL) is kept up to date from then
+// on, and the next LCD_Flush() rewrites every cell.
+bool LCD_BeginWarm(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize, LCD_WarmMarker *marker);
+// Non-blocking LCD_Begin(): LCD_BeginStart() returns at once, LCD_BeginPoll() sends
+// each step of the init sequence once the wait before it is over (50 ms power-up,
+// then 4.1 ms) and returns true when the display is ready. Uses the handle's clock,
+// or the HAL tick without one, when each wait lasts a tick longer than it would.
+// Don't call anything else on the display meanwhile.
+void LCD_BeginStart(LiquidCrystal_C *lcd, uint8_t cols, uint8_t lines, uint8_t dotsize);
+bool LCD_BeginPoll(LiquidCrystal_C *lcd);
 
 // Basic display commands
 // Clear LCD and return cursor to (0,0)
@@ -116,8 +539,27 @@ void LCD_Autoscroll(LiquidCrystal_C *lcd);
 // Disable autoscroll
 void LCD_NoAutoscroll(LiquidCrystal_C *lcd);
 
-// Create custom char in locations 0..7
+// Controller state tracking. The driver follows the address counter, entry mode,
+// display control and display shift through every byte it sends and skips commands
+// that would change nothing. Call LCD_InvalidateState() if the controller may have
+// been reset or written behind the driver's back (also LCD_FbInvalidate() if its
+// contents may have changed).
+void LCD_InvalidateState(LiquidCrystal_C *lcd);
+// Cursor position the next character goes to. False while it isn't known or the
+// address counter points into CGRAM or off screen.
+bool LCD_GetCursor(const LiquidCrystal_C *lcd, uint8_t *col, uint8_t *row);
+
+// Create custom char in locations 0..7. The DDRAM address (cursor) is restored afterwards
+// when the driver knows it, so writing can carry on where it left off.
 void LCD_CreateChar(LiquidCrystal_C *lcd, uint8_t location, const uint8_t charmap[8]);
+// Rewrite count rows of slot location from first_row on (running on into the next
+// slots), e.g. only the rows that changed. The address command is skipped when the
+// previous write left the address counter there.
+void LCD_WriteCGRAM(LiquidCrystal_C *lcd, uint8_t location, uint8_t first_row, const uint8_t *rows, uint8_t count);
+// Group CGRAM writes (calls may nest): the cursor is put back once, at the end, and
+// everything goes out in as few bursts as possible
+void LCD_BeginCGRAM(LiquidCrystal_C *lcd);
+void LCD_EndCGRAM(LiquidCrystal_C *lcd);
 
 // Write a single character (mimicking Adafruit's write(uint8_t)).
 void LCD_WriteChar(LiquidCrystal_C *lcd, uint8_t value);
@@ -126,5 +568,126 @@ void LCD_WriteString(LiquidCrystal_C *lcd, const char *str);
 
 // Toggle the backlight of the LCD (if it's supported)
 void LCD_SetBacklight(LiquidCrystal_C *lcd, bool on);
+// Pin driving the backlight (LCD_BACKLIGHT_PIN by default, 255 for none)
+void LCD_SetBacklightPin(LiquidCrystal_C *lcd, uint8_t pin);
+#ifndef LCD_FIXED_PINS
+// Another HD44780 on the same data, RS and RW lines with its own enable: E2 of a 40x4
+// module, or a second display on the expander. Call before LCD_Begin(), which gives
+// each controller an equal share of the lines (a 40x4 is two 40x2 halves). Returns
+// false if LCD_MAX_CONTROLLERS are in use.
+bool LCD_AddController(LiquidCrystal_C *lcd, uint8_t enable_pin);
+#endif
+
+// Transport
+// Put GPIO values on the pins through another backend (see LCD_Transport.h), or back
+// through the MCP23008 given to LCD_Init() with NULL. Call before LCD_Begin(), with the
+// async engine stopped. The transport is copied; its ctx must stay valid.
+void LCD_SetTransport(LiquidCrystal_C *lcd, const LCD_Transport *transport);
+
+// Shadow register control
+// Re-read the MCP23008 GPIO register into the shadow (call this if something else writes to the expander).
+// Transports that can't read keep the shadow as it is.
+void LCD_SyncGPIO(LiquidCrystal_C *lcd);
+// Copy the bus transaction counters
+void LCD_GetBusStats(const LiquidCrystal_C *lcd, LCD_BusStats *stats);
+// Zero the bus transaction counters
+void LCD_ResetBusStats(LiquidCrystal_C *lcd);
+
+// Burst transport
+// Stream GPIO values to the MCP23008 in one I2C write per burst. Sets IOCON.SEQOP so every
+// byte lands in the GPIO register. max_bytes caps the burst length (0 = LCD_BURST_BUFSIZE).
+bool LCD_EnableBurst(LiquidCrystal_C *lcd, I2C_HandleTypeDef *hi2c, uint8_t addr, uint16_t max_bytes);
+// Go back to one write per GPIO change (also for the transport set with LCD_SetTransport)
+void LCD_DisableBurst(LiquidCrystal_C *lcd);
+// Group every call between these two into as few bursts as possible (calls may nest)
+void LCD_BeginBurst(LiquidCrystal_C *lcd);
+void LCD_EndBurst(LiquidCrystal_C *lcd);
+// Largest burst that fits in max_us on a bus running at bus_hz
+uint16_t LCD_BurstBytesForLatency(uint32_t max_us, uint32_t bus_hz);
+
+// Tap
+// Call fn with every GPIO value as it's handed to the transport, burst or async queue,
+// timestamped with the handle's clock (NULL to remove it). See LCD_Trace.h.
+void LCD_SetTap(LiquidCrystal_C *lcd, LCD_TapFn fn, void *ctx);
+
+// Timing
+// Use a microsecond clock for delays (NULL to go back to HAL_Delay, and a spin loop
+// calibrated against the HAL tick for waits under 2 ms)
+void LCD_SetClock(LiquidCrystal_C *lcd, const LCD_Clock *clock);
+// Busy-wait on that spin loop, for code without a clock (e.g. a transport's hold time).
+// The first call calibrates it, which takes 1-2 ms.
+void LCD_SpinUs(uint32_t us);
+#ifdef DWT
+// Use the Cortex-M DWT cycle counter as the clock (cores with a DWT: Cortex-M3/M4/M7)
+void LCD_UseDWTClock(LiquidCrystal_C *lcd);
+#endif
+// Tell the driver the I2C clock so bus time can be counted against execution delays
+void LCD_SetBusClock(LiquidCrystal_C *lcd, uint32_t bus_hz);
+
+// Framebuffer
+// Draw into the off-screen buffer; nothing is sent until LCD_Flush()
+void LCD_FbClear(LiquidCrystal_C *lcd);
+void LCD_FbPutChar(LiquidCrystal_C *lcd, uint8_t col, uint8_t row, uint8_t value);
+// Write a string starting at (col, row), clipped at the end of the row
+void LCD_FbWrite(LiquidCrystal_C *lcd, uint8_t col, uint8_t row, const char *str);
+uint8_t LCD_FbGetChar(const LiquidCrystal_C *lcd, uint8_t col, uint8_t row);
+// Forget what the display shows (e.g. after writing to it directly) so the next flush redraws everything
+void LCD_FbInvalidate(LiquidCrystal_C *lcd);
+// Send only the cells that changed since the last flush
+void LCD_Flush(LiquidCrystal_C *lcd);
+// Statistics of the last flush
+void LCD_GetFlushStats(const LiquidCrystal_C *lcd, LCD_FlushStats *stats);
+
+// Async engine
+// Queue LCD operations and send them from I2C interrupt (or DMA) completions. Needs
+// LCD_EnableBurst() first, or a transport with LCD_TRANSPORT_ASYNC. Call LCD_AsyncTxComplete() from HAL_I2C_MemTxCpltCallback,
+// LCD_AsyncTxError() from HAL_I2C_ErrorCallback and LCD_AsyncPoll() from a timer or the
+// main loop. While the engine is on, the blocking functions queue their work and wait for it.
+// Without a clock (LCD_SetClock) delays are timed on the HAL tick and last one tick longer than asked.
+bool LCD_AsyncInit(LiquidCrystal_C *lcd, bool use_dma);
+// Wait for the queue to drain and go back to blocking transfers
+void LCD_AsyncStop(LiquidCrystal_C *lcd);
+// Replace the HAL transfer with another transport (e.g. a stand-in for host tests)
+void LCD_AsyncSetTransport(LiquidCrystal_C *lcd, LCD_AsyncTxFn tx, void *ctx);
+// Optional one-shot timer used to end inter-instruction delays without polling
+void LCD_AsyncSetTimer(LiquidCrystal_C *lcd, LCD_AsyncTimerFn start, void *ctx);
+void LCD_AsyncTxComplete(LiquidCrystal_C *lcd);
+void LCD_AsyncTxError(LiquidCrystal_C *lcd);
+void LCD_AsyncPoll(LiquidCrystal_C *lcd);
+// True once everything queued has been sent and its delays have elapsed
+bool LCD_IsIdle(const LiquidCrystal_C *lcd);
+void LCD_AsyncWaitIdle(LiquidCrystal_C *lcd);
+// Queue any sequence of calls as one operation. LCD_AsyncEnd() returns false if the
+// queue was too small and the caller had to wait for room.
+void LCD_AsyncBegin(LiquidCrystal_C *lcd);
+bool LCD_AsyncEnd(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx);
+// Async variants of the common calls; cb (may be NULL) runs once the operation is sent
+bool LCD_ClearAsync(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx);
+bool LCD_HomeAsync(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx);
+bool LCD_SetCursorAsync(LiquidCrystal_C *lcd, uint8_t col, uint8_t row, LCD_AsyncCallback cb, void *ctx);
+bool LCD_WriteCharAsync(LiquidCrystal_C *lcd, uint8_t value, LCD_AsyncCallback cb, void *ctx);
+bool LCD_WriteStringAsync(LiquidCrystal_C *lcd, const char *str, LCD_AsyncCallback cb, void *ctx);
+bool LCD_CreateCharAsync(LiquidCrystal_C *lcd, uint8_t location, const uint8_t charmap[8],
+                         LCD_AsyncCallback cb, void *ctx);
+bool LCD_SetBacklightAsync(LiquidCrystal_C *lcd, bool on, LCD_AsyncCallback cb, void *ctx);
+bool LCD_FlushAsync(LiquidCrystal_C *lcd, LCD_AsyncCallback cb, void *ctx);
+
+// Busy flag (needs rw_pin wired and a transport that can read)
+// Poll the busy flag instead of waiting out long execution times. On by default when
+// rw_pin is wired; switches itself off if the flag doesn't clear within timeout_us (measured
+// on the handle's clock, or the modelled bus time of the polls without one).
+// Not used while the async engine is running.
+void LCD_SetBusyPolling(LiquidCrystal_C *lcd, bool enable, uint32_t timeout_us);
+// Read the busy flag and address counter (LCD_BUSYFLAG | AC). False if RW isn't wired
+// or the async engine is running.
+bool LCD_ReadStatus(LiquidCrystal_C *lcd, uint8_t *status);
+
+#ifdef LCD_ENABLE_INSTRUMENTATION
+// Instrumentation. Latencies use the handle's clock (LCD_SetClock), or the 1 ms HAL
+// tick without one. Take snapshots from thread context: counters updated by an
+// async completion interrupt during the copy may be torn.
+void LCD_GetInstrumentation(const LiquidCrystal_C *lcd, LCD_Instrumentation *snapshot);
+void LCD_ResetInstrumentation(LiquidCrystal_C *lcd);
+#endif
 
 #endif
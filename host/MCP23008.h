@@ -0,0 +1,23 @@
+#ifndef MCP23008_H
+#define MCP23008_H
+
+// Host stand-in for the MCP23008 driver. Register accesses go through the
+// HAL_I2C_Mem_* functions of the simulated bus (sim.c).
+#include <stdint.h>
+#include "stm32f4xx_hal.h"
+
+#define MCP23008_IODIR 0x00
+#define MCP23008_GPIO  0x09
+#define MCP23008_OLAT  0x0A
+
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t addr;
+} MCP23008_HandleTypeDef;
+
+void MCP23008_Init(I2C_HandleTypeDef *hi2c, MCP23008_HandleTypeDef *hmcp, uint8_t addr);
+void MCP23008_SetDirection(MCP23008_HandleTypeDef *hmcp, uint8_t direction);
+uint8_t MCP23008_ReadGPIO(MCP23008_HandleTypeDef *hmcp);
+void MCP23008_WriteGPIO(MCP23008_HandleTypeDef *hmcp, uint8_t value);
+
+#endif
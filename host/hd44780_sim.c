@@ -0,0 +1,279 @@
+#include "hd44780_sim.h"
+#include <string.h>
+
+static const char *hd44780_violation_names[HD44780_VIOL_COUNT] = {
+    "power-up", "busy", "enable pulse width", "RS/RW setup", "data setup", "data hold"
+};
+
+static void hd44780_flag(hd44780_sim *lcd, hd44780_violation kind, uint64_t now_ns, uint64_t got_ns)
+{
+    lcd->violations[kind]++;
+    if (lcd->logged < HD44780_MAX_LOGGED) {
+        snprintf(lcd->log[lcd->logged++], sizeof(lcd->log[0]), "t=%llu.%03llu us: %s (%llu ns)",
+                 (unsigned long long)(now_ns / 1000), (unsigned long long)(now_ns % 1000),
+                 hd44780_violation_names[kind], (unsigned long long)got_ns);
+    }
+}
+
+void hd44780_sim_init(hd44780_sim *lcd, bool four_bit_wiring)
+{
+    memset(lcd, 0, sizeof(*lcd));
+    lcd->four_bit_wiring = four_bit_wiring;
+    lcd->dl8 = true;
+    lcd->increment = true;
+    memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+}
+
+// Advance (or step back) the address counter after a data access
+static void hd44780_stepAC(hd44780_sim *lcd, bool up)
+{
+    if (lcd->ac_cgram) {
+        lcd->ac = (lcd->ac + (up ? 1 : 0x3F)) & 0x3F;
+        return;
+    }
+    if (!lcd->two_line) {
+        lcd->ac = up ? (lcd->ac + 1) % 80 : (lcd->ac + 79) % 80;
+        return;
+    }
+    // Two lines: 0x00..0x27 and 0x40..0x67
+    if (up) {
+        if (lcd->ac == 0x27) lcd->ac = 0x40;
+        else if (lcd->ac == 0x67) lcd->ac = 0x00;
+        else lcd->ac++;
+    } else {
+        if (lcd->ac == 0x40) lcd->ac = 0x27;
+        else if (lcd->ac == 0x00) lcd->ac = 0x67;
+        else lcd->ac--;
+    }
+}
+
+static void hd44780_shiftDisplay(hd44780_sim *lcd, bool left)
+{
+    int len = lcd->two_line ? 40 : 80;
+    lcd->offset = left ? (lcd->offset + 1) % len : (lcd->offset + len - 1) % len;
+}
+
+static void hd44780_execute(hd44780_sim *lcd, uint64_t now_ns, bool rs, uint8_t value)
+{
+    uint64_t exec = HD44780_T_EXEC;
+
+    if (now_ns < HD44780_T_POWERUP) {
+        hd44780_flag(lcd, HD44780_VIOL_POWERUP, now_ns, now_ns);
+    }
+    lcd->last_rs = rs;
+    lcd->last_value = value;
+
+    if (rs) {
+        lcd->data_writes++;
+        if (lcd->ac_cgram) {
+            lcd->cgram[lcd->ac & 0x3F] = value & 0x1F;
+        } else {
+            lcd->ddram[lcd->ac & 0x7F] = value;
+        }
+        hd44780_stepAC(lcd, lcd->increment);
+        if (lcd->shift && !lcd->ac_cgram) {
+            hd44780_shiftDisplay(lcd, lcd->increment);
+        }
+    } else {
+        lcd->instructions++;
+        if (value & 0x80) {
+            lcd->ac = value & 0x7F;
+            lcd->ac_cgram = false;
+        } else if (value & 0x40) {
+            lcd->ac = value & 0x3F;
+            lcd->ac_cgram = true;
+        } else if (value & 0x20) {
+            lcd->dl8 = value & 0x10;
+            lcd->two_line = value & 0x08;
+            lcd->font5x10 = value & 0x04;
+            // Until the interface has been set up three times, allow for the
+            // init-by-instruction waits of the datasheet
+            if (lcd->function_sets == 0) exec = HD44780_T_INIT1;
+            else if (lcd->function_sets == 1) exec = HD44780_T_INIT2;
+            if (lcd->function_sets < 3) lcd->function_sets++;
+        } else if (value & 0x10) {
+            bool right = value & 0x04;
+            if (value & 0x08) {
+                hd44780_shiftDisplay(lcd, !right);
+            } else {
+                hd44780_stepAC(lcd, right);
+            }
+        } else if (value & 0x08) {
+            lcd->display_on = value & 0x04;
+            lcd->cursor_on  = value & 0x02;
+            lcd->blink_on   = value & 0x01;
+        } else if (value & 0x04) {
+            lcd->increment = value & 0x02;
+            lcd->shift     = value & 0x01;
+        } else if (value & 0x02) {
+            lcd->ac = 0;
+            lcd->ac_cgram = false;
+            lcd->offset = 0;
+            exec = HD44780_T_EXEC_HOME;
+        } else if (value & 0x01) {
+            memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+            lcd->ac = 0;
+            lcd->ac_cgram = false;
+            lcd->offset = 0;
+            lcd->increment = true;
+            exec = HD44780_T_EXEC_HOME;
+        }
+    }
+    lcd->busy_until_ns = now_ns + exec;
+}
+
+// Enable falling edge of a write: latch a byte or a nibble
+static void hd44780_latch(hd44780_sim *lcd, uint64_t now_ns)
+{
+    if (now_ns < lcd->busy_until_ns) {
+        hd44780_flag(lcd, HD44780_VIOL_BUSY, now_ns, lcd->busy_until_ns - now_ns);
+    }
+    if (now_ns - lcd->data_changed_ns < HD44780_T_DSW) {
+        hd44780_flag(lcd, HD44780_VIOL_SETUP_DSW, now_ns, now_ns - lcd->data_changed_ns);
+    }
+
+    if (lcd->dl8) {
+        // On a 4-bit wiring D3..D0 float low: fine for the function sets of the init sequence
+        uint8_t value = lcd->four_bit_wiring ? (lcd->data & 0xF0) : lcd->data;
+        lcd->half = false;
+        hd44780_execute(lcd, now_ns, lcd->rs, value);
+        return;
+    }
+    if (!lcd->half) {
+        lcd->nibble = lcd->data & 0xF0;
+        lcd->half = true;
+        return;
+    }
+    lcd->half = false;
+    hd44780_execute(lcd, now_ns, lcd->rs, lcd->nibble | (lcd->data >> 4));
+}
+
+// Enable rising edge of a read: put the next byte (or nibble) on the bus
+static void hd44780_startRead(hd44780_sim *lcd, uint64_t now_ns)
+{
+    if (lcd->dl8 || !lcd->read_half) {
+        if (lcd->rs) {
+            lcd->read_value = lcd->ac_cgram ? lcd->cgram[lcd->ac & 0x3F] : lcd->ddram[lcd->ac & 0x7F];
+        } else {
+            lcd->read_value = lcd->ac | ((now_ns < lcd->busy_until_ns) ? 0x80 : 0x00);
+        }
+    }
+}
+
+// Enable falling edge of a read
+static void hd44780_endRead(hd44780_sim *lcd)
+{
+    if (!lcd->dl8 && !lcd->read_half) {
+        lcd->read_half = true;
+        return;
+    }
+    lcd->read_half = false;
+    lcd->reads++;
+    if (lcd->rs) {
+        hd44780_stepAC(lcd, lcd->increment);
+    }
+}
+
+void hd44780_sim_lines(hd44780_sim *lcd, uint64_t now_ns, bool rs, bool rw, bool e, uint8_t data)
+{
+    if (lcd->four_bit_wiring) {
+        data &= 0xF0;
+    }
+    if (data != lcd->data) {
+        // Data changing on (or just after) the falling edge that latches it
+        if (!rw && !lcd->rw && now_ns - lcd->e_fall_ns < HD44780_T_H && lcd->e_fall_ns != 0) {
+            hd44780_flag(lcd, HD44780_VIOL_HOLD, now_ns, now_ns - lcd->e_fall_ns);
+        }
+        lcd->data = data;
+        lcd->data_changed_ns = now_ns;
+    }
+    if (rs != lcd->rs || rw != lcd->rw) {
+        lcd->rs = rs;
+        lcd->rw = rw;
+        lcd->ctrl_changed_ns = now_ns;
+    }
+
+    if (e && !lcd->e) {
+        if (now_ns - lcd->ctrl_changed_ns < HD44780_T_AS) {
+            hd44780_flag(lcd, HD44780_VIOL_SETUP_AS, now_ns, now_ns - lcd->ctrl_changed_ns);
+        }
+        lcd->e = true;
+        lcd->e_rise_ns = now_ns;
+        if (rw) {
+            hd44780_startRead(lcd, now_ns);
+        }
+    } else if (!e && lcd->e) {
+        if (now_ns - lcd->e_rise_ns < HD44780_T_PWEH) {
+            hd44780_flag(lcd, HD44780_VIOL_PWEH, now_ns, now_ns - lcd->e_rise_ns);
+        }
+        lcd->e = false;
+        lcd->e_fall_ns = now_ns;
+        if (rw) {
+            hd44780_endRead(lcd);
+        } else {
+            hd44780_latch(lcd, now_ns);
+        }
+    }
+}
+
+uint8_t hd44780_sim_output(const hd44780_sim *lcd, uint64_t now_ns)
+{
+    (void)now_ns;
+    if (!lcd->rw || !lcd->e) return 0;
+    if (lcd->dl8) return lcd->read_value;
+    return lcd->read_half ? (uint8_t)(lcd->read_value << 4) : (lcd->read_value & 0xF0);
+}
+
+uint8_t hd44780_sim_visible(const hd44780_sim *lcd, int col, int row, int cols)
+{
+    if (!lcd->two_line) {
+        return lcd->ddram[(row * cols + col + lcd->offset) % 80];
+    }
+    // Rows 2 and 3 of a 4-line module continue lines 1 and 2
+    int line  = row % 2;
+    int start = (row / 2) * cols;
+    return lcd->ddram[line * 0x40 + (start + col + lcd->offset) % 40];
+}
+
+void hd44780_sim_dump(const hd44780_sim *lcd, FILE *out, int cols, int rows)
+{
+    fputc('+', out);
+    for (int c = 0; c < cols; c++) fputc('-', out);
+    fputs("+\n", out);
+    for (int r = 0; r < rows; r++) {
+        fputc('|', out);
+        for (int c = 0; c < cols; c++) {
+            uint8_t ch = lcd->display_on ? hd44780_sim_visible(lcd, c, r, cols) : ' ';
+            if (ch < 0x10) fputc('#', out);
+            else if (ch < 0x20 || ch > 0x7E) fputc('?', out);
+            else fputc(ch, out);
+        }
+        fputs("|\n", out);
+    }
+    fputc('+', out);
+    for (int c = 0; c < cols; c++) fputc('-', out);
+    fputs("+\n", out);
+}
+
+uint32_t hd44780_sim_violation_count(const hd44780_sim *lcd)
+{
+    uint32_t total = 0;
+    for (int i = 0; i < HD44780_VIOL_COUNT; i++) {
+        total += lcd->violations[i];
+    }
+    return total;
+}
+
+void hd44780_sim_report(const hd44780_sim *lcd, FILE *out)
+{
+    fprintf(out, "instructions %u, data writes %u, reads %u, timing violations %u\n",
+            lcd->instructions, lcd->data_writes, lcd->reads, hd44780_sim_violation_count(lcd));
+    for (int i = 0; i < HD44780_VIOL_COUNT; i++) {
+        if (lcd->violations[i]) {
+            fprintf(out, "  %-18s %u\n", hd44780_violation_names[i], lcd->violations[i]);
+        }
+    }
+    for (int i = 0; i < lcd->logged; i++) {
+        fprintf(out, "  %s\n", lcd->log[i]);
+    }
+}
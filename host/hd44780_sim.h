@@ -0,0 +1,97 @@
+#ifndef HD44780_SIM_H
+#define HD44780_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/******************************************************************************
+ * HD44780 controller model
+ *
+ * Fed with the interface lines every time one of them changes, decodes enable
+ * falling edges into 4-bit or 8-bit transfers and keeps DDRAM, CGRAM, the
+ * address counter, display shift and entry mode like the real controller.
+ * Timing is checked against the datasheet minimums (fosc = 270 kHz).
+ ******************************************************************************/
+// Datasheet timing, in nanoseconds
+#define HD44780_T_POWERUP  40000000ULL // Vcc rise to first instruction
+#define HD44780_T_EXEC     37000ULL    // most instructions
+#define HD44780_T_EXEC_HOME 1520000ULL // clear display, return home
+#define HD44780_T_INIT1    4100000ULL  // first function set after power-up
+#define HD44780_T_INIT2    100000ULL   // second function set after power-up
+#define HD44780_T_PWEH     450ULL      // enable pulse width (high)
+#define HD44780_T_AS       40ULL       // RS/RW setup before enable rises
+#define HD44780_T_DSW      80ULL       // data setup before enable falls
+#define HD44780_T_H        10ULL       // data hold after enable falls
+
+#define HD44780_MAX_LOGGED 8 // violations kept with their description
+
+typedef enum {
+    HD44780_VIOL_POWERUP,   // instruction before the supply had settled
+    HD44780_VIOL_BUSY,      // transfer while the previous instruction was executing
+    HD44780_VIOL_PWEH,      // enable pulse too short
+    HD44780_VIOL_SETUP_AS,  // RS/RW changed too close to the enable rising edge
+    HD44780_VIOL_SETUP_DSW, // data changed too close to the enable falling edge
+    HD44780_VIOL_HOLD,      // data changed too soon after the enable falling edge
+    HD44780_VIOL_COUNT
+} hd44780_violation;
+
+typedef struct {
+    // Wiring: 4-bit modules only have D4..D7 connected
+    bool four_bit_wiring;
+
+    // Interface lines as last seen, and when they last changed
+    bool rs, rw, e;
+    uint8_t data; // D7..D0 as driven by the MCU (D3..D0 ignored on a 4-bit wiring)
+    uint64_t e_rise_ns;
+    uint64_t e_fall_ns;
+    uint64_t ctrl_changed_ns;
+    uint64_t data_changed_ns;
+
+    // Controller state
+    bool dl8;            // 8-bit interface
+    bool two_line;
+    bool font5x10;
+    bool display_on, cursor_on, blink_on;
+    bool increment;      // I/D
+    bool shift;          // S: shift the display on every data write
+    bool ac_cgram;       // the address counter points into CGRAM
+    uint8_t ac;
+    uint8_t offset;      // display shift, 0..39 (0..79 in 1-line mode)
+    bool half;           // 4-bit mode: the first nibble of a write has been latched
+    uint8_t nibble;
+    bool read_half;      // 4-bit mode: the first nibble of a read has been output
+    uint8_t read_value;  // byte being read out
+    uint8_t ddram[128];
+    uint8_t cgram[64];
+    uint64_t busy_until_ns;
+    int function_sets;   // counted until the init-by-instruction waits are over
+
+    // Last transfer executed
+    bool last_rs;
+    uint8_t last_value;
+
+    // Statistics
+    uint32_t instructions;
+    uint32_t data_writes;
+    uint32_t reads;
+    uint32_t violations[HD44780_VIOL_COUNT];
+    char log[HD44780_MAX_LOGGED][96];
+    int logged;
+} hd44780_sim;
+
+// Power-on reset state (8-bit interface, display off)
+void hd44780_sim_init(hd44780_sim *lcd, bool four_bit_wiring);
+// Drive the interface lines at time now_ns. data holds D7..D0.
+void hd44780_sim_lines(hd44780_sim *lcd, uint64_t now_ns, bool rs, bool rw, bool e, uint8_t data);
+// D7..D0 as driven by the controller while RW and E are high
+uint8_t hd44780_sim_output(const hd44780_sim *lcd, uint64_t now_ns);
+// Character at the visible position (col, row) of a cols x rows module
+uint8_t hd44780_sim_visible(const hd44780_sim *lcd, int col, int row, int cols);
+// Print the visible screen as text. CGRAM characters are shown as '#', codes
+// outside printable ASCII as '?'.
+void hd44780_sim_dump(const hd44780_sim *lcd, FILE *out, int cols, int rows);
+uint32_t hd44780_sim_violation_count(const hd44780_sim *lcd);
+void hd44780_sim_report(const hd44780_sim *lcd, FILE *out);
+
+#endif
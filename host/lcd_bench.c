@@ -0,0 +1,557 @@
+// Measures what each driver call and a few typical screen updates cost on the
+// simulated bus: I2C transactions, bytes on the wire, time spent waiting and
+// the modelled wall time, at 100 kHz, 400 kHz and 1 MHz, over the MCP23008
+// with and without the burst transport, over a PCF8574 backpack and over an
+// MCP23017 driving the LCD in 8-bit mode (against the 4-bit MCP23008 rows).
+//
+//   lcd_bench [-json] [-b HZ]...
+//
+//   -json    print a JSON array instead of CSV
+//   -b HZ    bus clock to run at; may be repeated (default 100000, 400000, 1000000)
+//
+// The driver gets the simulator's microsecond clock, as it would with
+// LCD_UseDWTClock() on the target. Every case starts from a freshly initialized
+// display (plus its own unmeasured preparation) so the results do not depend on
+// the order they run in. A case that trips the controller's timing checks makes
+// the exit code 1.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LiquidCrystal_C.h"
+#include "LCD_Anim.h"
+#include "LCD_Glyph.h"
+#include "LCD_Governor.h"
+#include "LCD_Graph.h"
+#include "LCD_Ring.h"
+#include "LCD_Transport.h"
+#include "LCD_Ui.h"
+#include "sim.h"
+
+#define BENCH_MAX_RATES 8
+
+// How the display is attached
+typedef enum {
+    BENCH_DIRECT,   // MCP23008, one I2C write per GPIO change
+    BENCH_BURST,    // MCP23008 with LCD_EnableBurst()
+    BENCH_PCF8574,  // PCF8574 backpack, RW tied low like the Adafruit wiring
+    BENCH_MCP23017_DIRECT, // MCP23017 in 8-bit mode, one I2C write per GPIO value
+    BENCH_MCP23017, // MCP23017 in 8-bit mode, batched
+    BENCH_TRANSPORTS
+} bench_transport;
+
+static const char *bench_transport_names[BENCH_TRANSPORTS] = {
+    "direct", "burst", "pcf8574", "mcp23017_direct", "mcp23017"
+};
+
+typedef struct {
+    const char *name;
+    uint8_t cols;
+    uint8_t rows;
+    bool measure_begin;                     // the measured part includes LCD_Begin()
+    void (*prepare)(LiquidCrystal_C *lcd);  // optional, not measured
+    void (*run)(LiquidCrystal_C *lcd);
+} bench_case;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint64_t bus_ns;
+    uint64_t delay_ns;
+    uint64_t wall_ns;
+    uint32_t violations;
+} bench_result;
+
+static I2C_HandleTypeDef hi2c1;
+static MCP23008_HandleTypeDef hmcp;
+static LCD_PCF8574 pcf;
+static LCD_MCP23017 mcp23017;
+static LiquidCrystal_C lcd;
+static hd44780_sim display;
+
+static const uint8_t bench_glyph[8] = { 0x00, 0x0A, 0x1F, 0x1F, 0x0E, 0x04, 0x00, 0x00 };
+static const char bench_marquee[] = "    Scrolling marquee text over a 16x2 display    ";
+static uint32_t bench_count;
+static LCD_GlyphCache bench_glyphs;
+static uint8_t bench_icons[16][8];
+static LCD_Ring bench_ring;
+static LCD_Governor bench_governor;
+static LCD_Animator bench_anim;
+static LCD_Graph bench_graph;
+static LCD_Bar bench_bar;
+static LCD_BigNum bench_big;
+static LCD_Ui bench_ui;
+static int bench_menu;
+static uint8_t bench_sel; // menu selection of the rewrite case
+static const char *const bench_menu_items[8] = {
+    "Temperature", "Humidity", "Pressure", "Backlight", "Contrast", "Units", "Network", "About"
+};
+static const uint8_t bench_spinner[4][8] = {
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x00, 0x00 },
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00 },
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00 },
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00 },
+};
+
+/******************************************************************************
+ * Cases
+ ******************************************************************************/
+static void bench_nothing(LiquidCrystal_C *lcd) { (void)lcd; }
+static void bench_clear(LiquidCrystal_C *lcd) { LCD_Clear(lcd); }
+// LCD_Begin() leaves the cursor home, where LCD_Home() would be skipped
+static void bench_cursorAway(LiquidCrystal_C *lcd) { LCD_SetCursor(lcd, 5, 1); }
+static void bench_home(LiquidCrystal_C *lcd) { LCD_Home(lcd); }
+static void bench_setCursor(LiquidCrystal_C *lcd) { LCD_SetCursor(lcd, 5, 1); }
+static void bench_setCursorHere(LiquidCrystal_C *lcd) { LCD_SetCursor(lcd, 0, 0); }
+static void bench_cursorOff(LiquidCrystal_C *lcd) { LCD_NoCursor(lcd); }
+static void bench_writeChar(LiquidCrystal_C *lcd) { LCD_WriteChar(lcd, 'A'); }
+static void bench_writeString(LiquidCrystal_C *lcd) { LCD_WriteString(lcd, "Hello world 1234"); }
+static void bench_createChar(LiquidCrystal_C *lcd) { LCD_CreateChar(lcd, 0, bench_glyph); }
+static void bench_backlight(LiquidCrystal_C *lcd) { LCD_SetBacklight(lcd, false); }
+
+static void bench_redraw(LiquidCrystal_C *lcd, uint8_t cols, uint8_t rows)
+{
+    static const char *text[4] = {
+        "Temp   23.5 C  Fan 3", "Humidity   41 %  OK ", "Uptime 12:34:56 ....", "Menu   Setup   Exit "
+    };
+    char line[LCD_MAX_COLS + 1];
+    for (uint8_t row = 0; row < rows; row++) {
+        memcpy(line, text[row], cols);
+        line[cols] = '\0';
+        LCD_SetCursor(lcd, 0, row);
+        LCD_WriteString(lcd, line);
+    }
+}
+
+static void bench_redraw16x2(LiquidCrystal_C *lcd) { bench_redraw(lcd, 16, 2); }
+static void bench_redraw20x4(LiquidCrystal_C *lcd) { bench_redraw(lcd, 20, 4); }
+
+static void bench_fbShowRedraw(LiquidCrystal_C *lcd)
+{
+    for (uint8_t row = 0; row < 2; row++) {
+        LCD_FbWrite(lcd, 0, row, "----------------");
+    }
+    LCD_Flush(lcd);
+}
+
+static void bench_fbRedraw16x2(LiquidCrystal_C *lcd)
+{
+    LCD_FbWrite(lcd, 0, 0, "Temp   23.5 C  F");
+    LCD_FbWrite(lcd, 0, 1, "Humidity   41 % ");
+    LCD_Flush(lcd);
+}
+
+static void bench_counterPrepare(LiquidCrystal_C *lcd)
+{
+    bench_count = 0;
+    LCD_SetCursor(lcd, 0, 0);
+    LCD_WriteString(lcd, "Count:        0");
+    LCD_FbWrite(lcd, 0, 0, "Count:        0");
+    LCD_Flush(lcd);
+}
+
+static void bench_counter(LiquidCrystal_C *lcd)
+{
+    bench_count++;
+    LCD_SetCursor(lcd, 14, 0);
+    LCD_WriteChar(lcd, '0' + bench_count % 10);
+}
+
+static void bench_fbCounter(LiquidCrystal_C *lcd)
+{
+    bench_count++;
+    LCD_FbPutChar(lcd, 14, 0, '0' + bench_count % 10);
+    LCD_Flush(lcd);
+}
+
+static void bench_marqueePrepare(LiquidCrystal_C *lcd)
+{
+    LCD_SetCursor(lcd, 0, 0);
+    LCD_WriteString(lcd, "Scrolling marquee text over the display");
+    LCD_FbWrite(lcd, 0, 0, bench_marquee);
+    LCD_Flush(lcd);
+}
+
+// One full pass of 16 steps using the controller's display shift
+static void bench_marqueeShift(LiquidCrystal_C *lcd)
+{
+    for (int step = 0; step < 16; step++) {
+        LCD_ScrollDisplayLeft(lcd);
+    }
+}
+
+// One full pass of 16 steps redrawing the line through the framebuffer
+static void bench_marqueeFb(LiquidCrystal_C *lcd)
+{
+    for (int step = 1; step <= 16; step++) {
+        LCD_FbWrite(lcd, 0, 0, bench_marquee + step);
+        LCD_Flush(lcd);
+    }
+}
+
+// A row of 6 icons out of 16, redrawn through the glyph cache
+static void bench_drawIcons(LiquidCrystal_C *lcd, int first)
+{
+    for (int i = 0; i < 6; i++) {
+        LCD_GlyphPut(&bench_glyphs, i, 1, bench_icons[(first + i) % 16], '?');
+    }
+    LCD_Flush(lcd);
+}
+
+static void bench_iconsPrepare(LiquidCrystal_C *lcd)
+{
+    for (int i = 0; i < 16; i++) {
+        for (int r = 0; r < 8; r++) {
+            bench_icons[i][r] = (uint8_t)((i * 7 + r * 3) & 0x1F);
+        }
+    }
+    LCD_GlyphInit(&bench_glyphs, lcd);
+    bench_drawIcons(lcd, 0);
+}
+
+// Same icons again: everything is a cache hit
+static void bench_iconsSteady(LiquidCrystal_C *lcd) { bench_drawIcons(lcd, 0); }
+// Next page of icons: six misses
+static void bench_iconsSwap(LiquidCrystal_C *lcd) { bench_drawIcons(lcd, 6); }
+
+// A producer posting 50 readings of a 5-digit value between two drains
+static void bench_ringPost(LiquidCrystal_C *lcd, LCD_RingPolicy policy)
+{
+    char text[6];
+
+    LCD_RingInit(&bench_ring, lcd, policy);
+    for (int i = 0; i < 50; i++) {
+        snprintf(text, sizeof(text), "%5d", 12000 + i * 7);
+        LCD_RingWrite(&bench_ring, 9, 0, text);
+    }
+}
+
+static void bench_ringQueued(LiquidCrystal_C *lcd) { bench_ringPost(lcd, LCD_RING_DROP_OLDEST); }
+static void bench_ringLatest(LiquidCrystal_C *lcd) { bench_ringPost(lcd, LCD_RING_LATEST_WINS); }
+static void bench_ringDrain(LiquidCrystal_C *lcd) { (void)lcd; LCD_RingDrain(&bench_ring, 0); }
+
+// A sensor reading updated every millisecond for 200 ms, written as it arrives.
+// The producer runs late whenever a write takes longer than a millisecond.
+static void bench_sensor(LiquidCrystal_C *lcd, bool governed)
+{
+    LCD_Clock clock = { sim_clock_now_us, sim_clock_delay_us, NULL };
+    uint64_t start = sim_now_ns();
+    char text[6];
+
+    if (governed) {
+        LCD_GovernorInit(&bench_governor, lcd, 20, &clock);
+    }
+    for (int i = 0; i < 200; i++) {
+        uint64_t due = start + (uint64_t)i * 1000000;
+        if (sim_now_ns() < due) sim_advance_ns(due - sim_now_ns());
+        snprintf(text, sizeof(text), "%5d", 12000 + i * 7);
+        if (governed) {
+            LCD_GovernorWrite(&bench_governor, 9, 0, text);
+            LCD_GovernorPoll(&bench_governor);
+        } else {
+            LCD_SetCursor(lcd, 9, 0);
+            LCD_WriteString(lcd, text);
+        }
+    }
+    if (governed) {
+        LCD_GovernorFlush(&bench_governor);
+    }
+}
+
+static void bench_sensorDirect(LiquidCrystal_C *lcd) { bench_sensor(lcd, false); }
+static void bench_sensorGoverned(LiquidCrystal_C *lcd) { bench_sensor(lcd, true); }
+
+// Eight spinners on screen, 8 frames at 8 Hz: each frame rewrites every spinner's cell
+// with the next of four preloaded glyphs, or one animated glyph that all cells show
+static void bench_spinnerPrepare(LiquidCrystal_C *lcd)
+{
+    LCD_Clock clock = { sim_clock_now_us, sim_clock_delay_us, NULL };
+
+    for (uint8_t i = 0; i < 4; i++) {
+        LCD_CreateChar(lcd, i, bench_spinner[i]);
+    }
+    LCD_AnimInit(&bench_anim, lcd, &clock);
+    LCD_AnimAdd(&bench_anim, 4, bench_spinner, 4, 8);
+    for (uint8_t i = 0; i < 8; i++) {
+        LCD_SetCursor(lcd, (i / 2) * 4 + 1, i & 1);
+        LCD_WriteChar(lcd, 4);
+    }
+}
+
+static void bench_spinnerRun(LiquidCrystal_C *lcd, bool animated)
+{
+    uint64_t start = sim_now_ns();
+
+    for (int frame = 1; frame <= 8; frame++) {
+        uint64_t due = start + (uint64_t)frame * 125000000;
+        if (sim_now_ns() < due) sim_advance_ns(due - sim_now_ns());
+        if (animated) {
+            LCD_AnimTick(&bench_anim);
+            continue;
+        }
+        for (uint8_t i = 0; i < 8; i++) {
+            LCD_SetCursor(lcd, (i / 2) * 4 + 1, i & 1);
+            LCD_WriteChar(lcd, frame % 4);
+        }
+    }
+}
+
+static void bench_spinnerCells(LiquidCrystal_C *lcd) { bench_spinnerRun(lcd, false); }
+static void bench_spinnerCgram(LiquidCrystal_C *lcd) { bench_spinnerRun(lcd, true); }
+
+// A level bar moving up one step at a time, ten times: through the bar renderer, which
+// only redraws the end of the bar, or by writing the whole bar out each time
+static void bench_barPrepare(LiquidCrystal_C *lcd, uint8_t len)
+{
+    LCD_GraphInit(&bench_graph, lcd, 0);
+    LCD_BarInit(&bench_bar, &bench_graph, 0, 1, len, false, len * 5);
+    LCD_BarSet(&bench_bar, len * 2);
+}
+
+static void bench_bar4Prepare(LiquidCrystal_C *lcd) { bench_barPrepare(lcd, 4); }
+static void bench_bar16Prepare(LiquidCrystal_C *lcd) { bench_barPrepare(lcd, 16); }
+
+static void bench_barStep(LiquidCrystal_C *lcd)
+{
+    (void)lcd;
+    for (uint16_t i = 1; i <= 10; i++) {
+        LCD_BarSet(&bench_bar, bench_bar.len * 2 + i);
+    }
+}
+
+static void bench_barRewrite(LiquidCrystal_C *lcd)
+{
+    for (uint16_t i = 1; i <= 10; i++) {
+        uint16_t fill = bench_bar.len * 2 + i;
+        LCD_SetCursor(lcd, 0, 1);
+        for (uint8_t c = 0; c < bench_bar.len; c++) {
+            int lit = fill - c * 5;
+            LCD_WriteChar(lcd, (lit >= 5) ? 0xFF : (lit <= 0) ? ' ' : lit - 1);
+        }
+    }
+}
+
+// A four-digit counter in 3x2 digits counting from 1234 to 1243
+static void bench_bigPrepare(LiquidCrystal_C *lcd)
+{
+    LCD_GraphInit(&bench_graph, lcd, 0);
+    LCD_BigInit(&bench_big, &bench_graph, 0, 0, 4, LCD_GRAPH_DIGITS_3X2);
+    LCD_BigNumber(&bench_big, 1233);
+}
+
+static void bench_bigCount(LiquidCrystal_C *lcd)
+{
+    (void)lcd;
+    for (int32_t i = 1234; i <= 1243; i++) {
+        LCD_BigNumber(&bench_big, i);
+    }
+}
+
+// Menu navigation on a 20x4: ten moves through 8 items shown 4 at a time (down 7,
+// scrolling 4 times, then up 3), through the widget layer or rewriting all 4 rows
+static const int8_t bench_menu_moves[10] = { 1, 1, 1, 1, 1, 1, 1, -1, -1, -1 };
+
+static void bench_menuPrepare(LiquidCrystal_C *lcd)
+{
+    LCD_UiInit(&bench_ui, lcd, NULL);
+    bench_menu = LCD_UiMenu(&bench_ui, 0, 0, 20, 4, bench_menu_items, 8);
+    LCD_UiCommit(&bench_ui);
+    bench_sel = 0;
+}
+
+static void bench_menuMove(LiquidCrystal_C *lcd)
+{
+    (void)lcd;
+    for (int i = 0; i < 10; i++) {
+        LCD_UiMenuMove(&bench_ui, bench_menu, bench_menu_moves[i]);
+        LCD_UiCommit(&bench_ui);
+    }
+}
+
+static void bench_menuRewrite(LiquidCrystal_C *lcd)
+{
+    uint8_t top = 0;
+
+    for (int i = 0; i < 10; i++) {
+        bench_sel += bench_menu_moves[i];
+        if (bench_sel < top) top = bench_sel;
+        if (bench_sel >= top + 4) top = bench_sel - 3;
+        for (uint8_t r = 0; r < 4; r++) {
+            char line[21];
+            snprintf(line, sizeof(line), "%c%-19s", (top + r == bench_sel) ? LCD_UI_MARKER : ' ',
+                     bench_menu_items[top + r]);
+            LCD_SetCursor(lcd, 0, r);
+            LCD_WriteString(lcd, line);
+        }
+    }
+}
+
+static const bench_case bench_cases[] = {
+    { "LCD_Begin",              16, 2, true,  NULL,                 bench_nothing },
+    { "LCD_Clear",              16, 2, false, NULL,                 bench_clear },
+    { "LCD_Home",               16, 2, false, bench_cursorAway,     bench_home },
+    { "LCD_SetCursor",          16, 2, false, NULL,                 bench_setCursor },
+    { "LCD_SetCursor_same",     16, 2, false, NULL,                 bench_setCursorHere },
+    { "LCD_NoCursor_same",      16, 2, false, NULL,                 bench_cursorOff },
+    { "LCD_WriteChar",          16, 2, false, NULL,                 bench_writeChar },
+    { "LCD_WriteString_16",     16, 2, false, NULL,                 bench_writeString },
+    { "LCD_CreateChar",         16, 2, false, NULL,                 bench_createChar },
+    { "LCD_SetBacklight",       16, 2, false, NULL,                 bench_backlight },
+    { "redraw_16x2",            16, 2, false, NULL,                 bench_redraw16x2 },
+    { "redraw_20x4",            20, 4, false, NULL,                 bench_redraw20x4 },
+    { "redraw_16x2_fb",         16, 2, false, bench_fbShowRedraw,   bench_fbRedraw16x2 },
+    { "counter_digit",          16, 2, false, bench_counterPrepare, bench_counter },
+    { "counter_digit_fb",       16, 2, false, bench_counterPrepare, bench_fbCounter },
+    { "marquee_shift_16",       16, 2, false, bench_marqueePrepare, bench_marqueeShift },
+    { "marquee_fb_16",          16, 2, false, bench_marqueePrepare, bench_marqueeFb },
+    { "icons_6_steady",         16, 2, false, bench_iconsPrepare,   bench_iconsSteady },
+    { "icons_6_swap",           16, 2, false, bench_iconsPrepare,   bench_iconsSwap },
+    { "ring_50_posts_queued",   16, 2, false, bench_ringQueued,     bench_ringDrain },
+    { "ring_50_posts_latest",   16, 2, false, bench_ringLatest,     bench_ringDrain },
+    { "sensor_1khz_direct",     16, 2, false, NULL,                 bench_sensorDirect },
+    { "sensor_1khz_20hz",       16, 2, false, NULL,                 bench_sensorGoverned },
+    { "spinner_8x_cells",       16, 2, false, bench_spinnerPrepare, bench_spinnerCells },
+    { "spinner_8x_cgram",       16, 2, false, bench_spinnerPrepare, bench_spinnerCgram },
+    { "bar_4_10_steps",         16, 2, false, bench_bar4Prepare,    bench_barStep },
+    { "bar_16_10_steps",        16, 2, false, bench_bar16Prepare,   bench_barStep },
+    { "bar_16_10_rewrites",     16, 2, false, bench_bar16Prepare,   bench_barRewrite },
+    { "bigdigits_3x2_10_counts", 16, 2, false, bench_bigPrepare,    bench_bigCount },
+    { "menu_20x4_10_moves",     20, 4, false, bench_menuPrepare,    bench_menuMove },
+    { "menu_20x4_10_rewrites",  20, 4, false, bench_menuPrepare,    bench_menuRewrite },
+};
+
+/******************************************************************************
+ * Runner
+ ******************************************************************************/
+static void bench_setup(const bench_case *bc, uint32_t bus_hz, bench_transport transport, bool begin)
+{
+    sim_reset();
+    hi2c1.Init.ClockSpeed = bus_hz;
+    bool eightbit = (transport == BENCH_MCP23017 || transport == BENCH_MCP23017_DIRECT);
+    hd44780_sim_init(&display, !eightbit);
+
+    if (eightbit) {
+        sim_wiring wiring = sim_wiring_mcp23017;
+        wiring.rw = SIM_NC;
+        sim_attach_mcp23017(&hi2c1, 0x20, &wiring, &display);
+        LCD_Transport t;
+        LCD_Init(&lcd, NULL, 0, 8, 255, 10, 0, 1, 2, 3, 4, 5, 6, 7);
+        LCD_SetBacklightPin(&lcd, 11);
+        LCD_TransportMCP23017(&t, &mcp23017, &hi2c1, 0x20);
+        if (transport == BENCH_MCP23017_DIRECT) {
+            t.caps &= ~LCD_TRANSPORT_BURST;
+        }
+        LCD_SetTransport(&lcd, &t);
+    } else if (transport == BENCH_PCF8574) {
+        sim_wiring wiring = sim_wiring_pcf8574;
+        wiring.rw = SIM_NC;
+        sim_attach_pcf8574(&hi2c1, 0x27, &wiring, &display);
+        LCD_Transport t;
+        LCD_Init(&lcd, NULL, 1, 0, 255, 2, 4, 5, 6, 7, 0, 0, 0, 0);
+        LCD_SetBacklightPin(&lcd, 3);
+        LCD_TransportPCF8574(&t, &pcf, &hi2c1, 0x27);
+        LCD_SetTransport(&lcd, &t);
+    } else {
+        sim_attach_mcp23008(&hi2c1, 0x20, &sim_wiring_adafruit, &display);
+        MCP23008_Init(&hi2c1, &hmcp, 0x20);
+        MCP23008_SetDirection(&hmcp, 0x00);
+        LCD_Init(&lcd, &hmcp,
+                 1,
+                 1, 255, 2,
+                 3, 4, 5, 6,
+                 0, 0, 0, 0);
+    }
+    LCD_SetBusClock(&lcd, bus_hz);
+    LCD_Clock clock = { sim_clock_now_us, sim_clock_delay_us, NULL };
+    LCD_SetClock(&lcd, &clock);
+    if (transport == BENCH_BURST) {
+        LCD_EnableBurst(&lcd, &hi2c1, 0x20, LCD_BURST_BUFSIZE);
+    }
+    // Let the supply settle so the measured part does not include the power-up wait
+    sim_advance_ns(HD44780_T_POWERUP);
+    if (begin) {
+        LCD_Begin(&lcd, bc->cols, bc->rows, LCD_5x8DOTS);
+        LCD_SetBacklight(&lcd, true);
+        if (bc->prepare) {
+            bc->prepare(&lcd);
+        }
+    }
+}
+
+static void bench_measure(const bench_case *bc, uint32_t bus_hz, bench_transport transport, bench_result *result)
+{
+    bench_setup(bc, bus_hz, transport, !bc->measure_begin);
+    // Let the last setup instruction finish executing
+    sim_advance_ns(HD44780_T_EXEC_HOME);
+    sim_reset_stats();
+    uint32_t violations = hd44780_sim_violation_count(&display);
+    uint64_t start = sim_now_ns();
+
+    if (bc->measure_begin) {
+        LCD_Begin(&lcd, bc->cols, bc->rows, LCD_5x8DOTS);
+    }
+    bc->run(&lcd);
+
+    const sim_stats *stats = sim_get_stats();
+    result->transactions = stats->transactions;
+    result->bytes = stats->bytes;
+    result->bus_ns = stats->bus_ns;
+    result->delay_ns = stats->delay_ns;
+    result->wall_ns = sim_now_ns() - start;
+    result->violations = hd44780_sim_violation_count(&display) - violations;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t rates[BENCH_MAX_RATES] = { 100000, 400000, 1000000 };
+    int rate_count = 3;
+    int custom_rates = 0;
+    bool json = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-json")) {
+            json = true;
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc && custom_rates < BENCH_MAX_RATES) {
+            rates[custom_rates++] = (uint32_t)strtoul(argv[++i], NULL, 0);
+            rate_count = custom_rates;
+        } else {
+            fprintf(stderr, "usage: %s [-json] [-b HZ]...\n", argv[0]);
+            return 2;
+        }
+    }
+
+    int failures = 0;
+    bool first = true;
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("case,transport,bus_hz,transactions,bytes,bus_us,delay_us,wall_us,violations\n");
+    }
+    for (size_t c = 0; c < sizeof(bench_cases) / sizeof(bench_cases[0]); c++) {
+        for (int tr = 0; tr < BENCH_TRANSPORTS; tr++) {
+            for (int r = 0; r < rate_count; r++) {
+                bench_result res;
+                bench_measure(&bench_cases[c], rates[r], (bench_transport)tr, &res);
+                failures += res.violations != 0;
+                const char *transport = bench_transport_names[tr];
+                if (json) {
+                    printf("%s  {\"case\": \"%s\", \"transport\": \"%s\", \"bus_hz\": %lu, "
+                           "\"transactions\": %u, \"bytes\": %u, \"bus_us\": %.3f, \"delay_us\": %.3f, "
+                           "\"wall_us\": %.3f, \"violations\": %u}",
+                           first ? "" : ",\n", bench_cases[c].name, transport, (unsigned long)rates[r],
+                           res.transactions, res.bytes, res.bus_ns / 1e3, res.delay_ns / 1e3,
+                           res.wall_ns / 1e3, res.violations);
+                } else {
+                    printf("%s,%s,%lu,%u,%u,%.3f,%.3f,%.3f,%u\n",
+                           bench_cases[c].name, transport, (unsigned long)rates[r],
+                           res.transactions, res.bytes, res.bus_ns / 1e3, res.delay_ns / 1e3,
+                           res.wall_ns / 1e3, res.violations);
+                }
+                first = false;
+            }
+        }
+    }
+    if (json) {
+        printf("\n]\n");
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+// Estimates the CPU time the driver itself spends per character, from the time
+// this host takes: the transport throws the GPIO values away and never makes the
+// driver wait. The figures compare variants of the driver; they are not cycle
+// counts on the target, where the core, compiler and flash wait states decide
+// (time LCD_WriteChar() with the DWT cycle counter there). Built twice by
+// the Makefile, as lcd_cpu with the pin map given to LCD_Init() at run time and
+// as lcd_cpu_fixed with the same Adafruit backpack wiring fixed at compile time
+// (-DLCD_PINMAP_ADAFRUIT), so the two can be compared.
+//
+//   lcd_cpu [-n CHARS]
+//
+//   -n CHARS  characters written per run (default 2000000)
+//
+// Prints host nanoseconds per character and, on x86, time stamp counter ticks per
+// character, one write per GPIO value and with the values batched.
+#define _POSIX_C_SOURCE 199309L // clock_gettime() under -std=c99
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "LiquidCrystal_C.h"
+#include "sim.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CPU_HAVE_TSC 1
+#endif
+
+#ifdef LCD_FIXED_PINS
+#define CPU_VARIANT "fixed pin map"
+#else
+#define CPU_VARIANT "runtime pin map"
+#endif
+
+static volatile uint32_t cpu_sink;
+
+static bool cpu_write(void *ctx, const uint8_t *values, uint16_t len)
+{
+    (void)ctx;
+    cpu_sink += values[len - 1];
+    return true;
+}
+
+static const LCD_TransportOps cpu_ops = { cpu_write, NULL, NULL, NULL };
+
+static uint64_t cpu_nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void cpu_run(const char *name, uint8_t caps, uint32_t chars)
+{
+    static LiquidCrystal_C lcd;
+    // MCP23008-like cost model at 100 kHz: every value takes longer on the bus
+    // than an instruction executes, so no delay is ever needed
+    LCD_Transport t = { &cpu_ops, NULL, caps, 1, 0, 20, 9, 0 };
+
+#ifdef LCD_FIXED_PINS
+    LCD_InitFixed(&lcd, NULL);
+#else
+    LCD_Init(&lcd, NULL, 1, 1, 255, 2, 3, 4, 5, 6, 0, 0, 0, 0);
+#endif
+    LCD_SetTransport(&lcd, &t);
+    LCD_SetBusClock(&lcd, 100000);
+    LCD_Begin(&lcd, 16, 2, LCD_5x8DOTS);
+
+    uint64_t start = cpu_nowNs();
+#ifdef CPU_HAVE_TSC
+    uint64_t ticks = __rdtsc();
+#endif
+    for (uint32_t i = 0; i < chars; i++) {
+        LCD_WriteChar(&lcd, (uint8_t)('A' + (i & 0x1F)));
+    }
+#ifdef CPU_HAVE_TSC
+    ticks = __rdtsc() - ticks;
+#endif
+    uint64_t ns = cpu_nowNs() - start;
+
+    printf("host estimate, %s, %s: %.1f ns/char", CPU_VARIANT, name, (double)ns / chars);
+#ifdef CPU_HAVE_TSC
+    printf(", %.0f TSC ticks/char", (double)ticks / chars);
+#endif
+    printf("\n");
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t chars = 2000000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            chars = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-n CHARS]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (chars == 0) chars = 1;
+
+    sim_reset();
+    cpu_run("one write per value", 0, chars);
+    cpu_run("batched", LCD_TRANSPORT_BURST, chars);
+    return 0;
+}
@@ -0,0 +1,219 @@
+// Runs several displays on one simulated I2C bus and shows how long each one's
+// update takes when a big redraw on one of them competes with small updates on
+// the others: first with blocking calls made one display after another, then
+// through the multi-display manager (LCD_Manager.c) with each scheduling policy.
+//
+//   lcd_multi [-n DISPLAYS] [-b HZ]
+//
+//   -n N     displays on the bus, 2..4 (default 3). Display 0 is a 20x4 that
+//            clears and redraws every row, the others are 16x2s that update one
+//            counter digit.
+//   -b HZ    I2C clock (default 400000)
+//
+// Every display sits on its own MCP23008 (0x20, 0x21, ...) with the burst
+// transport. The simulated bus finishes transfers before returning, so the
+// completion "interrupt" is recorded and delivered by the main loop, as the
+// real one would arrive after the transfer. Exits with 1 when a controller saw
+// a timing violation or a display shows the wrong text.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LiquidCrystal_C.h"
+#include "LCD_Manager.h"
+#include "sim.h"
+
+#define MULTI_MAX SIM_MAX_DEVICES
+
+typedef enum {
+    MULTI_SERIAL,      // blocking calls, one display after another
+    MULTI_ROUND_ROBIN,
+    MULTI_DEADLINE,
+    MULTI_MODES
+} multi_mode;
+
+static const char *multi_mode_names[MULTI_MODES] = { "serial", "round_robin", "deadline" };
+
+static const char *multi_rows[4] = {
+    "Tank 1   71 %  FILL ", "Tank 2   38 %  IDLE ", "Pump A  1450 rpm  OK", "Pump B     0 rpm OFF"
+};
+
+static I2C_HandleTypeDef hi2c1;
+static MCP23008_HandleTypeDef hmcp[MULTI_MAX];
+static LiquidCrystal_C lcds[MULTI_MAX];
+static hd44780_sim displays[MULTI_MAX];
+static LCD_Manager mgr;
+static int count = 3;
+static bool tx_done;          // completion waiting to be delivered
+static uint64_t start_ns;
+static uint64_t done_ns[MULTI_MAX];
+
+// The simulated HAL calls this at the end of every interrupt transfer
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+    tx_done = true;
+}
+
+static void multi_done(LiquidCrystal_C *lcd, void *ctx)
+{
+    (void)lcd;
+    done_ns[(intptr_t)ctx] = sim_now_ns() - start_ns;
+}
+
+static void multi_setup(uint32_t bus_hz)
+{
+    sim_reset();
+    hi2c1.Init.ClockSpeed = bus_hz;
+    for (int i = 0; i < count; i++) {
+        uint8_t addr = (uint8_t)(0x20 + i);
+        hd44780_sim_init(&displays[i], true);
+        sim_attach_mcp23008(&hi2c1, addr, &sim_wiring_adafruit, &displays[i]);
+        MCP23008_Init(&hi2c1, &hmcp[i], addr);
+        MCP23008_SetDirection(&hmcp[i], 0x00);
+        LCD_Init(&lcds[i], &hmcp[i], 1, 1, 255, 2, 3, 4, 5, 6, 0, 0, 0, 0);
+        LCD_SetBusClock(&lcds[i], bus_hz);
+        LCD_Clock clock = { sim_clock_now_us, sim_clock_delay_us, NULL };
+        LCD_SetClock(&lcds[i], &clock);
+        LCD_EnableBurst(&lcds[i], &hi2c1, addr, LCD_BurstBytesForLatency(500, bus_hz));
+    }
+    sim_advance_ns(HD44780_T_POWERUP);
+    for (int i = 0; i < count; i++) {
+        LCD_Begin(&lcds[i], (i == 0) ? 20 : 16, (i == 0) ? 4 : 2, LCD_5x8DOTS);
+        if (i > 0) {
+            LCD_WriteString(&lcds[i], "Count:        0");
+        }
+    }
+    sim_advance_ns(HD44780_T_EXEC_HOME);
+}
+
+// What each display is asked to do, queued (or, serially, done) in display order
+static void multi_update(int i)
+{
+    if (i == 0) {
+        LCD_Clear(&lcds[0]);
+        for (uint8_t row = 0; row < 4; row++) {
+            LCD_SetCursor(&lcds[0], 0, row);
+            LCD_WriteString(&lcds[0], multi_rows[row]);
+        }
+    } else {
+        LCD_SetCursor(&lcds[i], 14, 0);
+        LCD_WriteChar(&lcds[i], '1');
+    }
+}
+
+static bool multi_check(void)
+{
+    bool ok = true;
+    for (int i = 0; i < count; i++) {
+        for (int row = 0; row < ((i == 0) ? 4 : 1); row++) {
+            const char *want = (i == 0) ? multi_rows[row] : "Count:        1";
+            for (int col = 0; want[col] != '\0'; col++) {
+                if (hd44780_sim_visible(&displays[i], col, row, (i == 0) ? 20 : 16) != (uint8_t)want[col]) {
+                    ok = false;
+                }
+            }
+        }
+    }
+    return ok;
+}
+
+static int multi_run(multi_mode mode, uint32_t bus_hz)
+{
+    uint32_t violations[MULTI_MAX];
+
+    multi_setup(bus_hz);
+    for (int i = 0; i < count; i++) {
+        violations[i] = hd44780_sim_violation_count(&displays[i]);
+    }
+    if (mode != MULTI_SERIAL) {
+        LCD_Clock clock = { sim_clock_now_us, sim_clock_delay_us, NULL };
+        LCD_ManagerInit(&mgr, (mode == MULTI_DEADLINE) ? LCD_SCHED_DEADLINE : LCD_SCHED_ROUND_ROBIN, &clock);
+        for (int i = 0; i < count; i++) {
+            LCD_ManagerAdd(&mgr, &lcds[i], &hi2c1, false);
+            // The counters have to show up quickly, the redraw can wait
+            LCD_ManagerSetBudget(&mgr, i, (i == 0) ? 20000 : 500);
+        }
+    }
+    sim_reset_stats();
+    start_ns = sim_now_ns();
+
+    if (mode == MULTI_SERIAL) {
+        for (int i = 0; i < count; i++) {
+            multi_update(i);
+            multi_done(&lcds[i], (void *)(intptr_t)i);
+        }
+    } else {
+        for (int i = 0; i < count; i++) {
+            LCD_AsyncBegin(&lcds[i]);
+            multi_update(i);
+            LCD_AsyncEnd(&lcds[i], multi_done, (void *)(intptr_t)i);
+        }
+        while (tx_done || !LCD_ManagerIsIdle(&mgr)) {
+            if (tx_done) {
+                tx_done = false;
+                LCD_ManagerTxComplete(&mgr, &hi2c1);
+                continue;
+            }
+            LCD_ManagerPoll(&mgr);
+            if (!tx_done && !LCD_ManagerIsIdle(&mgr)) {
+                sim_advance_ns(1000); // every display is waiting out a delay
+            }
+        }
+    }
+
+    const sim_stats *stats = sim_get_stats();
+    uint64_t wall_ns = sim_now_ns() - start_ns;
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        LCD_ManagerStats st;
+        uint32_t v = hd44780_sim_violation_count(&displays[i]) - violations[i];
+        failures += v != 0;
+        if (mode == MULTI_SERIAL) {
+            memset(&st, 0, sizeof(st));
+        } else {
+            LCD_ManagerGetStats(&mgr, i, &st);
+        }
+        printf("%s,%lu,%d,%.3f,%u,%u,%u,%u,%u,%u,%u\n",
+               multi_mode_names[mode], (unsigned long)bus_hz, i, done_ns[i] / 1e3,
+               st.transfers, st.bytes, st.bus_us, st.wait_us, st.max_wait_us, st.late, v);
+    }
+    printf("# %s: %u transactions, bus busy %.3f us of %.3f us\n", multi_mode_names[mode],
+           stats->transactions, stats->bus_ns / 1e3, wall_ns / 1e3);
+    if (!multi_check()) {
+        printf("# %s: wrong screen contents\n", multi_mode_names[mode]);
+        failures++;
+    }
+    if (mode != MULTI_SERIAL) {
+        for (int i = 0; i < count; i++) {
+            LCD_AsyncStop(&lcds[i]);
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t bus_hz = 400000;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            bus_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            count = 0;
+            break;
+        }
+    }
+    if (count < 2 || count > MULTI_MAX) {
+        fprintf(stderr, "usage: %s [-n 2..%d] [-b HZ]\n", argv[0], MULTI_MAX);
+        return 2;
+    }
+
+    int failures = 0;
+    printf("mode,bus_hz,display,done_us,transfers,bytes,bus_us,wait_us,max_wait_us,late,violations\n");
+    for (int mode = 0; mode < MULTI_MODES; mode++) {
+        failures += multi_run((multi_mode)mode, bus_hz);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+// Replays a GPIO trace (LCD_TraceDump(), e.g. from lcd_sim -trace) through the
+// HD44780 model: prints every instruction and data byte the controllers latched,
+// then the screen they ended up with.
+//
+//   lcd_replay [-q] FILE
+//
+//   -q  only the summary and the final screen
+//
+// A trace that wrapped starts at a byte with the controllers in 4-bit (or 8-bit)
+// mode and the display on; cells nothing was written to since then show blank.
+// Until a controller's address is set (or it's cleared or sent home) nothing says
+// where its data goes: those bytes are listed but not drawn.
+// Timestamps are the times values were handed to the transport, so the model's
+// timing checks are not reported.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LCD_Trace.h"
+#include "hd44780_sim.h"
+
+static hd44780_sim ctrl[2];
+static bool placed[2]; // the address counter is known
+
+// Instruction as the datasheet names it
+static void describe(uint8_t v, char *out, size_t len)
+{
+    if (v & 0x80) {
+        snprintf(out, len, "set DDRAM address 0x%02X", v & 0x7F);
+    } else if (v & 0x40) {
+        snprintf(out, len, "set CGRAM address 0x%02X (char %u row %u)", v & 0x3F, (v >> 3) & 7, v & 7);
+    } else if (v & 0x20) {
+        snprintf(out, len, "function set: %s, %s, 5x%s", (v & 0x10) ? "8-bit" : "4-bit",
+                 (v & 0x08) ? "2 lines" : "1 line", (v & 0x04) ? "10" : "8");
+    } else if (v & 0x10) {
+        snprintf(out, len, "%s shift %s", (v & 0x08) ? "display" : "cursor", (v & 0x04) ? "right" : "left");
+    } else if (v & 0x08) {
+        snprintf(out, len, "display control: display %s, cursor %s, blink %s", (v & 0x04) ? "on" : "off",
+                 (v & 0x02) ? "on" : "off", (v & 0x01) ? "on" : "off");
+    } else if (v & 0x04) {
+        snprintf(out, len, "entry mode: %s, shift %s", (v & 0x02) ? "increment" : "decrement",
+                 (v & 0x01) ? "on" : "off");
+    } else if (v & 0x02) {
+        snprintf(out, len, "return home");
+    } else if (v & 0x01) {
+        snprintf(out, len, "clear display");
+    } else {
+        snprintf(out, len, "no operation");
+    }
+}
+
+static bool pin(uint16_t value, uint8_t p)
+{
+    return p < 16 && (value & (1u << p));
+}
+
+static uint8_t *read_file(const char *path, uint32_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+
+    uint32_t cap = 4096, n = 0;
+    uint8_t *buf = malloc(cap);
+    size_t got;
+    while (buf != NULL && (got = fread(buf + n, 1, cap - n, f)) > 0) {
+        n += (uint32_t)got;
+        if (n == cap) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    fclose(f);
+    *len = n;
+    return buf;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = NULL;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-q")) {
+            quiet = true;
+        } else if (argv[i][0] != '-' && path == NULL) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+    if (path == NULL) {
+        fprintf(stderr, "usage: %s [-q] FILE\n", argv[0]);
+        return 2;
+    }
+
+    uint32_t len;
+    uint8_t *dump = read_file(path, &len);
+    LCD_TraceReader reader;
+    if (dump == NULL) {
+        perror(path);
+        return 2;
+    }
+    if (!LCD_TraceOpen(&reader, dump, len)) {
+        fprintf(stderr, "%s: not a trace, or cut short\n", path);
+        return 2;
+    }
+
+    const LCD_TraceHeader *h = &reader.header;
+    int cols  = h->cols ? h->cols : 16;
+    int lines = h->lines ? h->lines : 2;
+    int ctrl_lines = (lines + h->num_ctrl - 1) / h->num_ctrl;
+    for (int c = 0; c < h->num_ctrl; c++) {
+        hd44780_sim_init(&ctrl[c], h->four_bit);
+        placed[c] = !h->wrapped;
+        if (h->wrapped) {
+            // Past the init sequence, at the start of a byte
+            ctrl[c].dl8 = !h->four_bit;
+            ctrl[c].two_line = ctrl_lines > 1;
+            ctrl[c].display_on = true;
+            ctrl[c].function_sets = 3;
+        }
+    }
+
+    uint16_t value = h->start_value;
+    uint32_t us = h->start_us;
+    uint32_t values = 0;
+    bool sync = true;
+    do {
+        uint64_t now_ns = (uint64_t)(us - h->start_us) * 1000;
+        bool rs = pin(value, h->rs_pin);
+        bool rw = pin(value, h->rw_pin);
+        uint8_t data = 0;
+        for (int i = 0; i < (h->four_bit ? 4 : 8); i++) {
+            if (pin(value, h->data_pins[i])) data |= 1u << (h->four_bit ? i + 4 : i);
+        }
+
+        bool latched[2] = { false, false };
+        for (int c = 0; c < h->num_ctrl; c++) {
+            uint32_t before = ctrl[c].instructions + ctrl[c].data_writes;
+            uint8_t ddram[sizeof(ctrl[c].ddram)];
+            if (!placed[c]) {
+                memcpy(ddram, ctrl[c].ddram, sizeof(ddram));
+            }
+            hd44780_sim_lines(&ctrl[c], now_ns, rs, rw, pin(value, h->enable_pins[c]), data);
+            latched[c] = ctrl[c].instructions + ctrl[c].data_writes != before;
+            if (latched[c] && !placed[c]) {
+                if (ctrl[c].last_rs && !ctrl[c].ac_cgram) {
+                    memcpy(ctrl[c].ddram, ddram, sizeof(ddram));
+                } else if (!ctrl[c].last_rs && (ctrl[c].last_value & 0x80 || ctrl[c].last_value < 0x04)) {
+                    placed[c] = ctrl[c].last_value != 0;
+                }
+            }
+        }
+        if (!quiet && (latched[0] || latched[1])) {
+            const hd44780_sim *s = latched[0] ? &ctrl[0] : &ctrl[1];
+            char what[80];
+            const char *who = (latched[0] && latched[1]) ? "E1+E2" : latched[0] ? "E1" : "E2";
+            if (s->last_rs && s->last_value >= 0x20 && s->last_value < 0x7F) {
+                snprintf(what, sizeof(what), "data 0x%02X '%c'", s->last_value, s->last_value);
+            } else if (s->last_rs) {
+                snprintf(what, sizeof(what), "data 0x%02X", s->last_value);
+            } else {
+                char instr[64];
+                describe(s->last_value, instr, sizeof(instr));
+                snprintf(what, sizeof(what), "cmd  0x%02X %s", s->last_value, instr);
+            }
+            printf("%12.3f ms %-5s %s\n", now_ns / 1e6, h->num_ctrl > 1 ? who : "", what);
+        }
+        values++;
+    } while (LCD_TraceNext(&reader, &value, &us, &sync));
+    values--; // the start value isn't a record
+
+    printf("%s: %u records in %u bytes (%.2f bytes each), %.3f ms, %s, %u byte values, %dx%d",
+           path, values, h->length, values ? (double)h->length / values : 0.0, (us - h->start_us) / 1e3,
+           h->four_bit ? "4-bit" : "8-bit", h->width, cols, lines);
+    if (h->wrapped) {
+        printf(", wrapped: %u older records dropped", h->dropped);
+    }
+    printf("\n");
+    for (int c = 0; c < h->num_ctrl; c++) {
+        printf("E%d: %u instructions, %u data bytes, %u reads\n", c + 1, ctrl[c].instructions,
+               ctrl[c].data_writes, ctrl[c].reads);
+    }
+    for (int c = 0; c < h->num_ctrl; c++) {
+        hd44780_sim_dump(&ctrl[c], stdout, cols, ctrl_lines);
+    }
+    if (h->backlight_pin < 16) {
+        printf("backlight %s\n", pin(value, h->backlight_pin) ? "on" : "off");
+    }
+    free(dump);
+    return 0;
+}
@@ -0,0 +1,379 @@
+// Runs the LCD_Demo.c scenarios against the simulated MCP23008 + HD44780 and
+// reports the final screen, bus statistics and any timing violations.
+//
+//   lcd_sim [-t TRANSPORT] [-b HZ] [-burst] [-async] [-clock] [-40x4] [-warm] [-trace FILE] [-v]
+//
+//   -t       mcp23008 (default), mcp23017, pcf8574, hc595 or gpio
+//   -b HZ    I2C clock (default 100000)
+//   -burst   stream GPIO values with LCD_EnableBurst() (MCP23008)
+//   -async   run the demo through the async engine once started (MCP23008 with -burst,
+//            MCP23017 or PCF8574), then clear and write a line with the async calls ten
+//            times, polling the engine every 10 us like a main loop would; the simulated
+//            transfers complete at once
+//   -clock   give the driver a microsecond clock instead of HAL_Delay()
+//   -40x4    a 40x4 module on the MCP23008: two controllers, E2 on the free GP0
+//   -warm    start with LCD_BeginWarm(), then after the demo reset the MCU half way
+//            through a byte and start again: the screen has to survive
+//   -trace FILE  record the GPIO values sent into a 4 KB trace (LCD_Trace.h) and dump
+//            it to FILE at the end, for lcd_replay
+//   -v       print the screen at every pause of a second or more
+//
+// The MCP23017 runs the LCD in 8-bit mode. It, the PCF8574 and the GPIO runs
+// wire RW, so they poll the busy flag. The 74HC595 runs its SPI clock at 5.25 MHz.
+// After the demo, the 40x4 run fills all four rows through the framebuffer and
+// leaves the cursor on the bottom half.
+// Exits with 1 when the controller saw a timing violation, or a warm start failed.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "LiquidCrystal_C.h"
+#include "LCD_Demo.h"
+#include "LCD_Trace.h"
+#include "LCD_Transport.h"
+#include "sim.h"
+
+#define SIM_COLS 16
+#define SIM_ROWS 2
+#define SIM_TRACE_BYTES 4096
+
+static I2C_HandleTypeDef hi2c1;
+static SPI_HandleTypeDef hspi1;
+static GPIO_TypeDef gpioa;
+static GPIO_TypeDef gpiob;
+static MCP23008_HandleTypeDef hmcp;
+static LCD_MCP23017 mcp23017;
+static LCD_PCF8574 pcf;
+static LCD_HC595 hc595;
+static LCD_DirectGPIO direct;
+static LiquidCrystal_C lcd;
+static hd44780_sim display;
+static hd44780_sim display2; // bottom half of the 40x4 module
+static bool quad;
+static int cols = SIM_COLS;
+static int rows = SIM_ROWS;
+static LCD_Trace trace;
+static uint8_t trace_buf[SIM_TRACE_BYTES];
+
+// The simulated HAL calls these at the end of every interrupt transfer
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+    if (lcd.async.enabled) {
+        LCD_AsyncTxComplete(&lcd);
+    }
+}
+
+void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+    if (lcd.async.enabled) {
+        LCD_AsyncTxComplete(&lcd);
+    }
+}
+
+#ifdef LCD_ENABLE_INSTRUMENTATION
+static void print_instrumentation(void)
+{
+    static const char *names[LCD_API_COUNT] = {
+        "Begin", "Clear", "Home", "SetCursor", "DisplayControl", "Scroll", "EntryMode",
+        "CreateChar", "WriteChar", "WriteString", "SetBacklight", "Flush", "ReadStatus"
+    };
+    LCD_Instrumentation in;
+
+    LCD_GetInstrumentation(&lcd, &in);
+    printf("driver: %u commands, %u data bytes, %u pin writes, %u enable pulses, %u expander writes, "
+           "%u reads, delays %u us, ready waits %u us, %u HAL errors, %u retries\n",
+           in.commands, in.data_bytes, in.pin_writes, in.enable_pulses, in.expander_writes,
+           in.expander_reads, in.delay_us, in.ready_wait_us, in.hal_errors, in.retries);
+    for (int id = 0; id < LCD_API_COUNT; id++) {
+        const LCD_ApiLatency *lat = &in.api[id];
+        if (lat->calls == 0) continue;
+        printf("  %-14s %4u calls, avg %6u us, max %6u us, log2 buckets:", names[id], lat->calls,
+               lat->total_us / lat->calls, lat->max_us);
+        for (int b = 0; b < LCD_INSTR_BUCKETS; b++) {
+            printf(" %u", lat->hist[b]);
+        }
+        printf("\n");
+    }
+}
+#endif
+
+// The 40x4 module as its two halves, one per controller
+static void dump_screen(void)
+{
+    hd44780_sim_dump(&display, stdout, cols, quad ? 2 : rows);
+    if (quad) {
+        hd44780_sim_dump(&display2, stdout, cols, 2);
+    }
+}
+
+static uint8_t screen_char(int col, int row)
+{
+    if (quad && row >= 2) {
+        return hd44780_sim_visible(&display2, col, row - 2, cols);
+    }
+    return hd44780_sim_visible(&display, col, row, cols);
+}
+
+// An MCU reset half way through a byte: one stray nibble (the high half of a DDRAM
+// address) reaches the controller, then the driver starts over from its state before
+// LCD_Begin(), with only the marker surviving. Returns true if the warm path was taken
+// and the screen is unchanged.
+static bool warm_restart(const LiquidCrystal_C *fresh, LCD_WarmMarker *marker)
+{
+    uint8_t before[LCD_MAX_LINES][LCD_MAX_COLS];
+
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            before[row][col] = screen_char(col, row);
+        }
+    }
+    // The reset takes a while: whatever the demo sent last has finished by then
+    sim_advance_ns(HD44780_T_EXEC_HOME);
+    if (!(lcd.displayfunction & LCD_8BITMODE)) {
+        uint16_t v = (lcd.gpio_shadow & ~lcd.bus_mask) | lcd.nibble_lut[0][0x8];
+        uint16_t stray[3] = { v, (uint16_t)(v | lcd.en_bits[1]), v };
+        for (int i = 0; i < 3; i++) {
+            uint8_t bytes[2] = { (uint8_t)stray[i], (uint8_t)(stray[i] >> 8) };
+            lcd.transport.ops->write(lcd.transport.ctx, bytes, lcd.transport.value_bytes == 2 ? 2 : 1);
+        }
+    }
+
+    lcd = *fresh;
+    sim_reset_stats();
+    uint64_t start_ns = sim_now_ns();
+    bool warm = LCD_BeginWarm(&lcd, cols, rows, LCD_5x8DOTS, marker);
+    uint64_t took_ns = sim_now_ns() - start_ns;
+
+    int changed = 0;
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            changed += before[row][col] != screen_char(col, row);
+        }
+    }
+    const sim_stats *stats = sim_get_stats();
+    printf("warm start: %s, %u transactions, %.3f ms, %d cells changed\n", warm ? "taken" : "NOT taken",
+           stats->transactions, took_ns / 1e6, changed);
+    return warm && changed == 0;
+}
+
+static void write_trace(void *ctx, const uint8_t *data, uint32_t len)
+{
+    fwrite(data, 1, len, (FILE *)ctx);
+}
+
+// Dump the trace for lcd_replay. False if the file can't be written.
+static bool save_trace(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) {
+        perror(path);
+        return false;
+    }
+    LCD_TraceStats ts;
+    LCD_TraceGetStats(&trace, &ts);
+    LCD_TraceDump(&trace, write_trace, f);
+    fclose(f);
+    printf("trace: %u values, %u dropped, %u of %u bytes covering the last %.3f s (%.2f bytes per value), "
+           "%u byte dump in %s\n", ts.values, ts.dropped, ts.used, SIM_TRACE_BYTES, ts.span_us / 1e6,
+           (ts.values - ts.dropped) ? (double)ts.used / (ts.values - ts.dropped) : 0.0,
+           LCD_TraceDumpSize(&trace), path);
+    return true;
+}
+
+static void print_screen(uint32_t ms, void *ctx)
+{
+    (void)ctx;
+    if (ms < 1000) return;
+    printf("t=%.3f ms\n", sim_now_ns() / 1e6);
+    dump_screen();
+}
+
+int main(int argc, char **argv)
+{
+    const char *transport = "mcp23008";
+    uint32_t bus_hz = 100000;
+    bool burst = false;
+    bool async = false;
+    bool clock = false;
+    bool verbose = false;
+    bool warm = false;
+    const char *trace_path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            transport = argv[++i];
+        } else if (!strcmp(argv[i], "-b") && i + 1 < argc) {
+            bus_hz = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else if (!strcmp(argv[i], "-burst")) {
+            burst = true;
+        } else if (!strcmp(argv[i], "-async")) {
+            async = true;
+        } else if (!strcmp(argv[i], "-clock")) {
+            clock = true;
+        } else if (!strcmp(argv[i], "-40x4")) {
+            quad = true;
+            cols = 40;
+            rows = 4;
+        } else if (!strcmp(argv[i], "-warm")) {
+            warm = true;
+        } else if (!strcmp(argv[i], "-trace") && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (!strcmp(argv[i], "-v")) {
+            verbose = true;
+        } else {
+            fprintf(stderr, "usage: %s [-t TRANSPORT] [-b HZ] [-burst] [-async] [-clock] [-40x4] [-warm] [-trace FILE] [-v]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (quad && strcmp(transport, "mcp23008") != 0) {
+        fprintf(stderr, "-40x4 needs the mcp23008 transport\n");
+        return 2;
+    }
+
+    sim_reset();
+    hi2c1.Init.ClockSpeed = bus_hz;
+    hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_16;
+    // Only the MCP23017 has the pins to wire D0..D3
+    hd44780_sim_init(&display, strcmp(transport, "mcp23017") != 0);
+    hd44780_sim_init(&display2, true);
+    if (verbose) {
+        sim_set_delay_hook(print_screen, NULL);
+    }
+    LCD_Clock sim_clock = { sim_clock_now_us, sim_clock_delay_us, NULL };
+    LCD_Transport t;
+    sim_port *port;
+
+    if (!strcmp(transport, "mcp23008")) {
+        // Same bring-up as main.c
+        sim_wiring wiring = sim_wiring_adafruit;
+        if (quad) {
+            wiring.en2 = 0;
+        }
+        port = &sim_attach_mcp23008(&hi2c1, 0x20, &wiring, &display)->port;
+        port->lcd2 = quad ? &display2 : NULL;
+        MCP23008_Init(&hi2c1, &hmcp, 0x20);
+        MCP23008_SetDirection(&hmcp, 0x00);
+        LCD_Init(&lcd, &hmcp,
+                 1,
+                 1, 255, 2,
+                 3, 4, 5, 6,
+                 0, 0, 0, 0);
+        if (quad) {
+            LCD_AddController(&lcd, 0);
+        }
+        LCD_SetBusClock(&lcd, bus_hz);
+    } else if (!strcmp(transport, "mcp23017")) {
+        port = &sim_attach_mcp23017(&hi2c1, 0x20, &sim_wiring_mcp23017, &display)->port;
+        LCD_Init(&lcd, NULL, 0, 8, 9, 10, 0, 1, 2, 3, 4, 5, 6, 7);
+        LCD_SetBacklightPin(&lcd, 11);
+        if (!LCD_TransportMCP23017(&t, &mcp23017, &hi2c1, 0x20)) {
+            fprintf(stderr, "LCD_TransportMCP23017 failed\n");
+            return 2;
+        }
+        LCD_SetTransport(&lcd, &t);
+        LCD_SetBusClock(&lcd, bus_hz);
+    } else if (!strcmp(transport, "pcf8574")) {
+        port = &sim_attach_pcf8574(&hi2c1, 0x27, &sim_wiring_pcf8574, &display)->port;
+        LCD_Init(&lcd, NULL, 1, 0, 1, 2, 4, 5, 6, 7, 0, 0, 0, 0);
+        LCD_SetBacklightPin(&lcd, 3);
+        LCD_TransportPCF8574(&t, &pcf, &hi2c1, 0x27);
+        LCD_SetTransport(&lcd, &t);
+        LCD_SetBusClock(&lcd, bus_hz);
+    } else if (!strcmp(transport, "hc595")) {
+        port = &sim_attach_hc595(&hspi1, &gpiob, 1 << 0, &sim_wiring_adafruit, &display)->port;
+        LCD_Init(&lcd, NULL, 1, 1, 255, 2, 3, 4, 5, 6, 0, 0, 0, 0);
+        LCD_TransportHC595(&t, &hc595, &hspi1, &gpiob, 1 << 0);
+        LCD_SetTransport(&lcd, &t);
+        LCD_SetBusClock(&lcd, SIM_SPI_PCLK_HZ / 16);
+    } else if (!strcmp(transport, "gpio")) {
+        port = &sim_attach_gpio(&gpioa, &sim_wiring_pcf8574, &display)->port;
+        for (int i = 0; i < 8; i++) {
+            direct.port[i] = &gpioa;
+            direct.pin[i] = 1 << i;
+        }
+        LCD_Init(&lcd, NULL, 1, 0, 1, 2, 4, 5, 6, 7, 0, 0, 0, 0);
+        LCD_SetBacklightPin(&lcd, 3);
+        LCD_TransportGPIO(&t, &direct, clock ? &sim_clock : NULL);
+        LCD_SetTransport(&lcd, &t);
+        // Pins come up as inputs: make them outputs
+        t.ops->set_inputs(t.ctx, 0x00);
+    } else {
+        fprintf(stderr, "unknown transport %s\n", transport);
+        return 2;
+    }
+    if (clock) {
+        LCD_SetClock(&lcd, &sim_clock);
+    }
+    if (burst && !LCD_EnableBurst(&lcd, &hi2c1, 0x20, LCD_BURST_BUFSIZE)) {
+        fprintf(stderr, "LCD_EnableBurst failed\n");
+        return 2;
+    }
+    if (trace_path != NULL) {
+        LCD_TraceInit(&trace, trace_buf, sizeof(trace_buf));
+        LCD_TraceAttach(&trace, &lcd);
+    }
+    // Kept in .noinit RAM on the target. Zero here: the first start is a cold one.
+    static LCD_WarmMarker marker;
+    LiquidCrystal_C fresh = lcd;
+    if (warm) {
+        LCD_BeginWarm(&lcd, cols, rows, LCD_5x8DOTS, &marker);
+    } else {
+        LCD_Begin(&lcd, cols, rows, LCD_5x8DOTS);
+    }
+    if (async && !LCD_AsyncInit(&lcd, false)) {
+        fprintf(stderr, "LCD_AsyncInit failed: the transport can't run the async engine\n");
+        return 2;
+    }
+    LCD_SetBacklight(&lcd, true);
+
+    LCD_RunDemo(&lcd);
+
+    // Each round starts 0.1 ms further into a HAL tick, so without a clock some wait
+    // starts just before a tick edge
+    for (int i = 0; async && i < 10; i++) {
+        sim_advance_ns(1000000 - sim_now_ns() % 1000000 + i * 100000);
+        LCD_ClearAsync(&lcd, NULL, NULL);
+        LCD_WriteStringAsync(&lcd, "Async done", NULL, NULL);
+        while (!LCD_IsIdle(&lcd)) {
+            LCD_AsyncPoll(&lcd);
+            sim_advance_ns(10000);
+        }
+    }
+
+    if (quad) {
+        LCD_FbClear(&lcd);
+        for (int row = 0; row < rows; row++) {
+            char line[64]; // LCD_FbWrite() cuts it at the last column
+            snprintf(line, sizeof(line), "Row %d on E%d: the framebuffer spans both", row, row / 2 + 1);
+            LCD_FbWrite(&lcd, 0, row, line);
+        }
+        LCD_Flush(&lcd);
+        LCD_SetCursor(&lcd, 39, 3);
+        LCD_Cursor(&lcd);
+    }
+
+    const sim_stats *stats = sim_get_stats();
+    dump_screen();
+    if (quad) {
+        printf("cursor: E1 %s, E2 %s\n", display.cursor_on ? "on" : "off", display2.cursor_on ? "on" : "off");
+    }
+    printf("backlight %s\n", port->backlight ? "on" : "off");
+    printf("%s, bus %lu Hz: %u transactions (%u writes, %u reads), %u bytes, bus busy %.3f ms, delays %.3f ms, total %.3f ms\n",
+           transport, (unsigned long)bus_hz, stats->transactions, stats->writes, stats->reads, stats->bytes,
+           stats->bus_ns / 1e6, stats->delay_ns / 1e6, sim_now_ns() / 1e6);
+#ifdef LCD_ENABLE_INSTRUMENTATION
+    print_instrumentation();
+#endif
+    bool warm_failed = warm && !warm_restart(&fresh, &marker);
+    hd44780_sim_report(&display, stdout);
+    if (quad) {
+        hd44780_sim_report(&display2, stdout);
+    }
+    if (trace_path != NULL && !save_trace(trace_path)) {
+        return 2;
+    }
+
+    return (warm_failed || hd44780_sim_violation_count(&display) + hd44780_sim_violation_count(&display2)) ? 1 : 0;
+}
@@ -0,0 +1,176 @@
+// Measures the UTF-8 write path over a mixed-script corpus (units, Western
+// European accents, Greek, Cyrillic, katakana) against ASCII text of the same
+// length, for both character ROMs:
+//
+//   - CPU time per character of decoding and mapping alone (LCD_Utf8Transcode()
+//     without a glyph cache), and of plain ASCII through the same path
+//   - bytes on the simulated bus per character of LCD_Utf8Write() at 400 kHz
+//     with bursts, CGRAM glyph uploads included, against LCD_WriteString()
+//
+//   lcd_utf8 [-n PASSES]
+//
+//   -n PASSES  passes over the corpus for the CPU figures (default 20000)
+//
+// Prints how the corpus maps onto each ROM, then one line per measurement.
+#define _POSIX_C_SOURCE 199309L // clock_gettime() under -std=c99
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "LiquidCrystal_C.h"
+#include "LCD_Glyph.h"
+#include "LCD_Utf8.h"
+#include "sim.h"
+
+static const char *utf8_corpus[] = {
+    "Temp 23.5 °C",
+    "C = 4.7 µF",
+    "R = 10 kΩ ±1%",
+    "Größe: 12 mm",
+    "Café crème",
+    "Niño, año ½",
+    "Straße 5 €",
+    "Ångström",
+    "Δt = 0.5 s",
+    "α β π Σ ∞",
+    "Привет мир",
+    "Напряжение 5 В",
+    "ｶﾀｶﾅ ﾃｽﾄ",
+    "カタカナ テスト",
+    "x² + y³",
+    "C:\\Temp ~1",
+};
+
+// The same lines spelt in ASCII, for the baseline
+static const char *utf8_ascii[] = {
+    "Temp 23.5 dC",
+    "C = 4.7 uF",
+    "R = 10 kO +-1%",
+    "Groesse: 12 mm",
+    "Cafe creme",
+    "Nino, ano 1/2",
+    "Strasse 5 E",
+    "Angstrom",
+    "dt = 0.5 s",
+    "a b p S inf",
+    "Privet mir",
+    "Napryazhenie 5 V",
+    "Katakana test",
+    "Katakana test",
+    "x^2 + y^3",
+    "C:/Temp -1",
+};
+
+#define UTF8_LINES (sizeof(utf8_corpus) / sizeof(utf8_corpus[0]))
+
+static const char *utf8_rom_names[] = { "A00", "A02" };
+
+static I2C_HandleTypeDef hi2c1;
+static MCP23008_HandleTypeDef hmcp;
+static LiquidCrystal_C lcd;
+static hd44780_sim display;
+static volatile uint32_t utf8_sink;
+
+static uint64_t utf8_nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void utf8_begin(void)
+{
+    sim_reset();
+    hi2c1.Init.ClockSpeed = 400000;
+    hd44780_sim_init(&display, true);
+    sim_attach_mcp23008(&hi2c1, 0x20, &sim_wiring_adafruit, &display);
+    MCP23008_Init(&hi2c1, &hmcp, 0x20);
+    MCP23008_SetDirection(&hmcp, 0x00);
+    LCD_Init(&lcd, &hmcp, 1, 1, 255, 2, 3, 4, 5, 6, 0, 0, 0, 0);
+    LCD_SetBusClock(&lcd, 400000);
+    LCD_Clock clock = { sim_clock_now_us, sim_clock_delay_us, NULL };
+    LCD_SetClock(&lcd, &clock);
+    LCD_EnableBurst(&lcd, &hi2c1, 0x20, LCD_BURST_BUFSIZE);
+    sim_advance_ns(HD44780_T_POWERUP);
+    LCD_Begin(&lcd, 20, 4, LCD_5x8DOTS);
+}
+
+// Decode and map every line passes times; returns ns per character
+static double utf8_cpu(LCD_Rom rom, const char **lines, uint32_t passes, uint32_t *chars)
+{
+    LCD_Utf8 text;
+    uint8_t out[64];
+
+    LCD_Utf8Init(&text, &lcd, rom, NULL);
+    uint64_t start = utf8_nowNs();
+    for (uint32_t p = 0; p < passes; p++) {
+        for (size_t l = 0; l < UTF8_LINES; l++) {
+            size_t n = LCD_Utf8Transcode(&text, lines[l], out, sizeof(out));
+            utf8_sink += out[n - 1];
+        }
+    }
+    uint64_t ns = utf8_nowNs() - start;
+    *chars = text.stats.chars / passes;
+    return (double)ns / text.stats.chars;
+}
+
+// Bus bytes of writing every line onto a cleared row
+static uint32_t utf8_bus(LCD_Rom rom, const char **lines, bool utf8, LCD_Utf8Stats *stats)
+{
+    LCD_GlyphCache glyphs;
+    LCD_Utf8 text;
+
+    utf8_begin();
+    LCD_GlyphInit(&glyphs, &lcd);
+    LCD_Utf8Init(&text, &lcd, rom, &glyphs);
+    sim_advance_ns(HD44780_T_EXEC_HOME);
+    sim_reset_stats();
+    for (size_t l = 0; l < UTF8_LINES; l++) {
+        LCD_SetCursor(&lcd, 0, l & 3);
+        if (utf8) {
+            LCD_Utf8Write(&text, lines[l]);
+        } else {
+            LCD_WriteString(&lcd, lines[l]);
+        }
+    }
+    LCD_Utf8GetStats(&text, stats);
+    return sim_get_stats()->bytes;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t passes = 20000;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            passes = (uint32_t)strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "usage: %s [-n PASSES]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (passes == 0) passes = 1;
+
+    utf8_begin();
+    for (int rom = LCD_ROM_A00; rom <= LCD_ROM_A02; rom++) {
+        uint32_t ascii_chars, mixed_chars;
+        double ascii_ns = utf8_cpu((LCD_Rom)rom, utf8_ascii, passes, &ascii_chars);
+        double mixed_ns = utf8_cpu((LCD_Rom)rom, utf8_corpus, passes, &mixed_chars);
+
+        LCD_Utf8Stats ascii_stats, mixed_stats;
+        uint32_t ascii_bytes = utf8_bus((LCD_Rom)rom, utf8_ascii, false, &ascii_stats);
+        uint32_t mixed_bytes = utf8_bus((LCD_Rom)rom, utf8_corpus, true, &mixed_stats);
+
+        printf("%s: %u code points, %u ASCII, %u in ROM, %u CGRAM glyphs, %u replaced\n",
+               utf8_rom_names[rom], (unsigned)mixed_stats.chars,
+               (unsigned)(mixed_stats.chars - mixed_stats.rom - mixed_stats.synthesized
+                          - mixed_stats.replaced - mixed_stats.invalid),
+               (unsigned)mixed_stats.rom, (unsigned)mixed_stats.synthesized,
+               (unsigned)(mixed_stats.replaced + mixed_stats.invalid));
+        printf("%s: transcode ASCII %.1f ns/char, mixed %.1f ns/char\n",
+               utf8_rom_names[rom], ascii_ns, mixed_ns);
+        printf("%s: bus ASCII %.1f bytes/char (LCD_WriteString), mixed %.1f bytes/char (LCD_Utf8Write)\n",
+               utf8_rom_names[rom], (double)ascii_bytes / ascii_chars, (double)mixed_bytes / mixed_chars);
+    }
+    return 0;
+}
@@ -0,0 +1,629 @@
+#include "sim.h"
+#include "MCP23008.h"
+#include <string.h>
+
+#define SIM_IOCON_SEQOP 0x20
+#define SIM_REG_IODIR   0x00
+#define SIM_REG_IOCON   0x05
+#define SIM_REG_GPIO    0x09
+#define SIM_REG_OLAT    0x0A
+#define SIM_REG_COUNT   11
+
+#define SIM_17_IODIRA   0x00
+#define SIM_17_IOCONA   0x0A
+#define SIM_17_IOCONB   0x0B
+#define SIM_17_GPIOA    0x12
+#define SIM_17_OLATA    0x14
+#define SIM_17_COUNT    22
+
+const sim_wiring sim_wiring_adafruit = {
+    .rs = 1, .rw = SIM_NC, .en = 2, .en2 = SIM_NC, .backlight = 7,
+    .d = { SIM_NC, SIM_NC, SIM_NC, SIM_NC, 3, 4, 5, 6 }
+};
+
+const sim_wiring sim_wiring_pcf8574 = {
+    .rs = 0, .rw = 1, .en = 2, .en2 = SIM_NC, .backlight = 3,
+    .d = { SIM_NC, SIM_NC, SIM_NC, SIM_NC, 4, 5, 6, 7 }
+};
+
+const sim_wiring sim_wiring_mcp23017 = {
+    .rs = 8, .rw = 9, .en = 10, .en2 = SIM_NC, .backlight = 11,
+    .d = { 0, 1, 2, 3, 4, 5, 6, 7 }
+};
+
+static uint64_t sim_time_ns;
+static sim_mcp23008 sim_devices[SIM_MAX_DEVICES];
+static int sim_device_count;
+static sim_mcp23017 sim_mcp23017s[SIM_MAX_DEVICES];
+static int sim_mcp23017_count;
+static sim_pcf8574 sim_pcfs[SIM_MAX_DEVICES];
+static int sim_pcf_count;
+static sim_hc595 sim_hc595s[SIM_MAX_DEVICES];
+static int sim_hc595_count;
+static sim_gpio sim_gpios[SIM_MAX_DEVICES];
+static int sim_gpio_count;
+static sim_stats sim_statistics;
+static void (*sim_delay_hook)(uint32_t ms, void *ctx);
+static void *sim_delay_ctx;
+
+/******************************************************************************
+ * Time
+ ******************************************************************************/
+void sim_reset(void)
+{
+    sim_time_ns = 0;
+    sim_device_count = 0;
+    sim_mcp23017_count = 0;
+    sim_pcf_count = 0;
+    sim_hc595_count = 0;
+    sim_gpio_count = 0;
+    memset(sim_devices, 0, sizeof(sim_devices));
+    memset(sim_mcp23017s, 0, sizeof(sim_mcp23017s));
+    memset(sim_pcfs, 0, sizeof(sim_pcfs));
+    memset(sim_hc595s, 0, sizeof(sim_hc595s));
+    memset(sim_gpios, 0, sizeof(sim_gpios));
+    memset(&sim_statistics, 0, sizeof(sim_statistics));
+}
+
+uint64_t sim_now_ns(void)
+{
+    return sim_time_ns;
+}
+
+void sim_advance_ns(uint64_t ns)
+{
+    sim_time_ns += ns;
+}
+
+const sim_stats *sim_get_stats(void)
+{
+    return &sim_statistics;
+}
+
+void sim_reset_stats(void)
+{
+    memset(&sim_statistics, 0, sizeof(sim_statistics));
+}
+
+void sim_set_delay_hook(void (*hook)(uint32_t ms, void *ctx), void *ctx)
+{
+    sim_delay_hook = hook;
+    sim_delay_ctx = ctx;
+}
+
+uint32_t sim_clock_now_us(void *ctx)
+{
+    (void)ctx;
+    return (uint32_t)(sim_time_ns / 1000);
+}
+
+void sim_clock_delay_us(void *ctx, uint32_t us)
+{
+    (void)ctx;
+    sim_time_ns += (uint64_t)us * 1000;
+    sim_statistics.delay_ns += (uint64_t)us * 1000;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    if (sim_delay_hook) {
+        sim_delay_hook(Delay, sim_delay_ctx);
+    }
+    // Like the HAL, wait at least one full tick more than asked for
+    uint64_t ns = (uint64_t)(Delay + 1) * 1000000 - sim_time_ns % 1000000;
+    sim_time_ns += ns;
+    sim_statistics.delay_ns += ns;
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return (uint32_t)(sim_time_ns / 1000000);
+}
+
+void __NOP(void)
+{
+    sim_time_ns += SIM_NOP_NS;
+    sim_statistics.delay_ns += SIM_NOP_NS;
+}
+
+/******************************************************************************
+ * Device pins
+ ******************************************************************************/
+static void sim_portInit(sim_port *port, const sim_wiring *wiring, hd44780_sim *lcd)
+{
+    port->wiring = *wiring;
+    port->lcd = lcd;
+}
+
+// Level a device puts on one of its pins: the latch where it drives the pin,
+// the pull-up (or nothing) where it doesn't
+static bool sim_level(const sim_port *port, int pin)
+{
+    if (pin == SIM_NC) return false;
+    if (port->released & (1 << pin)) return port->pullup;
+    return port->out & (1 << pin);
+}
+
+// Level on every pin as read back, including what the LCD drives onto the data lines
+static uint16_t sim_pins(const sim_port *port)
+{
+    uint16_t pins = port->out & ~port->released;
+    if (port->pullup) {
+        pins |= port->released;
+    }
+    hd44780_sim *lcds[2] = { port->lcd, port->lcd2 };
+    for (int n = 0; n < 2; n++) {
+        if (!lcds[n] || !lcds[n]->rw || !lcds[n]->e) continue;
+        uint8_t out = hd44780_sim_output(lcds[n], sim_time_ns);
+        for (int i = 0; i < 8; i++) {
+            int pin = port->wiring.d[i];
+            if (pin == SIM_NC || !(port->released & (1 << pin))) continue;
+            pins = (out & (1 << i)) ? (pins | (1 << pin)) : (pins & ~(1 << pin));
+        }
+    }
+    return pins;
+}
+
+// Outputs changed: pass the new levels on to the LCD
+static void sim_update(sim_port *port)
+{
+    const sim_wiring *w = &port->wiring;
+
+    port->backlight = sim_level(port, w->backlight);
+    if (!port->lcd) return;
+
+    // Data lines nothing drives keep their last level
+    uint8_t data = port->lcd->data;
+    for (int i = 0; i < 8; i++) {
+        int pin = w->d[i];
+        if (pin == SIM_NC || ((port->released & (1 << pin)) && !port->pullup)) continue;
+        data = sim_level(port, pin) ? (data | (1 << i)) : (data & ~(1 << i));
+    }
+    hd44780_sim_lines(port->lcd, sim_time_ns, sim_level(port, w->rs), sim_level(port, w->rw),
+                      sim_level(port, w->en), data);
+    if (port->lcd2) {
+        hd44780_sim_lines(port->lcd2, sim_time_ns, sim_level(port, w->rs), sim_level(port, w->rw),
+                          sim_level(port, w->en2), data);
+    }
+}
+
+/******************************************************************************
+ * MCP23008 model
+ ******************************************************************************/
+sim_mcp23008 *sim_attach_mcp23008(I2C_HandleTypeDef *hi2c, uint8_t addr, const sim_wiring *wiring,
+                                  hd44780_sim *lcd)
+{
+    if (sim_device_count >= SIM_MAX_DEVICES) return NULL;
+    sim_mcp23008 *dev = &sim_devices[sim_device_count++];
+    memset(dev, 0, sizeof(*dev));
+    dev->hi2c = hi2c;
+    dev->addr = addr;
+    dev->regs[SIM_REG_IODIR] = 0xFF; // power-on: all inputs
+    sim_portInit(&dev->port, wiring, lcd);
+    dev->port.released = 0xFF;
+    return dev;
+}
+
+static sim_mcp23008 *sim_find(I2C_HandleTypeDef *hi2c, uint16_t dev_address)
+{
+    for (int i = 0; i < sim_device_count; i++) {
+        if (sim_devices[i].hi2c == hi2c && sim_devices[i].addr == (dev_address >> 1)) {
+            return &sim_devices[i];
+        }
+    }
+    return NULL;
+}
+
+static void sim_writeRegister(sim_mcp23008 *dev, uint8_t value)
+{
+    uint8_t reg = dev->pointer;
+    if (reg < SIM_REG_COUNT) {
+        // Writing GPIO writes the output latch; every other register is plain storage
+        if (reg == SIM_REG_GPIO || reg == SIM_REG_OLAT) {
+            dev->regs[SIM_REG_OLAT] = value;
+        } else {
+            dev->regs[reg] = value;
+        }
+        if (reg == SIM_REG_GPIO || reg == SIM_REG_OLAT || reg == SIM_REG_IODIR) {
+            dev->port.out = dev->regs[SIM_REG_OLAT];
+            dev->port.released = dev->regs[SIM_REG_IODIR];
+            sim_update(&dev->port);
+        }
+    }
+    if (!(dev->regs[SIM_REG_IOCON] & SIM_IOCON_SEQOP)) {
+        dev->pointer = (dev->pointer + 1) % SIM_REG_COUNT;
+    }
+}
+
+static uint8_t sim_readRegister(sim_mcp23008 *dev)
+{
+    uint8_t reg = dev->pointer;
+    uint8_t value = 0;
+    if (reg == SIM_REG_GPIO) {
+        value = (uint8_t)sim_pins(&dev->port);
+    } else if (reg < SIM_REG_COUNT) {
+        value = dev->regs[reg];
+    }
+    if (!(dev->regs[SIM_REG_IOCON] & SIM_IOCON_SEQOP)) {
+        dev->pointer = (dev->pointer + 1) % SIM_REG_COUNT;
+    }
+    return value;
+}
+
+/******************************************************************************
+ * MCP23017 model (IOCON.BANK = 0 only)
+ ******************************************************************************/
+sim_mcp23017 *sim_attach_mcp23017(I2C_HandleTypeDef *hi2c, uint8_t addr, const sim_wiring *wiring,
+                                  hd44780_sim *lcd)
+{
+    if (sim_mcp23017_count >= SIM_MAX_DEVICES) return NULL;
+    sim_mcp23017 *dev = &sim_mcp23017s[sim_mcp23017_count++];
+    memset(dev, 0, sizeof(*dev));
+    dev->hi2c = hi2c;
+    dev->addr = addr;
+    dev->regs[SIM_17_IODIRA] = 0xFF; // power-on: all inputs
+    dev->regs[SIM_17_IODIRA + 1] = 0xFF;
+    sim_portInit(&dev->port, wiring, lcd);
+    dev->port.released = 0xFFFF;
+    return dev;
+}
+
+static sim_mcp23017 *sim_find17(I2C_HandleTypeDef *hi2c, uint16_t dev_address)
+{
+    for (int i = 0; i < sim_mcp23017_count; i++) {
+        if (sim_mcp23017s[i].hi2c == hi2c && sim_mcp23017s[i].addr == (dev_address >> 1)) {
+            return &sim_mcp23017s[i];
+        }
+    }
+    return NULL;
+}
+
+// Sequential mode walks through every register; byte mode (SEQOP) toggles within an A/B pair
+static void sim_step17(sim_mcp23017 *dev)
+{
+    if (dev->regs[SIM_17_IOCONA] & SIM_IOCON_SEQOP) {
+        dev->pointer ^= 1;
+    } else {
+        dev->pointer = (dev->pointer + 1) % SIM_17_COUNT;
+    }
+}
+
+static void sim_writeRegister17(sim_mcp23017 *dev, uint8_t value)
+{
+    uint8_t reg = dev->pointer;
+    if (reg < SIM_17_COUNT) {
+        if (reg == SIM_17_IOCONA || reg == SIM_17_IOCONB) {
+            // One register at two addresses
+            dev->regs[SIM_17_IOCONA] = dev->regs[SIM_17_IOCONB] = value;
+        } else if (reg == SIM_17_GPIOA || reg == SIM_17_GPIOA + 1) {
+            dev->regs[SIM_17_OLATA + (reg & 1)] = value;
+        } else {
+            dev->regs[reg] = value;
+        }
+        dev->port.out = dev->regs[SIM_17_OLATA] | (dev->regs[SIM_17_OLATA + 1] << 8);
+        dev->port.released = dev->regs[SIM_17_IODIRA] | (dev->regs[SIM_17_IODIRA + 1] << 8);
+        sim_update(&dev->port);
+    }
+    sim_step17(dev);
+}
+
+static uint8_t sim_readRegister17(sim_mcp23017 *dev)
+{
+    uint8_t reg = dev->pointer;
+    uint8_t value = 0;
+    if (reg == SIM_17_GPIOA || reg == SIM_17_GPIOA + 1) {
+        value = (uint8_t)(sim_pins(&dev->port) >> (8 * (reg & 1)));
+    } else if (reg < SIM_17_COUNT) {
+        value = dev->regs[reg];
+    }
+    sim_step17(dev);
+    return value;
+}
+
+/******************************************************************************
+ * PCF8574, 74HC595 and GPIO port models
+ ******************************************************************************/
+sim_pcf8574 *sim_attach_pcf8574(I2C_HandleTypeDef *hi2c, uint8_t addr, const sim_wiring *wiring,
+                                hd44780_sim *lcd)
+{
+    if (sim_pcf_count >= SIM_MAX_DEVICES) return NULL;
+    sim_pcf8574 *dev = &sim_pcfs[sim_pcf_count++];
+    memset(dev, 0, sizeof(*dev));
+    dev->hi2c = hi2c;
+    dev->addr = addr;
+    sim_portInit(&dev->port, wiring, lcd);
+    // Power-on: every pin written high, i.e. released with the weak pull-up
+    dev->port.out = 0xFF;
+    dev->port.released = 0xFF;
+    dev->port.pullup = true;
+    return dev;
+}
+
+static sim_pcf8574 *sim_findPcf(I2C_HandleTypeDef *hi2c, uint16_t dev_address)
+{
+    for (int i = 0; i < sim_pcf_count; i++) {
+        if (sim_pcfs[i].hi2c == hi2c && sim_pcfs[i].addr == (dev_address >> 1)) {
+            return &sim_pcfs[i];
+        }
+    }
+    return NULL;
+}
+
+sim_hc595 *sim_attach_hc595(SPI_HandleTypeDef *hspi, GPIO_TypeDef *latch_port, uint16_t latch_pin,
+                            const sim_wiring *wiring, hd44780_sim *lcd)
+{
+    if (sim_hc595_count >= SIM_MAX_DEVICES) return NULL;
+    sim_hc595 *dev = &sim_hc595s[sim_hc595_count++];
+    memset(dev, 0, sizeof(*dev));
+    dev->hspi = hspi;
+    dev->latch_port = latch_port;
+    dev->latch_pin = latch_pin;
+    sim_portInit(&dev->port, wiring, lcd);
+    return dev;
+}
+
+sim_gpio *sim_attach_gpio(GPIO_TypeDef *gpio, const sim_wiring *wiring, hd44780_sim *lcd)
+{
+    if (sim_gpio_count >= SIM_MAX_DEVICES) return NULL;
+    sim_gpio *dev = &sim_gpios[sim_gpio_count++];
+    memset(dev, 0, sizeof(*dev));
+    dev->gpio = gpio;
+    sim_portInit(&dev->port, wiring, lcd);
+    dev->port.released = 0xFF; // reset: inputs
+    return dev;
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+    for (int i = 0; i < sim_gpio_count; i++) {
+        sim_port *port = &sim_gpios[i].port;
+        if (sim_gpios[i].gpio != GPIOx) continue;
+        uint8_t pins = GPIO_Init->Pin & 0xFF;
+        if (GPIO_Init->Mode == GPIO_MODE_INPUT) {
+            port->released |= pins;
+        } else {
+            port->released &= ~pins;
+        }
+        sim_update(port);
+    }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    uint32_t before = GPIOx->ODR;
+
+    sim_time_ns += SIM_GPIO_NS;
+    if (PinState == GPIO_PIN_SET) {
+        GPIOx->ODR |= GPIO_Pin;
+    } else {
+        GPIOx->ODR &= ~(uint32_t)GPIO_Pin;
+    }
+    for (int i = 0; i < sim_hc595_count; i++) {
+        sim_hc595 *dev = &sim_hc595s[i];
+        // The storage register takes the shift register on the rising edge of the latch
+        if (dev->latch_port == GPIOx && (GPIOx->ODR & ~before & dev->latch_pin)) {
+            dev->port.out = dev->shift;
+            sim_update(&dev->port);
+        }
+    }
+    for (int i = 0; i < sim_gpio_count; i++) {
+        if (sim_gpios[i].gpio == GPIOx && ((GPIOx->ODR ^ before) & 0xFF)) {
+            sim_gpios[i].port.out = GPIOx->ODR & 0xFF;
+            sim_update(&sim_gpios[i].port);
+        }
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    sim_time_ns += SIM_GPIO_NS;
+    GPIOx->IDR = GPIOx->ODR;
+    for (int i = 0; i < sim_gpio_count; i++) {
+        if (sim_gpios[i].gpio == GPIOx) {
+            GPIOx->IDR = (GPIOx->ODR & ~0xFFU) | sim_pins(&sim_gpios[i].port);
+        }
+    }
+    return (GPIOx->IDR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef *hspi, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+    uint32_t hz = SIM_SPI_PCLK_HZ / (2u << (hspi->Init.BaudRatePrescaler >> 3));
+    uint64_t start = sim_time_ns;
+
+    sim_time_ns += (uint64_t)Size * 8 * 1000000000ULL / hz;
+    for (int i = 0; i < sim_hc595_count; i++) {
+        if (sim_hc595s[i].hspi == hspi && Size > 0) {
+            sim_hc595s[i].shift = pData[Size - 1];
+        }
+    }
+    sim_statistics.transactions++;
+    sim_statistics.writes++;
+    sim_statistics.bytes += Size;
+    sim_statistics.bus_ns += sim_time_ns - start;
+    return HAL_OK;
+}
+
+/******************************************************************************
+ * I2C bus
+ ******************************************************************************/
+static uint64_t sim_bits_ns(I2C_HandleTypeDef *hi2c, uint32_t bits)
+{
+    uint32_t hz = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000;
+    return (uint64_t)bits * 1000000000ULL / hz;
+}
+
+static void sim_transaction(I2C_HandleTypeDef *hi2c, uint64_t start, uint32_t bits, bool write, uint16_t size)
+{
+    sim_time_ns = start + sim_bits_ns(hi2c, bits);
+    sim_statistics.transactions++;
+    sim_statistics.bus_ns += sim_time_ns - start;
+    sim_statistics.bytes += size;
+    if (write) sim_statistics.writes++;
+    else sim_statistics.reads++;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                    uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)MemAddSize;
+    (void)Timeout;
+    uint64_t start = sim_time_ns;
+    sim_mcp23008 *dev = sim_find(hi2c, DevAddress);
+    sim_mcp23017 *dev17 = sim_find17(hi2c, DevAddress);
+
+    if (!dev && !dev17) {
+        // START, address byte, NACK, STOP
+        sim_transaction(hi2c, start, 11, true, 0);
+        sim_statistics.nacks++;
+        return HAL_ERROR;
+    }
+    // START + address + register, then each data byte takes effect on its ACK
+    if (dev) dev->pointer = (uint8_t)MemAddress;
+    else dev17->pointer = (uint8_t)MemAddress;
+    for (uint16_t i = 0; i < Size; i++) {
+        sim_time_ns = start + sim_bits_ns(hi2c, 1 + 9 * (2 + i + 1));
+        if (dev) sim_writeRegister(dev, pData[i]);
+        else sim_writeRegister17(dev17, pData[i]);
+    }
+    sim_transaction(hi2c, start, 20 + 9 * Size, true, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Read(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                   uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+    (void)MemAddSize;
+    (void)Timeout;
+    uint64_t start = sim_time_ns;
+    sim_mcp23008 *dev = sim_find(hi2c, DevAddress);
+    sim_mcp23017 *dev17 = sim_find17(hi2c, DevAddress);
+
+    if (!dev && !dev17) {
+        sim_transaction(hi2c, start, 11, false, 0);
+        sim_statistics.nacks++;
+        return HAL_ERROR;
+    }
+    // START + address + register, repeated START + address, then the data bytes
+    if (dev) dev->pointer = (uint8_t)MemAddress;
+    else dev17->pointer = (uint8_t)MemAddress;
+    for (uint16_t i = 0; i < Size; i++) {
+        sim_time_ns = start + sim_bits_ns(hi2c, 2 + 9 * (3 + i) + 8);
+        pData[i] = dev ? sim_readRegister(dev) : sim_readRegister17(dev17);
+    }
+    sim_transaction(hi2c, start, 30 + 9 * Size, false, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+                                          uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+    uint64_t start = sim_time_ns;
+    sim_pcf8574 *dev = sim_findPcf(hi2c, DevAddress);
+
+    if (!dev) {
+        sim_transaction(hi2c, start, 11, true, 0);
+        sim_statistics.nacks++;
+        return HAL_ERROR;
+    }
+    // START + address, then each byte becomes the output state on its ACK
+    for (uint16_t i = 0; i < Size; i++) {
+        sim_time_ns = start + sim_bits_ns(hi2c, 1 + 9 * (1 + i + 1));
+        dev->port.out = pData[i];
+        dev->port.released = pData[i];
+        sim_update(&dev->port);
+    }
+    sim_transaction(hi2c, start, 11 + 9 * Size, true, Size);
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Receive(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+                                         uint16_t Size, uint32_t Timeout)
+{
+    (void)Timeout;
+    uint64_t start = sim_time_ns;
+    sim_pcf8574 *dev = sim_findPcf(hi2c, DevAddress);
+
+    if (!dev) {
+        sim_transaction(hi2c, start, 11, false, 0);
+        sim_statistics.nacks++;
+        return HAL_ERROR;
+    }
+    // The pins are sampled at the ACK before each byte
+    for (uint16_t i = 0; i < Size; i++) {
+        sim_time_ns = start + sim_bits_ns(hi2c, 1 + 9 * (1 + i));
+        pData[i] = (uint8_t)sim_pins(&dev->port);
+    }
+    sim_transaction(hi2c, start, 11 + 9 * Size, false, Size);
+    return HAL_OK;
+}
+
+__attribute__((weak)) void HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+                                             uint16_t Size)
+{
+    HAL_StatusTypeDef status = HAL_I2C_Master_Transmit(hi2c, DevAddress, pData, Size, 0);
+    if (status == HAL_OK) {
+        HAL_I2C_MasterTxCpltCallback(hi2c);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData,
+                                              uint16_t Size)
+{
+    return HAL_I2C_Master_Transmit_IT(hi2c, DevAddress, pData, Size);
+}
+
+__attribute__((weak)) void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    (void)hi2c;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_IT(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                       uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+{
+    HAL_StatusTypeDef status = HAL_I2C_Mem_Write(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size, 0);
+    if (status == HAL_OK) {
+        HAL_I2C_MemTxCpltCallback(hi2c);
+    }
+    return status;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress,
+                                        uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+{
+    return HAL_I2C_Mem_Write_IT(hi2c, DevAddress, MemAddress, MemAddSize, pData, Size);
+}
+
+/******************************************************************************
+ * MCP23008 driver stand-in
+ ******************************************************************************/
+void MCP23008_Init(I2C_HandleTypeDef *hi2c, MCP23008_HandleTypeDef *hmcp, uint8_t addr)
+{
+    hmcp->hi2c = hi2c;
+    hmcp->addr = addr;
+}
+
+void MCP23008_SetDirection(MCP23008_HandleTypeDef *hmcp, uint8_t direction)
+{
+    HAL_I2C_Mem_Write(hmcp->hi2c, hmcp->addr << 1, MCP23008_IODIR, I2C_MEMADD_SIZE_8BIT, &direction, 1, 10);
+}
+
+uint8_t MCP23008_ReadGPIO(MCP23008_HandleTypeDef *hmcp)
+{
+    uint8_t value = 0;
+    HAL_I2C_Mem_Read(hmcp->hi2c, hmcp->addr << 1, MCP23008_GPIO, I2C_MEMADD_SIZE_8BIT, &value, 1, 10);
+    return value;
+}
+
+void MCP23008_WriteGPIO(MCP23008_HandleTypeDef *hmcp, uint8_t value)
+{
+    HAL_I2C_Mem_Write(hmcp->hi2c, hmcp->addr << 1, MCP23008_GPIO, I2C_MEMADD_SIZE_8BIT, &value, 1, 10);
+}
@@ -0,0 +1,126 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stm32f4xx_hal.h"
+#include "hd44780_sim.h"
+
+/******************************************************************************
+ * Simulated I2C bus and MCP23008/MCP23017 port expanders
+ *
+ * Time is virtual and kept in nanoseconds. Every transaction advances it by
+ * its length on the wire (START/STOP plus 9 bits per byte at the handle's
+ * ClockSpeed), and the expander outputs change at the ACK of each byte, so a
+ * burst of GPIO values reaches the HD44780 model with the real spacing.
+ *
+ * The other transports are modelled the same way: a PCF8574 on I2C, a
+ * 74HC595 on SPI (outputs change on the rising edge of its latch pin) and
+ * the low 8 pins of a GPIO port. A GPIO pin write takes SIM_GPIO_NS.
+ ******************************************************************************/
+#define SIM_MAX_DEVICES 4
+#define SIM_NC (-1) // line not connected to the expander
+#define SIM_GPIO_NS 20
+#define SIM_NOP_NS  24 // one turn of a __NOP() loop, about 4 cycles at 168 MHz
+#define SIM_SPI_PCLK_HZ 84000000
+
+// Which expander pin drives which HD44780 line
+typedef struct {
+    int rs;
+    int rw;       // SIM_NC when RW is tied to ground
+    int en;
+    int en2;      // enable of a second controller (40x4 modules), SIM_NC if there is none
+    int backlight;
+    int d[8];     // D0..D7; a 4-bit wiring leaves D0..D3 at SIM_NC
+} sim_wiring;
+
+// Adafruit I2C/SPI character LCD backpack: RS=GP1, EN=GP2, D4..D7=GP3..GP6, BL=GP7
+extern const sim_wiring sim_wiring_adafruit;
+// Common PCF8574 backpack: RS=P0, RW=P1, EN=P2, BL=P3, D4..D7=P4..P7
+extern const sim_wiring sim_wiring_pcf8574;
+// MCP23017 in 8-bit mode: D0..D7=GPA0..GPA7, RS=GPB0, RW=GPB1, EN=GPB2, BL=GPB3
+extern const sim_wiring sim_wiring_mcp23017;
+
+// Pins of a simulated device and the HD44780 lines they are wired to
+typedef struct {
+    sim_wiring wiring;
+    hd44780_sim *lcd;
+    hd44780_sim *lcd2; // controller on wiring.en2, set after attaching
+    uint16_t out;      // output latch
+    uint16_t released; // pins not driven: inputs, or PCF8574 pins written high
+    bool pullup;       // released pins are pulled high (PCF8574) rather than left floating
+    bool backlight;
+} sim_port;
+
+typedef struct {
+    uint32_t transactions;
+    uint32_t writes;
+    uint32_t reads;
+    uint32_t bytes;      // payload bytes, register address excluded
+    uint32_t nacks;      // transactions to an address with no device
+    uint64_t bus_ns;     // time the bus was busy
+    uint64_t delay_ns;   // time spent in HAL_Delay(), __NOP() loops and the simulated microsecond clock
+} sim_stats;
+
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t addr;
+    uint8_t regs[11];    // IODIR .. OLAT
+    uint8_t pointer;     // register address pointer
+    sim_port port;
+} sim_mcp23008;
+
+// IOCON.BANK = 0 register layout: A/B pairs, GPIOA at 0x12
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t addr;
+    uint8_t regs[22];    // IODIRA .. OLATB
+    uint8_t pointer;
+    sim_port port;       // pins 0..7 are GPA0..GPA7, 8..15 GPB0..GPB7
+} sim_mcp23017;
+
+typedef struct {
+    I2C_HandleTypeDef *hi2c;
+    uint8_t addr;
+    sim_port port;
+} sim_pcf8574;
+
+typedef struct {
+    SPI_HandleTypeDef *hspi;
+    GPIO_TypeDef *latch_port;
+    uint16_t latch_pin;
+    uint8_t shift;       // shift register, copied to the outputs by the latch
+    sim_port port;
+} sim_hc595;
+
+typedef struct {
+    GPIO_TypeDef *gpio;  // pins 0..7 of this port
+    sim_port port;
+} sim_gpio;
+
+// Reset time, devices and statistics
+void sim_reset(void);
+uint64_t sim_now_ns(void);
+void sim_advance_ns(uint64_t ns);
+// Put an MCP23008 on the bus at the 7-bit address addr, wired to lcd (may be NULL)
+sim_mcp23008 *sim_attach_mcp23008(I2C_HandleTypeDef *hi2c, uint8_t addr, const sim_wiring *wiring,
+                                  hd44780_sim *lcd);
+sim_mcp23017 *sim_attach_mcp23017(I2C_HandleTypeDef *hi2c, uint8_t addr, const sim_wiring *wiring,
+                                  hd44780_sim *lcd);
+sim_pcf8574 *sim_attach_pcf8574(I2C_HandleTypeDef *hi2c, uint8_t addr, const sim_wiring *wiring,
+                                hd44780_sim *lcd);
+// A 74HC595 clocked from hspi, latched by latch_pin of latch_port
+sim_hc595 *sim_attach_hc595(SPI_HandleTypeDef *hspi, GPIO_TypeDef *latch_port, uint16_t latch_pin,
+                            const sim_wiring *wiring, hd44780_sim *lcd);
+// The LCD on pins 0..7 of a GPIO port (wiring gives port pin numbers)
+sim_gpio *sim_attach_gpio(GPIO_TypeDef *gpio, const sim_wiring *wiring, hd44780_sim *lcd);
+const sim_stats *sim_get_stats(void);
+void sim_reset_stats(void);
+// Called at the start of every HAL_Delay(), e.g. to print the screen at pauses
+void sim_set_delay_hook(void (*hook)(uint32_t ms, void *ctx), void *ctx);
+
+// Microsecond clock for LCD_SetClock(): reads and advances the virtual time
+uint32_t sim_clock_now_us(void *ctx);
+void sim_clock_delay_us(void *ctx, uint32_t us);
+
+#endif
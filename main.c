@@ -19,6 +19,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "MCP23008.h"
 #include "LiquidCrystal_C.h"
+#include "LCD_Demo.h"
 #include "main.h"
 
 /* Private includes ----------------------------------------------------------*/
@@ -104,74 +105,8 @@ int main(void)
   LCD_Begin(&lcd, 16, 2, LCD_5x8DOTS); // 16x02 LCD
   LCD_SetBacklight(&lcd, true); // turn on backlight
 
-  // Test 1: Write test
-  LCD_Clear(&lcd);
-  LCD_SetCursor(&lcd, 0, 0);
-  LCD_WriteString(&lcd, "Hello world!");
-  LCD_SetCursor(&lcd, 0, 1);
-  LCD_WriteString(&lcd, "Test 1 success!");
-  HAL_Delay(2000);
-
-  // Test 2: Cursor and blink control
-  LCD_Clear(&lcd);
-  LCD_WriteString(&lcd, "Cursor Test");
-  LCD_SetCursor(&lcd, 0, 1);
-  LCD_Cursor(&lcd); // Show cursor
-  HAL_Delay(2000);
-  LCD_Blink(&lcd); // Blink cursor
-  HAL_Delay(2000);
-  LCD_NoBlink(&lcd); // Stop blinking
-  HAL_Delay(1000);
-  LCD_NoCursor(&lcd); // Hide cursor
-  HAL_Delay(1000);
-  LCD_WriteString(&lcd, "Test 2 success!");
-  HAL_Delay(2000);
-
-  // Test 3: Scrolling
-  LCD_Clear(&lcd);
-  LCD_WriteString(&lcd, "Scrolling test");
-  LCD_SetCursor(&lcd, 0, 1);
-  HAL_Delay(1000);
-  for (int i=0; i<16; i++){
-	  LCD_ScrollDisplayLeft(&lcd);
-	  HAL_Delay(300);
-  }
-  for (int i=0; i<16; i++){
-	  LCD_ScrollDisplayRight(&lcd);
-	  HAL_Delay(300);
-  }
-  LCD_WriteString(&lcd, "Test 3 success!");
-
-  // Test 4: Custom character
-  uint8_t smiley[8] = {
-          0x00, //  .....
-          0x0A, //  .#.#.
-          0x0A, //  .#.#.
-          0x00, //  .....
-          0x11, //  #...#
-          0x0E, //  .###.
-          0x00, //  .....
-          0x00  //  .....
-  };
-  LCD_CreateChar(&lcd, 0, smiley); // Store smiley in CGRAM slot 0
-  LCD_Clear(&lcd);
-  LCD_WriteString(&lcd, "Custom char test");
-  LCD_SetCursor(&lcd, 0, 1);
-  LCD_WriteString(&lcd, "Test 4 success ");
-  LCD_WriteChar(&lcd, 0); // Display the smiley
-  HAL_Delay(2000);
-
-  // Test 5: Backlight toggle
-  LCD_Clear(&lcd);
-  LCD_WriteString(&lcd, "Backlight test");
-  for (int i=0; i<5; i++){
-	  LCD_SetBacklight(&lcd, false); // Backlight off
-	  HAL_Delay(300);
-	  LCD_SetBacklight(&lcd, true); // Backlight on
-	  HAL_Delay(300);
-  }
-  LCD_SetCursor(&lcd, 0, 1);
-  LCD_WriteString(&lcd, "Test 5 success!");
+  // Run the test scenarios (see LCD_Demo.c)
+  LCD_RunDemo(&lcd);
 
   /* USER CODE END 2 */
 